@@ -38,7 +38,7 @@ SIMINCFL        += -I$(intf_dir)/include
 #------------------------------------------------------------------------------
 
 krnl_dir        := carlsim/kernel
-krnl_inc_files  := $(wildcard $(krnl_dir)/include/*.h)
+krnl_inc_files  := $(wildcard $(krnl_dir)/include/*.h) $(wildcard $(krnl_dir)/src/*.inc)
 krnl_cpp_files  := $(wildcard $(krnl_dir)/src/*.cpp)
 krnl_obj_files  := $(patsubst %.cpp, %-cpp.o, $(krnl_cpp_files))
 ifeq ($(CARLSIM3_NO_CUDA),1)
@@ -179,7 +179,7 @@ else
 endif
 
 CARLSIM3_FLG := -I$(CARLSIM3_INC_DIR) -L$(CARLSIM3_LIB_DIR) -Wno-deprecated-gpu-targets
-CARLSIM3_LIB := -l$(SIM_LIB_NAME)
+CARLSIM3_LIB := -l$(SIM_LIB_NAME) -lpthread
 ifeq ($(CARLSIM3_NO_CUDA),1)
 	CARLSIM3_FLG += -D__NO_CUDA__
 else
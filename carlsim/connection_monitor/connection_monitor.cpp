@@ -2,6 +2,7 @@
 #include <connection_monitor_core.h>	// ConnectionMonitor private implementation
 
 #include <user_errors.h>				// fancy user error messages
+#include <snn_definitions.h>			// CONN_FILE_KEYFRAME_INTERVAL
 #include <sstream>						// std::stringstream
 
 
@@ -123,6 +124,25 @@ void ConnectionMonitor::setUpdateTimeIntervalSec(int intervalSec) {
 	connMonCorePtr_->setUpdateTimeIntervalSec(intervalSec);
 }
 
+void ConnectionMonitor::setFileFormat(connFileFormat_t format, int keyframeInterval, double wtResolution) {
+	std::string funcName = "setFileFormat()";
+	UserErrors::assertTrue(!connMonCorePtr_->isFileFormatFixed(), UserErrors::CANNOT_BE_CALLED_IN_STATE,
+		funcName, funcName, "\"snapshots written to file\"");
+	UserErrors::assertTrue(keyframeInterval==-1 || keyframeInterval>=1, UserErrors::MUST_BE_SET_TO, funcName,
+		"keyframeInterval", "-1 or >= 1.");
+	UserErrors::assertTrue(wtResolution==-1.0 || wtResolution>0.0, UserErrors::MUST_BE_SET_TO, funcName,
+		"wtResolution", "-1 or > 0.");
+
+	if (keyframeInterval==-1)
+		keyframeInterval = CONN_FILE_KEYFRAME_INTERVAL;
+
+	connMonCorePtr_->setFileFormat(format, keyframeInterval, (float)wtResolution);
+}
+
+connFileFormat_t ConnectionMonitor::getFileFormat() {
+	return connMonCorePtr_->getFileFormat();
+}
+
 std::vector< std::vector<float> > ConnectionMonitor::takeSnapshot() {
 	return connMonCorePtr_->takeSnapshot();
 }
\ No newline at end of file
@@ -44,6 +44,7 @@
 
 #include <vector>					// std::vector
 #include <carlsim_definitions.h>	// ALL
+#include <carlsim_datastructures.h> // connFileFormat_t
 #include <stdint.h>
 
 class ConnectionMonitorCore; // forward declaration of implementation
@@ -62,6 +63,8 @@ class ConnectionMonitorCore; // forward declaration of implementation
  * Alternatively, the user may suppress creation of the binary file by using file string "null" instead.
  *
  * Periodic storing can be disabled by calling ConnectionMonitor::setUpdateTimeInterval with argument intervalSec=-1.
+ * For long simulations with frequent snapshots, ConnectionMonitor::setFileFormat can switch the binary to a
+ * delta-encoded format, which only stores the weights that changed since the last snapshot.
  *
  * Additionally, during a CARLsim simulation, the ConnectionMonitor object returned by CARLsim::setConnectionMonitor can
  * be queried for connection data. The user may take a snapshot of the weights at any point in time using the method
@@ -480,6 +483,36 @@ class ConnectionMonitor {
 	 */
 	void setUpdateTimeIntervalSec(int intervalSec);
 
+	/*!
+	 * \brief Sets the format of the connect file binary
+	 *
+	 * This function sets the format in which snapshots are written to the connect file (see connFileFormat_t).
+	 * CONN_FILE_FULL (default) writes the weights of all synapses in every snapshot (connect file version 0.4).
+	 * CONN_FILE_DELTA writes the weights of all synapses only in every keyframeInterval-th snapshot (keyframe).
+	 * All other snapshots only contain the synapses whose weight changed since the last snapshot, with the change
+	 * quantized to multiples of wtResolution (connect file version 0.5). Weights in these snapshots are accurate to
+	 * wtResolution/2; quantization errors do not add up over time.
+	 * Both formats can be read by the ConnectionReader of the Offline Analysis Toolbox.
+	 * The function must be called before the first snapshot is written to file, that is, right after
+	 * CARLsim::setConnectionMonitor and before the next call to CARLsim::runNetwork or ConnectionMonitor::takeSnapshot.
+	 *
+	 * \param[in] format            the connect file format
+	 * \param[in] keyframeInterval  number of snapshots between two keyframes (delta-encoded format). Set to -1 to
+	 *                              use the default (every 60 snapshots).
+	 * \param[in] wtResolution      resolution of weight changes (delta-encoded format). Set to -1 to use the
+	 *                              default (1e-4 times the max weight of the connection).
+	 * \since v3.1
+	 */
+	void setFileFormat(connFileFormat_t format, int keyframeInterval=-1, double wtResolution=-1.0);
+
+	/*!
+	 * \brief Returns the format of the connect file binary
+	 *
+	 * This function returns the format in which snapshots are written to the connect file (see setFileFormat).
+	 * \since v3.1
+	 */
+	connFileFormat_t getFileFormat();
+
 	/*!
 	 * \brief Takes a snapshot of the current weight state
 	 *
@@ -7,9 +7,9 @@
 #include <algorithm>			// std::sort
 #include <iomanip>				// std::setfill, std::setw
 #include <float.h>				// FLT_EPSILON
-
-
-
+#include <math.h>				// floor
+#include <string.h>				// memcpy
+#include <varint.h>				// encodeVarint, zigZagEncode
 
 // we aren't using namespace std so pay attention!
 ConnectionMonitorCore::ConnectionMonitorCore(CpuSNN* snn,int monitorId,short int connId,int grpIdPre,int grpIdPost) {
@@ -27,12 +27,16 @@ ConnectionMonitorCore::ConnectionMonitorCore(CpuSNN* snn,int monitorId,short int
 	needToWriteFileHeader_ = true;
 	needToInit_ = true;
 	connFileSignature_ = 202029319;
-	connFileVersion_ = 0.3f;
+	connFileVersion_ = 0.4f;
 
 	minWt_ = -1.0f;
 	maxWt_ = -1.0f;
 
 	connFileTimeIntervalSec_ = 1;
+	connFileFormat_ = CONN_FILE_FULL;
+	keyframeInterval_ = CONN_FILE_KEYFRAME_INTERVAL;
+	wtResolution_ = -1.0f; // set in init, relative to maxWt
+	numFramesSinceKeyframe_ = 0;
 }
 
 void ConnectionMonitorCore::init() {
@@ -42,11 +46,12 @@ void ConnectionMonitorCore::init() {
 	nNeurPre_  = snn_->getGroupNumNeurons(grpIdPre_);
 	nNeurPost_ = snn_->getGroupNumNeurons(grpIdPost_);
 	isPlastic_ = snn_->isConnectionPlastic(connId_);
-	nSynapses_ = snn_->getNumSynapticConnections(connId_);
 
 	grpConnectInfo_t* connInfo = snn_->getConnectInfo(connId_);
 	minWt_ = 0.0f; // for now, no non-zero min weights allowed
 	maxWt_ = fabs(connInfo->maxWt);
+	if (wtResolution_<=0.0f)
+		wtResolution_ = (maxWt_>0.0f ? maxWt_ : 1.0f) * CONN_FILE_WEIGHT_RESOLUTION;
 
 	assert(nNeurPre_>0);
 	assert(nNeurPost_>0);
@@ -57,18 +62,18 @@ void ConnectionMonitorCore::init() {
 	fpDeb_ = snn_->getLogFpDeb();
 	fpLog_ = snn_->getLogFpLog();
 
-	// init weight matrix with right dimensions
-	for (int i = 0; i < nNeurPre_; i++) {
-		std::vector<float> wt;
-		for (int j = 0; j < nNeurPost_; j++) {
-			wt.push_back(NAN);
-		}
-		wtMat_.push_back(wt);
-		wtMatLast_.push_back(wt);
-	}
+	// the synapses of a connection don't change after setupNetwork, so the CSR structure is fetched only once
+	snn_->getConnectionSynapses(connId_, synPtr_, preIds_);
+	nSynapses_ = preIds_.size();
+	fanOut_.assign(nNeurPre_, 0);
+	for (int s=0; s<nSynapses_; s++)
+		fanOut_[preIds_[s]]++;
 
-	// then load current weigths from CpuSNN into weight matrix
+	// then load current weigths from CpuSNN (there is no last snapshot yet)
+	wts_.assign(nSynapses_, NAN);
 	updateStoredWeights();
+
+	needToInit_ = false;
 }
 
 ConnectionMonitorCore::~ConnectionMonitorCore() {
@@ -77,9 +82,12 @@ ConnectionMonitorCore::~ConnectionMonitorCore() {
 		if (connFileTimeIntervalSec_ > 0) {
 			// make sure CpuSNN is not already deallocated!
 			assert(snn_!=NULL);
-			writeConnectFileSnapshot(snn_->getSimTime(), snn_->getWeightMatrix2D(connId_));
+			writeConnectFileSnapshot(snn_->getSimTime());
 		}
 
+		// a file without snapshots still gets its header
+		writeConnectFileHeader();
+
 		// then close file and clean up
 		fclose(connFileId_);
 		connFileId_ = NULL;
@@ -93,12 +101,11 @@ ConnectionMonitorCore::~ConnectionMonitorCore() {
 // calculate weight changes since last update (element-wise )
 std::vector< std::vector<float> > ConnectionMonitorCore::calcWeightChanges() {
 	updateStoredWeights();
-	std::vector< std::vector<float> > wtChange(nNeurPre_, vector<float>(nNeurPost_));
+	std::vector< std::vector<float> > wtChange(nNeurPre_, std::vector<float>(nNeurPost_, NAN));
 
-	// take the naive approach for now
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			wtChange[i][j] = wtMat_[i][j] - wtMatLast_[i][j];
+	for (int j=0; j<nNeurPost_; j++) {
+		for (int s=synPtr_[j]; s<synPtr_[j+1]; s++) {
+			wtChange[preIds_[s]][j] = wts_[s] - wtsLast_[s];
 		}
 	}
 
@@ -106,38 +113,22 @@ std::vector< std::vector<float> > ConnectionMonitorCore::calcWeightChanges() {
 }
 
 
-// reset weight matrix
+// reset weights
 void ConnectionMonitorCore::clear() {
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			wtMat_[i][j] = NAN;
-			wtMatLast_[i][j] = NAN;
-		}
-	}
+	std::fill(wts_.begin(), wts_.end(), NAN);
+	std::fill(wtsLast_.begin(), wtsLast_.end(), NAN);
 }
 
 // find number of incoming synapses for a specific post neuron
 int ConnectionMonitorCore::getFanIn(int neurPostId) {
 	assert(neurPostId<nNeurPost_);
-	int nSyn = 0;
-	for (int i=0; i<nNeurPre_; i++) {
-		if (!isnan(wtMat_[i][neurPostId])) {
-			nSyn++;
-		}
-	}
-	return nSyn;
+	return synPtr_[neurPostId+1] - synPtr_[neurPostId];
 }
 
 // find number of outgoing synapses of a specific pre neuron
 int ConnectionMonitorCore::getFanOut(int neurPreId) {
 	assert(neurPreId<nNeurPre_);
-	int nSyn = 0;
-	for (int j=0; j<nNeurPost_; j++) {
-		if (!isnan(wtMat_[neurPreId][j])) {
-			nSyn++;
-		}
-	}
-	return nSyn;
+	return fanOut_[neurPreId];
 }
 
 float ConnectionMonitorCore::getMaxWeight(bool getCurrent) {
@@ -146,15 +137,9 @@ float ConnectionMonitorCore::getMaxWeight(bool getCurrent) {
 		updateStoredWeights();
 
 		// find currently largest weight value
-		for (int i=0; i<nNeurPre_; i++) {
-			for (int j=0; j<nNeurPost_; j++) {
-				// skip entries in matrix where no synapse exists
-				if (isnan(wtMat_[i][j]))
-					continue;
-
-				if (wtMat_[i][j] > maxVal) {
-					maxVal = wtMat_[i][j];
-				}
+		for (int s=0; s<nSynapses_; s++) {
+			if (wts_[s] > maxVal) {
+				maxVal = wts_[s];
 			}
 		}
 	} else {
@@ -170,20 +155,14 @@ float ConnectionMonitorCore::getMinWeight(bool getCurrent) {
 	if (getCurrent) {
 		updateStoredWeights();
 
-		// find currently largest weight value
-		for (int i=0; i<nNeurPre_; i++) {
-			for (int j=0; j<nNeurPost_; j++) {
-				// skip entries in matrix where no synapse exists
-				if (isnan(wtMat_[i][j]))
-					continue;
-
-				if (wtMat_[i][j] < minVal) {
-					minVal = wtMat_[i][j];
-				}
+		// find currently smallest weight value
+		for (int s=0; s<nSynapses_; s++) {
+			if (wts_[s] < minVal) {
+				minVal = wts_[s];
 			}
 		}
 	} else {
-		// return RangeWeight.max
+		// return RangeWeight.min
 		minVal = minWt_;
 	}
 
@@ -193,18 +172,13 @@ float ConnectionMonitorCore::getMinWeight(bool getCurrent) {
 // find number of synapses whose weights changed
 int ConnectionMonitorCore::getNumWeightsChanged(double minAbsChange) {
 	assert(minAbsChange>=0.0);
-	std::vector< std::vector<float> > wtChange = calcWeightChanges();
+	updateStoredWeights();
 
 	int nChanged = 0;
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			// skip entries in matrix where no synapse exists
-			if (isnan(wtMat_[i][j]))
-				continue;
-
-			if (fabs(wtChange[i][j]) >= minAbsChange) {
-				nChanged++;
-			}
+	for (int s=0; s<nSynapses_; s++) {
+		// comparisons with NAN are false, so synapses without a last snapshot are not counted
+		if (fabs(wts_[s] - wtsLast_[s]) >= minAbsChange) {
+			nChanged++;
 		}
 	}
 	return nChanged;
@@ -222,15 +196,9 @@ int ConnectionMonitorCore::getNumWeightsInRange(double minVal, double maxVal) {
 	}
 
 	int cnt = 0;
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			// skip entries in matrix where no synapse exists
-			if (isnan(wtMat_[i][j]))
-				continue;
-
-			if (wtMat_[i][j]>=minVal && wtMat_[i][j]<=maxVal) {
-				cnt++;
-			}
+	for (int s=0; s<nSynapses_; s++) {
+		if (wts_[s]>=minVal && wts_[s]<=maxVal) {
+			cnt++;
 		}
 	}
 
@@ -249,21 +217,18 @@ int ConnectionMonitorCore::getNumWeightsWithValue(double value) {
 
 // calculate total absolute amount of weight change
 double ConnectionMonitorCore::getTotalAbsWeightChange() {
-	std::vector< std::vector<float> > wtChange = calcWeightChanges();
+	updateStoredWeights();
+
 	double wtTotalChange = 0.0;
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			// skip entries in matrix where no synapse exists
-			if (isnan(wtMat_[i][j]))
-				continue;
-			wtTotalChange += fabs(wtChange[i][j]);
-		}
+	for (int s=0; s<nSynapses_; s++) {
+		wtTotalChange += fabs(wts_[s] - wtsLast_[s]);
 	}
 	return wtTotalChange;
 }
 
 void ConnectionMonitorCore::print() {
 	updateStoredWeights();
+	std::vector< std::vector<float> > wtMat = getWeightMatrix2D(wts_);
 
 	KERNEL_INFO("(t=%.3fs) ConnectionMonitor ID=%d: %d(%s) => %d(%s)",
 		(getTimeMsCurrentSnapshot()/1000.0f), connId_,
@@ -285,8 +250,8 @@ void ConnectionMonitorCore::print() {
 		std::stringstream line;
 		line << std::setw(9) << std::setfill(' ') << i << " |";
 		for (int j=0; j<nNeurPost_; j++) {
-			line << std::fixed << std::setprecision(4) << (isnan(wtMat_[i][j])?"      ":(wtMat_[i][j]>=0?"   ":"  "))
-				<< wtMat_[i][j]  << "  ";
+			line << std::fixed << std::setprecision(4) << (isnan(wtMat[i][j])?"      ":(wtMat[i][j]>=0?"   ":"  "))
+				<< wtMat[i][j]  << "  ";
 		}
 		KERNEL_INFO("%s",line.str().c_str());
 	}
@@ -298,12 +263,12 @@ void ConnectionMonitorCore::printSparse(int neurPostId, int maxConn, int connPer
 	assert(connPerLine>0);
 
 	// give the option of not storing the new snapshot
-	std::vector< std::vector<float> > wtNew, wtOld;
+	std::vector<float> wtsNew, wtsOld;
 	int64_t timeNew, timeOld;
 	if (!storeNewSnapshot) {
 		// make a copy of current snapshots so that we can restore them later
-		wtNew = wtMat_;
-		wtOld = wtMatLast_;
+		wtsNew = wts_;
+		wtsOld = wtsLast_;
 		timeNew = wtTime_;
 		timeOld = wtTimeLast_;
 	}
@@ -320,35 +285,30 @@ void ConnectionMonitorCore::printSparse(int neurPostId, int maxConn, int connPer
 		postZ = nNeurPost_;
 	} else {
 		postA = neurPostId;
-		postZ = neurPostId;
-	}
-
-	std::vector< std::vector<float> > wtChange;
-	if (isPlastic_) {
-		wtChange = calcWeightChanges();
+		postZ = neurPostId+1;
 	}
 
+	// synapses are listed per post-synaptic neuron, in the order in which they are stored
 	std::stringstream line;
 	int nConn = 0;
 	int maxIntDigits = ceil(log10((double)fmax(nNeurPre_,nNeurPost_)));
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=postA; j<postZ; j++) {
+	for (int j=postA; j<postZ && nConn<maxConn; j++) {
+		for (int s=synPtr_[j]; s<synPtr_[j+1]; s++) {
 			// display only so many connections
 			if (nConn>=maxConn)
 				break;
 
-			if (!isnan(wtMat_[i][j])) {
-				line << "[" << std::setw(maxIntDigits) << i << "," << std::setw(maxIntDigits) << j << "] "
-					<< std::fixed << std::setprecision(4) << wtMat_[i][j];
-				if (isPlastic_) {
-					line << " (" << ((wtChange[i][j]<0)?"":"+");
-					line << std::setprecision(4) << wtChange[i][j] << ")";
-				}
-				line << "   ";
-				if (!(++nConn % connPerLine)) {
-					KERNEL_INFO("%s",line.str().c_str());
-					line.str(std::string());
-				}
+			line << "[" << std::setw(maxIntDigits) << preIds_[s] << "," << std::setw(maxIntDigits) << j << "] "
+				<< std::fixed << std::setprecision(4) << wts_[s];
+			if (isPlastic_) {
+				float wtChange = wts_[s] - wtsLast_[s];
+				line << " (" << ((wtChange<0)?"":"+");
+				line << std::setprecision(4) << wtChange << ")";
+			}
+			line << "   ";
+			if (!(++nConn % connPerLine)) {
+				KERNEL_INFO("%s",line.str().c_str());
+				line.str(std::string());
 			}
 		}
 	}
@@ -357,8 +317,8 @@ void ConnectionMonitorCore::printSparse(int neurPostId, int maxConn, int connPer
 		KERNEL_INFO("%s",line.str().c_str());
 
 	if (!storeNewSnapshot) {
-		wtMat_ = wtNew;
-		wtMatLast_ = wtOld;
+		wts_.swap(wtsNew);
+		wtsLast_.swap(wtsOld);
 		wtTime_ = timeNew;
 		wtTimeLast_ = timeOld;
 	}
@@ -372,14 +332,22 @@ void ConnectionMonitorCore::setConnectFileId(FILE* connFileId) {
 
 	connFileId_=connFileId;
 
-	if (connFileId_==NULL) {
-		needToWriteFileHeader_ = false;
-	}
-	else {
-		// for now: file pointer has changed, so we need to write header (again)
-		needToWriteFileHeader_ = true;
-		writeConnectFileHeader();
-	}
+	// file pointer has changed, so we need to write header (again)
+	// the header is written together with the first snapshot, so that the file format can still be changed
+	needToWriteFileHeader_ = (connFileId_!=NULL);
+}
+
+void ConnectionMonitorCore::setFileFormat(connFileFormat_t format, int keyframeInterval, float wtResolution) {
+	assert(!isFileFormatFixed());
+	assert(keyframeInterval>=1);
+
+	connFileFormat_ = format;
+	connFileVersion_ = (format==CONN_FILE_DELTA) ? 0.5f : 0.4f;
+	keyframeInterval_ = keyframeInterval;
+	if (wtResolution>0.0f)
+		wtResolution_ = wtResolution;
+	else
+		wtResolution_ = (maxWt_>0.0f ? maxWt_ : 1.0f) * CONN_FILE_WEIGHT_RESOLUTION;
 }
 
 void ConnectionMonitorCore::setUpdateTimeIntervalSec(int intervalSec) {
@@ -391,10 +359,11 @@ void ConnectionMonitorCore::setUpdateTimeIntervalSec(int intervalSec) {
 void ConnectionMonitorCore::updateStoredWeights() {
 	if (snn_->getSimTime() > wtTime_) {
 		// time has advanced: get new weights
-		wtMatLast_ = wtMat_;
+		// the current snapshot becomes the last one; its memory is reused for the new snapshot
+		wts_.swap(wtsLast_);
 		wtTimeLast_ = wtTime_;
 
-		wtMat_ = snn_->getWeightMatrix2D(connId_);
+		snn_->getConnectionWeights(connId_, wts_);
 		wtTime_ = snn_->getSimTime();
 	}
 }
@@ -402,8 +371,19 @@ void ConnectionMonitorCore::updateStoredWeights() {
 // returns a current snapshot
 std::vector< std::vector<float> > ConnectionMonitorCore::takeSnapshot() {
 	updateStoredWeights();
-	writeConnectFileSnapshot(wtTime_, wtMat_);
-	return wtMat_;
+	writeConnectFileSnapshot(wtTime_, wts_);
+	return getWeightMatrix2D(wts_);
+}
+
+// expands weights in CSR order to a 2D matrix (non-existent synapses: NAN)
+std::vector< std::vector<float> > ConnectionMonitorCore::getWeightMatrix2D(const std::vector<float>& wts) {
+	std::vector< std::vector<float> > wtMat(nNeurPre_, std::vector<float>(nNeurPost_, NAN));
+	for (int j=0; j<nNeurPost_; j++) {
+		for (int s=synPtr_[j]; s<synPtr_[j+1]; s++) {
+			wtMat[preIds_[s]][j] = wts[s];
+		}
+	}
+	return wtMat;
 }
 
 // write the header section of the spike file
@@ -411,7 +391,7 @@ std::vector< std::vector<float> > ConnectionMonitorCore::takeSnapshot() {
 void ConnectionMonitorCore::writeConnectFileHeader() {
 	init();
 
-	if (!needToWriteFileHeader_)
+	if (!needToWriteFileHeader_ || connFileId_==NULL)
 		return;
 
 	// write file signature
@@ -462,30 +442,106 @@ void ConnectionMonitorCore::writeConnectFileHeader() {
 	if (!fwrite(&maxWt_,sizeof(float),1,connFileId_))
 		KERNEL_ERROR("ConnectionMonitorCore: writeConnectFileHeader has fwrite error");
 
+	// write the synapses in CSR layout (version 0.4): nNeurPost+1 row pointers, followed by the pre-synaptic neuron
+	// ID of every synapse; every snapshot then only contains the weights of the existing synapses in this order
+	if (fwrite(&synPtr_[0],sizeof(int),nNeurPost_+1,connFileId_)!=(size_t)(nNeurPost_+1))
+		KERNEL_ERROR("ConnectionMonitorCore: writeConnectFileHeader has fwrite error");
+	if (nSynapses_>0 && fwrite(&preIds_[0],sizeof(int),nSynapses_,connFileId_)!=(size_t)nSynapses_)
+		KERNEL_ERROR("ConnectionMonitorCore: writeConnectFileHeader has fwrite error");
+
+	// write keyframe interval and weight resolution (version 0.5, delta-encoded format only)
+	if (connFileFormat_==CONN_FILE_DELTA) {
+		if (!fwrite(&keyframeInterval_,sizeof(int),1,connFileId_))
+			KERNEL_ERROR("ConnectionMonitorCore: writeConnectFileHeader has fwrite error");
+		if (!fwrite(&wtResolution_,sizeof(float),1,connFileId_))
+			KERNEL_ERROR("ConnectionMonitorCore: writeConnectFileHeader has fwrite error");
+	}
+
 
 	// \TODO: write delays
 
 	needToWriteFileHeader_ = false;
 }
 
-void ConnectionMonitorCore::writeConnectFileSnapshot(unsigned int simTimeMs, std::vector< std::vector<float> > wts) {
-	// don't write if we have already written this timestamp to file (or file doesn't exist)
+void ConnectionMonitorCore::writeConnectFileSnapshot(unsigned int simTimeMs) {
+	// don't fetch weights if we have already written this timestamp to file (or file doesn't exist)
 	if ((int64_t)simTimeMs <= wtTimeWrite_ || connFileId_==NULL) {
 		return;
 	}
 
-	wtTimeWrite_ = (int64_t)simTimeMs;
+	// the stored snapshots are not affected by periodic writing
+	snn_->getConnectionWeights(connId_, wtsWrite_);
+	writeConnectFileSnapshot((int64_t)simTimeMs, wtsWrite_);
+}
+
+void ConnectionMonitorCore::writeConnectFileSnapshot(int64_t simTimeMs, const std::vector<float>& wts) {
+	// don't write if we have already written this timestamp to file (or file doesn't exist)
+	if (simTimeMs <= wtTimeWrite_ || connFileId_==NULL) {
+		return;
+	}
+
+	wtTimeWrite_ = simTimeMs;
+	writeConnectFileHeader();
+
+	if (connFileFormat_==CONN_FILE_DELTA) {
+		// the whole snapshot is encoded first, and then written at once
+		encodeDeltaFrame(simTimeMs, wts);
+		if (fwrite(&frameBuf_[0],1,frameBuf_.size(),connFileId_)!=frameBuf_.size())
+			KERNEL_ERROR("ConnectionMonitor: writeConnectFileSnapshot has fwrite error");
+		return;
+	}
 
 	// write time stamp
 	if (!fwrite(&wtTimeWrite_,sizeof(int64_t),1,connFileId_))
 		KERNEL_ERROR("ConnectionMonitor: writeConnectFileSnapshot has fwrite error");
 
-	// write all weights
-	for (int i=0; i<nNeurPre_; i++) {
-		for (int j=0; j<nNeurPost_; j++) {
-			if (!fwrite(&wts[i][j],sizeof(float),1,connFileId_)) {
-				KERNEL_ERROR("ConnectionMonitor: writeConnectFileSnapshot has fwrite error");
-			}
+	// write the weights of all existing synapses
+	if (nSynapses_>0 && fwrite(&wts[0],sizeof(float),nSynapses_,connFileId_)!=(size_t)nSynapses_)
+		KERNEL_ERROR("ConnectionMonitor: writeConnectFileSnapshot has fwrite error");
+}
+
+// a frame consists of the time stamp (int64), the frame type (uint8: 0=keyframe, 1=delta frame), and the size of the
+// payload in bytes (int32), so that readers can skip frames without decoding them
+// keyframe payload: the weights of all synapses (float32)
+// delta frame payload: for every synapse whose weight changed by at least wtResolution/2, the index gap to the
+// previous such synapse (starting at -1) and the zig-zag encoded weight change in units of wtResolution, both as varint
+// the weight changes are taken relative to the weights the reader reconstructs, so quantization errors don't add up
+void ConnectionMonitorCore::encodeDeltaFrame(int64_t simTimeMs, const std::vector<float>& wts) {
+	bool isKeyframe = wtsFileRef_.empty() || numFramesSinceKeyframe_>=keyframeInterval_;
+	unsigned char frameType = isKeyframe ? 0 : 1;
+
+	frameBuf_.resize(sizeof(int64_t)+sizeof(unsigned char)+sizeof(int));
+	memcpy(&frameBuf_[0], &simTimeMs, sizeof(int64_t));
+	frameBuf_[sizeof(int64_t)] = frameType;
+	size_t headerSize = frameBuf_.size();
+
+	if (isKeyframe) {
+		frameBuf_.resize(headerSize + nSynapses_*sizeof(float));
+		if (nSynapses_>0)
+			memcpy(&frameBuf_[headerSize], &wts[0], nSynapses_*sizeof(float));
+		wtsFileRef_ = wts;
+		numFramesSinceKeyframe_ = 1;
+	} else {
+		int lastIdx = -1;
+		for (int s=0; s<nSynapses_; s++) {
+			float dq = (wts[s]-wtsFileRef_[s])/wtResolution_;
+
+			// comparisons with NAN are false, so unknown weights are skipped as well
+			if (!(fabs(dq)>=0.5f))
+				continue;
+
+			int32_t q = (int32_t)floor(dq+0.5f);
+			size_t pos = frameBuf_.size();
+			frameBuf_.resize(pos + 2*MAX_VARINT_BYTES);
+			pos += encodeVarint(&frameBuf_[pos], (uint32_t)(s-lastIdx));
+			pos += encodeVarint(&frameBuf_[pos], zigZagEncode(q));
+			frameBuf_.resize(pos);
+			wtsFileRef_[s] += q*wtResolution_;
+			lastIdx = s;
 		}
+		numFramesSinceKeyframe_++;
 	}
+
+	int payloadSize = frameBuf_.size() - headerSize;
+	memcpy(&frameBuf_[sizeof(int64_t)+sizeof(unsigned char)], &payloadSize, sizeof(int));
 }
@@ -46,6 +46,7 @@
 #include <stdint.h>					// int64_t
 #include <vector>					// std::vector
 #include <carlsim_definitions.h>	// ALL
+#include <carlsim_datastructures.h>	// connFileFormat_t
 
 class CpuSNN; // forward declaration of CpuSNN class
 
@@ -79,6 +80,15 @@ public:
 	//! returns pointer to connection file
 	FILE* getConnectFileId() { return connFileId_; }
 
+	//! returns the format of the connect file
+	connFileFormat_t getFileFormat() { return connFileFormat_; }
+
+	//! returns the number of snapshots between two keyframes (delta-encoded format)
+	int getKeyframeInterval() { return keyframeInterval_; }
+
+	//! returns the resolution of weight changes (delta-encoded format)
+	float getWeightResolution() { return wtResolution_; }
+
 	//! returns number of incoming synapses to post-synaptic neuron
 	int getFanIn(int neurPostId);
 
@@ -142,7 +152,7 @@ public:
 
 	// +++++ PUBLIC METHODS THAT SHOULD NOT BE EXPOSED TO INTERFACE +++++++++//
 
-	//! deletes data from the 2D weight matrix
+	//! deletes the weight data of both snapshots
 	void clear();
 
 	//! initialization method
@@ -161,10 +171,26 @@ public:
 	//! sets time update interval (seconds) for periodically storing weights to file
 	void setUpdateTimeIntervalSec(int intervalSec);
 
-	//! writes each snapshot to connect file
-	void writeConnectFileSnapshot(unsigned int simTimeMs, std::vector< std::vector<float> > wts);
+	//! sets the format of the connect file (wtResolution<=0: default resolution relative to the max weight)
+	void setFileFormat(connFileFormat_t format, int keyframeInterval, float wtResolution);
+
+	//! returns true if the header of the connect file has been written, so the format can no longer change
+	bool isFileFormatFixed() { return connFileId_!=NULL && !needToWriteFileHeader_; }
+
+	//! writes the current weights to connect file (called by CpuSNN::updateConnectionMonitor), does not affect the
+	//! stored snapshots
+	void writeConnectFileSnapshot(unsigned int simTimeMs);
 	
 private:
+	//! expands weights in CSR order to a 2D matrix (non-existent synapses: NAN, existent but zero weight: 0.0f)
+	std::vector< std::vector<float> > getWeightMatrix2D(const std::vector<float>& wts);
+
+	//! writes weights in CSR order to connect file
+	void writeConnectFileSnapshot(int64_t simTimeMs, const std::vector<float>& wts);
+
+	//! encodes a snapshot as a keyframe or as changes to the weights the reader knows (delta-encoded format)
+	void encodeDeltaFrame(int64_t simTimeMs, const std::vector<float>& wts);
+
 	//! indicates whether writing the current snapshot is necessary (false it has already been written)
 	bool needToWriteSnapshot();
 
@@ -187,8 +213,15 @@ private:
 
 	bool isPlastic_; //!< whether this connection has plastic synapses
 
-	std::vector< std::vector<float> > wtMat_;      //!< current snapshot of weight matrix
-	std::vector< std::vector<float> > wtMatLast_;  //!< last snapshot of weight matrix
+	// the synapses are stored in CSR layout, aligned with the order of CpuSNN::preSynapticIds:
+	// the synapses of post-neuron j are synPtr_[j]...synPtr_[j+1]-1
+	std::vector<int> synPtr_;       //!< index of the first synapse of every post-neuron (nNeurPost+1 entries)
+	std::vector<int> preIds_;       //!< pre-neuron ID of every synapse
+	std::vector<int> fanOut_;       //!< number of synapses of every pre-neuron
+
+	std::vector<float> wts_;        //!< current snapshot of weights, per synapse
+	std::vector<float> wtsLast_;    //!< last snapshot of weights, per synapse
+	std::vector<float> wtsWrite_;   //!< weights fetched for periodic writing to file
 	int64_t wtTime_;
 	int64_t wtTimeLast_;
 	int64_t wtTimeWrite_;
@@ -200,6 +233,13 @@ private:
 	int connFileSignature_;         //!< int signature of conn file
 	float connFileVersion_;         //!< version number of conn file
 	int connFileTimeIntervalSec_;   //!< time update interval (seconds) for storing weights to file
+	connFileFormat_t connFileFormat_; //!< format of the snapshots in the conn file
+
+	int keyframeInterval_;          //!< number of snapshots between two keyframes (delta-encoded format)
+	float wtResolution_;            //!< resolution of weight changes (delta-encoded format)
+	int numFramesSinceKeyframe_;    //!< number of snapshots written since the last keyframe
+	std::vector<float> wtsFileRef_; //!< weights as the reader of the conn file will reconstruct them
+	std::vector<unsigned char> frameBuf_; //!< encoded snapshot, written to file at once
 
 	const FILE* fpInf_;             //!< file pointer for info logging
 	const FILE* fpErr_;             //!< file pointer for error logging
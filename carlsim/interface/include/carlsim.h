@@ -149,7 +149,8 @@ public:
 	 *
 	 * CARLsim allows execution on both generic x86 CPUs and standard off-the-shelf GPUs by specifying the simulation
 	 * mode (CPU_MODE and GPU_MODE, respectively). When using the latter in a multi-GPU system, the user can also
-	 * specify which CUDA device to use (param ithGPU, 0-indexed).
+	 * specify which CUDA device to use (param ithGPU, 0-indexed). On multi-core machines, CPU_MODE_MT will spread
+	 * the neuron state update across several threads (see setNumThreads).
 	 *
 	 * The logger mode defines where to print all status, error, and debug messages. Logger mode can either be USER (for
 	 * experiment-oriented simulations), DEVELOPER (for developing and debugging code), SHOWTIME (where only warnings
@@ -167,8 +168,12 @@ public:
 	 * Location of the CARLsim log file can be set in any mode using setLogFile.
 	 * In mode CUSTOM, the other file pointers can be set using setLogsFpCustom.
 	 *
+	 * The random parts of the network (connectivity, delays, random weights, and neuron parameters) and, in CPU mode,
+	 * Poisson spike trains are drawn from per-group and per-connection streams of the random seed. The same seed thus
+	 * gives the same network and the same spike trains, independent of the number of threads and of rand().
+	 *
 	 * \param[in] netName 		network name
-	 * \param[in] simMode		either CPU_MODE or GPU_MODE
+	 * \param[in] simMode		either CPU_MODE, CPU_MODE_MT, or GPU_MODE
 	 * \param[in] loggerMode    either USER, DEVELOPER, SILENT, or CUSTOM
 	 * \param[in] ithGPU 		on which GPU to establish a context (only relevant in GPU_MODE)
 	 * \param[in] randSeed 		random number generator seed
@@ -598,6 +603,135 @@ public:
 	void setNeuromodulator(int grpId, float tauDP = 100.0f, float tau5HT = 100.0f,
 							float tauACh = 100.0f, float tauNE = 100.0f);
 
+	/*!
+	 * \brief Sets the number of threads to use in CPU_MODE_MT
+	 *
+	 * In CPU_MODE_MT, the neuron state update is split across a pool of worker threads that is created once in
+	 * setupNetwork and then reused throughout the simulation. Every thread integrates a contiguous chunk of neurons.
+	 * Because each neuron is updated by exactly the same code as in CPU_MODE, results are identical to running on a
+	 * single thread.
+	 *
+	 * By default, CARLsim will use as many threads as there are CPU cores available.
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] numThreads the number of threads to use (including the main thread)
+	 * \since v3.1
+	 */
+	void setNumThreads(int numThreads);
+
+	/*!
+	 * \brief Enables or disables parallel spike delivery in CPU_MODE_MT
+	 *
+	 * In CPU_MODE_MT, spike delivery (i.e., adding synaptic weights to the conductances/currents of post-synaptic
+	 * neurons) is by default split across all worker threads: Every thread owns a range of post-synaptic neurons and
+	 * only delivers the spikes targeting this range. This way, no two threads ever write to the same neuron, and
+	 * every neuron receives its inputs in the same order as in the serial version. Spike delivery is thus
+	 * deterministic and gives identical results either way.
+	 *
+	 * Setting isSet to false will deliver all spikes on the main thread instead, which can be used to compare both
+	 * versions. This function can be called at any point in time.
+	 *
+	 * \STATE ::CONFIG_STATE, ::SETUP_STATE, ::RUN_STATE
+	 * \param[in] isSet whether to deliver spikes on all threads (true) or on the main thread only (false)
+	 * \since v3.1
+	 */
+	void setParallelSpikeDelivery(bool isSet);
+
+	/*!
+	 * \brief Sets the engine used to deliver spikes in CPU_MODE and CPU_MODE_MT
+	 *
+	 * By default, every spike is pushed to all of its post-synaptic targets (PUSH_PROPAGATION), which is cheap when
+	 * activity is sparse. For dense connectivity (e.g., CONN_FULL or CONN_RANDOM with high connection probability) and
+	 * high firing rates, it can be faster to let every post-synaptic neuron pull the spikes arriving at its synapses
+	 * from a bitmap of recent spikes (PULL_PROPAGATION), which reads the synapses of every neuron sequentially and
+	 * writes its conductances only once per time step. With AUTO_PROPAGATION, the engine is picked at setupNetwork
+	 * by comparing the estimated costs of both engines, based on the number of synapses, the number of neurons, and
+	 * the expected mean firing rate of the network.
+	 *
+	 * Both engines implement the same model, but synaptic inputs are summed up in a different order, so results are
+	 * not bit-identical.
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] engine             either PUSH_PROPAGATION, PULL_PROPAGATION, or AUTO_PROPAGATION
+	 * \param[in] expectedFiringRate expected mean firing rate (Hz) of the network, only used by AUTO_PROPAGATION
+	 * \sa getSpikePropagation
+	 * \since v3.1
+	 */
+	void setSpikePropagation(spikePropagation_t engine, float expectedFiringRate=10.0f);
+
+	/*!
+	 * \brief Decays the conductances in the same sweep over the neurons as the neuron state update (CPU only)
+	 *
+	 * By default, every time step first decays the conductances (or resets the currents in CUBA mode) of all neurons,
+	 * then delivers spikes, and finally integrates the neurons. For networks that do not fit into the cache, this
+	 * streams the conductances from memory twice per time step. With the fused state update, the conductances of a
+	 * small block of neurons are decayed for the next time step right after they have been used to integrate the
+	 * neurons, while they are still in the cache. Because nothing changes the conductances in between, spike
+	 * delivery still happens after the decay, and results are identical to the default.
+	 *
+	 * The only visible difference is that conductances read between time steps (e.g., with getConductanceAMPA)
+	 * have already been decayed for the next time step.
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] isSet whether to fuse the conductance decay into the neuron state update
+	 * \since v3.1
+	 */
+	void setFusedStateUpdate(bool isSet);
+
+	/*!
+	 * \brief Enables or disables the STDP lookup tables in CPU_MODE and CPU_MODE_MT
+	 *
+	 * STDP evaluates the exponential curves of ExpCurve and TimingBasedCurve for every plastic synapse whenever a
+	 * pre- or post-synaptic spike occurs. Since spike times are integer ms, these curves are by default sampled once
+	 * per group at setupNetwork for every possible time difference (up to 25 time constants), and looked up instead
+	 * of calling exp() for every synapse. The samples are computed with the same expression and stored in double
+	 * precision, so results are identical either way. Setting isSet to false computes the exponentials on the fly,
+	 * which saves memory for groups with very long time constants.
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] isSet whether to use lookup tables (true) or call exp() for every synapse (false)
+	 * \since v3.1
+	 */
+	void setSTDPLookupTable(bool isSet);
+
+	/*!
+	 * \brief Enables or disables the SIMD neuron state update kernels in CPU_MODE and CPU_MODE_MT
+	 *
+	 * By default, the Izhikevich state update integrates 8 (AVX2) or 16 (AVX-512) neurons per instruction whenever
+	 * the host CPU supports it. The instruction set is detected at setupNetwork. Setting isSet to false forces the
+	 * portable scalar kernel instead, which is useful to check that a simulation does not depend on the CPU it runs
+	 * on. On CPUs without AVX2, the scalar kernel is always used.
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] isSet whether to use the SIMD kernels if the CPU supports them (true) or the scalar kernel (false)
+	 * \since v3.1
+	 */
+	void setSIMDKernels(bool isSet);
+
+	/*!
+	 * \brief Sets the firing rate that the spike buffers of a group are sized for
+	 *
+	 * Every time step, the neurons that fired are stored in a spike buffer until their spikes have been delivered
+	 * (and the spike monitors have been updated). In CPU_MODE and CPU_MODE_MT, these buffers grow on demand, but
+	 * growing them in the middle of a time step is slow. Therefore, the buffer of every time step is reserved in
+	 * advance for the expected number of spikes, which is the sum over all groups of the number of neurons times
+	 * the budgeted firing rate. By default, every group is budgeted at 25 Hz. Whenever more neurons fire in a time
+	 * step than budgeted for, the budget is doubled and getNumSpikeBufferOverflows is incremented.
+	 *
+	 * In GPU_MODE, the firing tables cannot grow, and are allocated for the budgeted number of spikes per neuron and
+	 * second (1000 Hz by default). Here the budget must account for bursts, or else the simulation will stop.
+	 *
+	 * A good budget is the firing rate measured in a previous run of the same network (e.g., with
+	 * SpikeMonitor::getPopMeanFiringRate or SpikeMonitor::getMaxFiringRate).
+	 *
+	 * \STATE ::CONFIG_STATE
+	 * \param[in] grpId      the group ID (or ALL)
+	 * \param[in] firingRate the expected firing rate (Hz) of the group
+	 * \sa getNumSpikeBufferOverflows
+	 * \since v3.1
+	 */
+	void setSpikeBufferBudget(int grpId, float firingRate);
+
 	/*!
 	 * \brief Sets default STDP mode and params
 	 *
@@ -1137,6 +1271,7 @@ public:
 	 * 							AER format
 	 *
 	 * \note Only one SpikeMonitor is allowed per group.
+	 * \note SpikeMonitor can only be set on groups with at most MAX_SPIKE_MON_GROUP_SIZE (4,194,304) neurons.
 	 * \attention Using SpikeMonitor::startRecording and SpikeMonitor::stopRecording might significantly slow down the
 	 * simulation. It is unwise to use this mechanism to record a large number of spikes over a long period of time.
 	 * \see ch7s1_spike_monitor
@@ -1294,6 +1429,15 @@ public:
 	 */
 	std::vector<float> getConductanceGABAb(int grpId);
 
+	/*!
+	 * \brief gets the membrane potential of all neurons in a group
+	 *
+	 * \STATE ::RUN_STATE
+	 * \param[in] grpId the group ID
+	 * \returns a vector with the membrane potential (mV) of every neuron in the group
+	 */
+	std::vector<float> getVoltage(int grpId);
+
 	/*!
 	 * \brief returns the RangeDelay struct for a specific connection ID
 	 *
@@ -1503,6 +1647,37 @@ public:
 	 */
 	int getNumPostSynapses();
 
+	/*!
+	 * \brief returns the number of threads used in CPU_MODE_MT (1 in all other modes)
+	 *
+	 * \STATE ::CONFIG_STATE, ::SETUP_STATE, ::RUN_STATE
+	 * \sa setNumThreads
+	 */
+	int getNumThreads();
+
+	/*!
+	 * \brief returns the spike propagation engine
+	 *
+	 * In ::SETUP_STATE and ::RUN_STATE, AUTO_PROPAGATION has already been resolved to the engine that is actually used
+	 * (CPU_MODE and CPU_MODE_MT only).
+	 *
+	 * \STATE ::CONFIG_STATE, ::SETUP_STATE, ::RUN_STATE
+	 * \sa setSpikePropagation
+	 */
+	spikePropagation_t getSpikePropagation();
+
+	/*!
+	 * \brief returns the number of time steps in which more neurons fired than the spike buffers were budgeted for
+	 *
+	 * No spikes are lost in CPU_MODE and CPU_MODE_MT, because the buffers then grow, but frequent overflows indicate
+	 * that the budget set with setSpikeBufferBudget is too low. Always 0 in GPU_MODE.
+	 *
+	 * \STATE ::CONFIG_STATE, ::SETUP_STATE, ::RUN_STATE
+	 * \sa setSpikeBufferBudget
+	 * \since v3.1
+	 */
+	int getNumSpikeBufferOverflows();
+
 	/*!
 	 * \brief returns the first neuron id of a groupd specified by grpId
 	 *
@@ -1549,7 +1724,8 @@ public:
 	/*!
 	 * \brief returns the current simulation mode
 	 *
-	 * This function returns the current simulation mode. Currently supported are CPU_MODE and GPU_MODE.
+	 * This function returns the current simulation mode. Currently supported are CPU_MODE, CPU_MODE_MT,
+	 * and GPU_MODE.
 	 * \STATE ::CONFIG_STATE, ::SETUP_STATE, ::RUN_STATE
 	 * \return simulation mode
 	 * \since v3.0
@@ -1803,7 +1979,7 @@ private:
 	CpuSNN* snn_;					//!< an instance of CARLsim core class
 	std::string netName_;			//!< network name
 	int randSeed_;					//!< RNG seed
-	simMode_t simMode_;				//!< CPU_MODE or GPU_MODE
+	simMode_t simMode_;				//!< CPU_MODE, CPU_MODE_MT, or GPU_MODE
 	loggerMode_t loggerMode_;		//!< logger mode (USER, DEVELOPER, SILENT, CUSTOM)
 	int ithGPU_;					//!< on which device to establish a context
 	bool enablePrint_;
@@ -98,20 +98,47 @@ static const char* loggerMode_string[] = {
  * CARLsim supports execution either on standard x86 central processing units (CPUs) or off-the-shelf NVIDIA GPUs.
  *
  * When creating a new CARLsim object, you can choose from the following:
- * CPU_MODE:	run on a single CPU core
- * GPU_MODE:	run on a single GPU card
+ * CPU_MODE:		run on a single CPU core
+ * GPU_MODE:		run on a single GPU card
+ * CPU_MODE_MT:	run on multiple CPU cores (see CARLsim::setNumThreads)
  *
  * When running GPU mode on a multi-GPU system, you can specify on which CUDA device to establish a context (ithGPU,
  * 0-indexed) when you create a new CpuSNN object.
  * The simulation mode will be fixed throughout the lifetime of a CpuSNN object.
+ *
+ * CPU_MODE_MT partitions the neurons across a pool of worker threads. Every neuron is integrated by exactly the same
+ * code as in CPU_MODE, so that both modes produce identical results.
  */
 enum simMode_t {
 	 CPU_MODE,     //!< model is run on a single CPU core
 	 GPU_MODE,     //!< model is run on a single GPU card
+	 CPU_MODE_MT,  //!< model is run on multiple CPU cores
 	 UNKNOWN_SIM
 };
 static const char* simMode_string[] = {
-	"CPU mode","GPU mode","Unknown mode"
+	"CPU mode","GPU mode","Multi-threaded CPU mode","Unknown mode"
+};
+
+/*!
+ * \brief CPU spike propagation engines
+ *
+ * CARLsim can deliver spikes to their post-synaptic targets in one of two ways (CPU_MODE and CPU_MODE_MT only):
+ * PUSH_PROPAGATION:	every spike is pushed to all of its post-synaptic targets (cheap for sparse activity)
+ * PULL_PROPAGATION:	every post-synaptic neuron pulls the spikes arriving at its synapses from a bitmap of recent
+ *						spikes, and writes its conductances only once per time step (cheap for dense connectivity)
+ * AUTO_PROPAGATION:	pick one of the above at setupNetwork based on the number of synapses, the number of neurons,
+ *						and the expected mean firing rate
+ *
+ * Both engines implement the same model, but since the order in which synaptic inputs are summed is different, the
+ * results are not bit-identical.
+ */
+enum spikePropagation_t {
+	PUSH_PROPAGATION,	//!< spikes are pushed from the pre- to the post-synaptic neurons
+	PULL_PROPAGATION,	//!< spikes are pulled by the post-synaptic neurons
+	AUTO_PROPAGATION	//!< engine is chosen by a cost model at setupNetwork
+};
+static const char* spikePropagation_string[] = {
+	"push", "pull", "auto"
 };
 
 /*!
@@ -179,13 +206,53 @@ static const char* stdpCurve_string[] = {
  *          neuron, and is thus not capable of computing spike train correlation etc.
  * AER:     Will collect spike information in AER format (will collect both neuron IDs and
  *          spike times).
+ * WINDOW:  Will collect spike count information like COUNT, and in addition keep per-neuron spike
+ *          counts in a rolling window of time bins, which can be queried at any time (see
+ *          SpikeMonitor::setWindow).
  */
 enum spikeMonMode_t {
 	COUNT,      //!< mode in which only spike count information is collected
 	AER,        //!< mode in which spike information is collected in AER format
+	WINDOW,     //!< mode in which spike counts are collected in a rolling window of time bins
 };
 static const char* spikeMonMode_string[] = {
-	"SpikeCount Mode","SpikeTime Mode"
+	"SpikeCount Mode","SpikeTime Mode","SpikeWindow Mode"
+};
+
+/*!
+ * \brief SpikeMonitor spike file format
+ *
+ * Spike files can be written in different formats:
+ * SPK_FILE_AER:     Every spike is stored as a pair of int32 (spike time, neuron ID). This is the
+ *                   format of spike file version 0.2.
+ * SPK_FILE_COMPACT: Spikes are stored in blocks, with spike times delta-encoded and both times
+ *                   and neuron IDs stored as variable-length integers (spike file version 0.3).
+ *                   Typically needs 2-4 bytes per spike instead of 8.
+ */
+enum spikeFileFormat_t {
+	SPK_FILE_AER,      //!< two int32 per spike
+	SPK_FILE_COMPACT,  //!< delta-encoded, variable-length blocks
+};
+static const char* spikeFileFormat_string[] = {
+	"AER","Compact"
+};
+
+/*!
+ * \brief ConnectionMonitor connect file format
+ *
+ * Connect files can be written in different formats:
+ * CONN_FILE_FULL:  Every snapshot stores the weights of all synapses as float32. This is the format of
+ *                  connect file version 0.4.
+ * CONN_FILE_DELTA: Every few snapshots a keyframe stores the weights of all synapses as float32. All other
+ *                  snapshots only store the synapses whose weight changed, as index gap and quantized
+ *                  weight change, both as variable-length integers (connect file version 0.5).
+ */
+enum connFileFormat_t {
+	CONN_FILE_FULL,    //!< all weights in every snapshot
+	CONN_FILE_DELTA,   //!< keyframes plus quantized weight changes
+};
+static const char* connFileFormat_string[] = {
+	"Full","Delta"
 };
 
 /*!
@@ -596,6 +596,82 @@ void CARLsim::setIntegrationMethod(integrationMethod_t method, int numStepsPerMs
 	snn_->setIntegrationMethod(method, numStepsPerMs);	
 }
 
+// sets number of worker threads in CPU_MODE_MT
+void CARLsim::setNumThreads(int numThreads) {
+	std::string funcName = "setNumThreads()";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(simMode_==CPU_MODE_MT, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE_MT.");
+	UserErrors::assertTrue(numThreads > 0, UserErrors::MUST_BE_POSITIVE, funcName, "numThreads");
+
+	snn_->setNumThreads(numThreads);
+}
+
+// enables/disables parallel spike delivery in CPU_MODE_MT
+void CARLsim::setParallelSpikeDelivery(bool isSet) {
+	std::string funcName = "setParallelSpikeDelivery()";
+	UserErrors::assertTrue(simMode_==CPU_MODE_MT, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE_MT.");
+
+	snn_->setParallelSpikeDelivery(isSet);
+}
+
+// sets the spike propagation engine in CPU_MODE and CPU_MODE_MT
+void CARLsim::setSpikePropagation(spikePropagation_t engine, float expectedFiringRate) {
+	std::string funcName = "setSpikePropagation()";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(simMode_!=GPU_MODE, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE or CPU_MODE_MT.");
+	UserErrors::assertTrue(expectedFiringRate >= 0.0f, UserErrors::CANNOT_BE_NEGATIVE, funcName, "expectedFiringRate");
+
+	snn_->setSpikePropagation(engine, expectedFiringRate);
+}
+
+// fuses the conductance decay into the neuron state update in CPU_MODE and CPU_MODE_MT
+void CARLsim::setFusedStateUpdate(bool isSet) {
+	std::string funcName = "setFusedStateUpdate()";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(simMode_!=GPU_MODE, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE or CPU_MODE_MT.");
+
+	snn_->setFusedStateUpdate(isSet);
+}
+
+// enables or disables the STDP lookup tables in CPU_MODE and CPU_MODE_MT
+void CARLsim::setSTDPLookupTable(bool isSet) {
+	std::string funcName = "setSTDPLookupTable()";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(simMode_!=GPU_MODE, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE or CPU_MODE_MT.");
+
+	snn_->setSTDPLookupTable(isSet);
+}
+
+// enables or disables the SIMD neuron state update kernels in CPU_MODE and CPU_MODE_MT
+void CARLsim::setSIMDKernels(bool isSet) {
+	std::string funcName = "setSIMDKernels()";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(simMode_!=GPU_MODE, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName,
+		"CPU_MODE or CPU_MODE_MT.");
+
+	snn_->setSIMDKernels(isSet);
+}
+
+// sets the firing rate that the spike buffers of a group are sized for
+void CARLsim::setSpikeBufferBudget(int grpId, float firingRate) {
+	std::string funcName = "setSpikeBufferBudget(\""+getGroupName(grpId)+"\")";
+	UserErrors::assertTrue(carlsimState_==CONFIG_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName,
+		"CONFIG.");
+	UserErrors::assertTrue(firingRate >= 0.0f, UserErrors::CANNOT_BE_NEGATIVE, funcName, "firingRate");
+
+	snn_->setSpikeBufferBudget(grpId, firingRate);
+}
+
 // set neuron parameters for Izhikevich neuron, with standard deviations
 void CARLsim::setNeuronParameters(int grpId, float izh_a, float izh_a_sd, float izh_b, float izh_b_sd,
 	float izh_c, float izh_c_sd, float izh_d, float izh_d_sd)
@@ -1125,6 +1201,8 @@ SpikeMonitor* CARLsim::setSpikeMonitor(int grpId, const std::string& fileName) {
 	UserErrors::assertTrue(grpId>=0, UserErrors::CANNOT_BE_NEGATIVE, funcName, "grpId"); // grpId can't be negative
 	UserErrors::assertTrue(carlsimState_==CONFIG_STATE || carlsimState_==SETUP_STATE,
 					UserErrors::CAN_ONLY_BE_CALLED_IN_STATE, funcName, funcName, "CONFIG or SETUP.");
+	UserErrors::assertTrue(getGroupNumNeurons(grpId)<=MAX_SPIKE_MON_GROUP_SIZE, UserErrors::CANNOT_BE_LARGER, funcName,
+					"Number of neurons in group", "MAX_SPIKE_MON_GROUP_SIZE (4194304).");
 
 	FILE* fid;
 	std::string fileNameLower = fileName;
@@ -1237,6 +1315,17 @@ std::vector<float> CARLsim::getConductanceGABAb(int grpId) {
 	return snn_->getConductanceGABAb(grpId);
 }
 
+std::vector<float> CARLsim::getVoltage(int grpId) {
+	std::string funcName = "getVoltage()";
+	UserErrors::assertTrue(carlsimState_ == RUN_STATE, UserErrors::CAN_ONLY_BE_CALLED_IN_STATE,
+		funcName, funcName, "RUN.");
+	UserErrors::assertFalse(grpId==ALL, UserErrors::ALL_NOT_ALLOWED, funcName, "grpId");
+	UserErrors::assertTrue(grpId>=0 && grpId<getNumGroups(), UserErrors::MUST_BE_IN_RANGE, funcName, "grpId",
+		"[0,getNumGroups()]");
+
+	return snn_->getVoltage(grpId);
+}
+
 RangeDelay CARLsim::getDelayRange(short int connId) {
 	std::stringstream funcName;	funcName << "getDelayRange(" << connId << ")";
 	UserErrors::assertTrue(connId>=0 && connId<getNumConnections(), UserErrors::MUST_BE_IN_RANGE, funcName.str(),
@@ -1360,6 +1449,11 @@ int CARLsim::getNumSynapticConnections(short int connectionId) {
 		funcName.str(), "connectionId", "[0,getNumSynapticConnections()]");
 	return snn_->getNumSynapticConnections(connectionId);
 }
+int CARLsim::getNumThreads() { return snn_->getNumThreads(); }
+
+spikePropagation_t CARLsim::getSpikePropagation() { return snn_->getSpikePropagation(); }
+int CARLsim::getNumSpikeBufferOverflows() { return snn_->getNumSpikeBufferOverflows(); }
+
 int CARLsim::getNumPostSynapses() {
 	std::string funcName = "getNumPostSynapses()";
 	UserErrors::assertTrue(carlsimState_ == SETUP_STATE || carlsimState_ == RUN_STATE,
@@ -1620,6 +1714,9 @@ void CARLsim::handleUserWarnings() {
 void CARLsim::printSimulationSpecs() {
 	if (simMode_==CPU_MODE) {
 		fprintf(stdout,"CPU_MODE, enablePrint=%s, copyState=%s\n\n",enablePrint_?"on":"off",copyState_?"on":"off");
+	} else if (simMode_==CPU_MODE_MT) {
+		fprintf(stdout,"CPU_MODE_MT, numThreads=%d, enablePrint=%s, copyState=%s\n\n",getNumThreads(),
+					enablePrint_?"on":"off",copyState_?"on":"off");
 	} else {
 		fprintf(stdout,"GPU_MODE, GPUid=%d, enablePrint=%s, copyState=%s\n\n",ithGPU_,enablePrint_?"on":"off",
 					copyState_?"on":"off");
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _COUNTER_RNG_H_
+#define _COUNTER_RNG_H_
+
+#include <stdint.h>
+
+//! rotates the 32-bit word x left by r bits
+inline uint32_t rotl32(uint32_t x, int r) {
+	return (x << r) | (x >> (32 - r));
+}
+
+/*!
+ * \brief Threefry2x32-20 counter-based random number generator
+ *
+ * Maps a 64-bit counter and a 64-bit key to 64 random bits (Salmon et al., "Parallel random numbers: as easy as
+ * 1, 2, 3", SC 2011). There is no state: the same counter and key always give the same bits, so every random number
+ * can be addressed directly (e.g., by neuron ID and time) and drawn on any thread, in any order. The key selects an
+ * independent stream, e.g. the random seed of the simulation in key[0] and the purpose of the stream in key[1].
+ *
+ * Threefry only uses 32-bit additions, rotations, and XORs, so loops over many counters vectorize with plain SSE2.
+ * \param[in]  ctr the 64-bit counter
+ * \param[in]  key the 64-bit key
+ * \param[out] out 64 random bits
+ */
+inline void threefry2x32(const uint32_t ctr[2], const uint32_t key[2], uint32_t out[2]) {
+	static const int rot[8] = {13, 15, 26, 6, 17, 29, 16, 24};
+	const uint32_t ks[3] = {key[0], key[1], 0x1BD11BDAu ^ key[0] ^ key[1]};
+
+	uint32_t x0 = ctr[0] + ks[0];
+	uint32_t x1 = ctr[1] + ks[1];
+
+	// 5 x 4 rounds, the key is injected after every 4 rounds
+	for (int inj=1; inj<=5; inj++) {
+		for (int round=0; round<4; round++) {
+			x0 += x1;
+			x1 = rotl32(x1, rot[((inj-1)*4 + round) % 8]);
+			x1 ^= x0;
+		}
+		x0 += ks[inj % 3];
+		x1 += ks[(inj+1) % 3] + inj;
+	}
+
+	out[0] = x0;
+	out[1] = x1;
+}
+
+//! converts 32 random bits to a float uniformly distributed in (0,1] (never 0, so that it is safe to take the log)
+inline float uniformFromBits(uint32_t bits) {
+	return ((bits >> 8) + 1) * (1.0f / 16777216.0f);
+}
+
+//! converts 32 random bits to a float uniformly distributed in [0,1) (same range as drand48)
+inline float uniform01FromBits(uint32_t bits) {
+	return (bits >> 8) * (1.0f / 16777216.0f);
+}
+
+//! converts 64 random bits to a double uniformly distributed in (0,1], fine enough for the tails of a distribution
+inline double uniformDoubleFromBits(const uint32_t bits[2]) {
+	uint64_t mantissa = ((uint64_t)(bits[0] >> 5) << 26) | (bits[1] >> 6);
+	return (mantissa + 1) * (1.0 / 9007199254740992.0);
+}
+
+/*!
+ * \brief a reproducible stream of random numbers
+ *
+ * A stream is selected by the random seed and a stream ID (see RNG_STREAM_ID), and its random numbers are addressed
+ * by two 32-bit indices, such as the pre- and post-synaptic neuron of a synapse. Since there is no state, any number
+ * of threads can draw from the same stream in any order and get the same numbers, and streams never overlap.
+ */
+class CounterRNG {
+public:
+	CounterRNG(uint32_t seed, uint32_t streamId) {
+		key_[0] = seed;
+		key_[1] = streamId;
+	}
+
+	//! 64 random bits at position (i,j) of the stream
+	void getBits(uint32_t i, uint32_t j, uint32_t out[2]) const {
+		const uint32_t ctr[2] = {i, j};
+		threefry2x32(ctr, key_, out);
+	}
+
+	//! a float uniformly distributed in [0,1) at position (i,j) of the stream
+	float getUniform(uint32_t i, uint32_t j) const {
+		uint32_t bits[2];
+		getBits(i, j, bits);
+		return uniform01FromBits(bits[0]);
+	}
+
+private:
+	uint32_t key_[2];
+};
+
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _CPU_WORKER_POOL_H_
+#define _CPU_WORKER_POOL_H_
+
+#if !defined(WIN32) && !defined(WIN64)
+	#include <pthread.h>
+#endif
+
+/*!
+ * \brief A persistent pool of worker threads used by CPU_MODE_MT
+ *
+ * The pool is created once (at CpuSNN::setupNetwork) and then reused every simulation time step, so that we don't
+ * pay for thread creation in the inner loop. A call to run() hands the same task to all threads, with the calling
+ * thread acting as worker 0, and returns only after every worker has finished. It is up to the task to pick its
+ * share of the work based on its thread ID (see getPartition).
+ *
+ * On Windows the pool currently falls back to running the task serially on the calling thread.
+ */
+class CpuWorkerPool {
+public:
+	//! signature of a task: arg is passed through unchanged, threadId is in [0, numThreads)
+	typedef void (*workerTask_t)(void* arg, int threadId, int numThreads);
+
+	//! spawns numThreads-1 worker threads (the calling thread is worker 0)
+	CpuWorkerPool(int numThreads);
+
+	//! joins all worker threads
+	~CpuWorkerPool();
+
+	//! returns the number of threads (including the calling thread)
+	int getNumThreads() { return numThreads_; }
+
+	//! executes task on all threads in parallel and blocks until every thread is done
+	void run(workerTask_t task, void* arg);
+
+	/*!
+	 * \brief splits the range [0,numItems) into numThreads contiguous chunks of (almost) equal size
+	 *
+	 * The partition is a pure function of its arguments, so that every thread gets the same chunk in every time step.
+	 * \param[in]  numItems   total number of items to be split
+	 * \param[in]  threadId   which chunk to return
+	 * \param[in]  numThreads number of chunks
+	 * \param[out] first      first item in the chunk
+	 * \param[out] last       one past the last item in the chunk
+	 */
+	static void getPartition(int numItems, int threadId, int numThreads, int& first, int& last);
+
+	//! returns the number of online processors, or 1 if this cannot be determined
+	static int getNumProcessors();
+
+private:
+	//! main loop of each worker thread: waits for a new task, runs it, reports back
+	static void* workerLoop(void* arg);
+
+	int numThreads_;
+
+	workerTask_t task_;		//!< task of the current run
+	void* taskArg_;			//!< argument of the current run
+
+#if !defined(WIN32) && !defined(WIN64)
+	struct workerInfo_t {
+		CpuWorkerPool* pool;
+		int threadId;
+	};
+
+	pthread_t* threads_;
+	workerInfo_t* workerInfo_;
+
+	pthread_mutex_t mutex_;
+	pthread_cond_t startCond_;		//!< signaled when a new task is available (or on shutdown)
+	pthread_cond_t doneCond_;		//!< signaled when the last worker has finished its task
+	unsigned long generation_;		//!< incremented with every run, so that workers can tell a new task apart
+	int numBusy_;					//!< number of workers still busy with the current task
+	bool shutdown_;
+#endif
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _IZHIKEVICH_KERNELS_H_
+#define _IZHIKEVICH_KERNELS_H_
+
+#include <carlsim_datastructures.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+/*!
+ * \brief Instruction set used by the CPU neuron state update kernels
+ *
+ * SIMD_SCALAR:	one neuron at a time (portable fallback)
+ * SIMD_AVX2:	8 neurons per instruction
+ * SIMD_AVX512:	16 neurons per instruction
+ */
+enum simdLevel_t {
+	SIMD_SCALAR,
+	SIMD_AVX2,
+	SIMD_AVX512
+};
+extern const char* simdLevel_string[];
+
+/*!
+ * \brief Spike bitset written by the neuron state update kernels
+ *
+ * Neuron i is represented by bit i%64 of word i/64, so that findFiring can skip 64 silent neurons at a time and
+ * jump straight to the ones that spiked with countTrailingZeros.
+ */
+#define SPIKE_BITS_PER_WORD 64
+
+//! returns the index of the lowest set bit of a non-zero word
+inline int countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+	unsigned long idx;
+	_BitScanForward64(&idx, word);
+	return (int)idx;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+//! sets bits of a spike bitset word that may be shared with other threads (e.g., in CPU_MODE_MT)
+inline void atomicOr(uint64_t* word, uint64_t bits) {
+#if defined(_MSC_VER)
+	_InterlockedOr64((volatile __int64*)word, (__int64)bits);
+#else
+	__atomic_fetch_or(word, bits, __ATOMIC_RELAXED);
+#endif
+}
+
+/*!
+ * \brief Arguments of a neuron state update kernel
+ *
+ * All arrays point to the first neuron to be updated (i.e., they are offset by the kernel's first neuron ID).
+ * Arrays that are not needed by a kernel may be NULL (e.g., current in COBA mode, or gNMDA if NMDA has a rise time).
+ */
+typedef struct IzhikevichKernelArgs_s {
+	int numNeurons;				//!< number of neurons to update
+	float timeStep;				//!< integration time step (ms)
+
+	const float* extCurrent;	//!< external current
+	const float* current;		//!< synaptic current (CUBA only)
+	const float* compCurrent;	//!< current from coupled compartments (withCompartments only)
+	const float* gAMPA;			//!< conductances (COBA only)
+	const float* gNMDA;			//!< used if !withNMDARise
+	const float* gNMDA_r;		//!< used if withNMDARise
+	const float* gNMDA_d;		//!< used if withNMDARise
+	const float* gGABAa;
+	const float* gGABAb;		//!< used if !withGABAbRise
+	const float* gGABAb_r;		//!< used if withGABAbRise
+	const float* gGABAb_d;		//!< used if withGABAbRise
+
+	const float* Izh_a;
+	const float* Izh_b;
+	const float* Izh_c;
+	const float* Izh_d;
+	const float* Izh_C;			//!< 9-param only
+	const float* Izh_k;			//!< 9-param only
+	const float* Izh_vr;		//!< 9-param only
+	const float* Izh_vt;		//!< 9-param only
+	const float* Izh_vpeak;		//!< 9-param only
+
+	const float* voltage;		//!< voltage at the beginning of the integration step
+	float* nextVoltage;			//!< voltage at the end of the integration step
+	float* recovery;			//!< recovery variable, updated in place
+	int firstNId;				//!< neuron ID of the first neuron (i.e., its bit in spikeBits)
+	uint64_t* spikeBits;		//!< spike bitset of all neurons, a neuron's bit is set if it spiked (never cleared)
+} IzhikevichKernelArgs;
+
+//! signature of a neuron state update kernel
+typedef void (*izhikevichKernel_t)(const IzhikevichKernelArgs& args);
+
+//! returns the widest instruction set supported by both the compiler and the CPU
+simdLevel_t getSupportedSimdLevel();
+
+/*!
+ * \brief returns the neuron state update kernel specialized for an instruction set and neuron/synapse model
+ *
+ * The returned kernel integrates a single step of the 4-param or 9-param Izhikevich model with either FORWARD_EULER
+ * or RUNGE_KUTTA4 for numNeurons neurons. Every combination of the flags is a separate template instantiation, so
+ * the kernel should be selected once per group (e.g., at setupNetwork), which leaves the inner loop free of per-neuron
+ * branches. withNMDARise and withGABAbRise are ignored unless withConductances is set. If simdLevel is not supported,
+ * the scalar kernel is returned.
+ *
+ * All kernels of a given instruction set process every neuron in the same way, including the remainder that does
+ * not fill a complete SIMD register (which is handled with masked loads/stores), so that results do not depend on
+ * how a group is split up across calls (e.g., by CPU_MODE_MT).
+ */
+izhikevichKernel_t getIzhikevichKernel(simdLevel_t simdLevel, integrationMethod_t method, bool withParamModel_9,
+	bool withConductances, bool withNMDARise, bool withGABAbRise, bool withCompartments);
+
+#endif
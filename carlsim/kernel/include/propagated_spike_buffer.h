@@ -28,21 +28,23 @@ typedef unsigned short int delay_t;
 //! Type for specifying the delay in time steps
 typedef unsigned short int delaystep_t;
 
-//! The size of one allocation chunk size in PropagatedSpikeBuffer
+//! The size of one allocation chunk size in PropagatedSpikeBuffer (unused, kept for backwards compatibility)
 #define PROPAGATED_SPIKE_BUFFER_CHUNK_SIZE 1024
 
 //! Schedule/Store spikes to be delivered at a later point in the simulation
+/*!
+ * The spikes scheduled for every time step are stored in their own contiguous array (one per slot of a ring buffer),
+ * so that reading all spikes of a time step is a linear scan. The arrays keep their memory when the slot is recycled,
+ * so that after a short warm-up period no more memory is allocated.
+ */
 class PropagatedSpikeBuffer
 {
-
 public:
 
     //! New spike buffer
     /*! \param minDelay Minimum delay (in number of time steps) the buffer can handle
     *  \param maxDelay Maximum delay (in number of time steps) the buffer can handle
-    *  \param chunkSize Constant used for internal memory management.
-    *                   Should increase with increasing number of synapses and
-    *                   exptected number of spikes.
+    *  \param chunkSize Unused, kept for backwards compatibility.
     */
     PropagatedSpikeBuffer(int minDelay,
                           int maxDelay,
@@ -51,39 +53,44 @@ public:
     //! Destructor: Deletes all scheduled spikes
     virtual ~PropagatedSpikeBuffer();
 
+    //! Structure which stores the index of the spike target group and its delay
+    struct StgNode
+    {
+        spikegroupid_t stg;
+        delaystep_t delay;
+    };
+
     //! Schedule a group of spike targets to get a spike at time t + delay
     /*! \param stg  The identifier of the spike target group to be used as
      *              identifier in SpikeTargetGroupPool::beginSpikeTarget( stg )
      *  \param delay The number of time steps to delay the deliver of the spike
      */
-    void scheduleSpikeTargetGroup(spikegroupid_t stg, delaystep_t delay);
-
-    //! Structure which stores the index of the spike target group and a pointer to the next element in various lists
-    struct StgNode
+    inline void scheduleSpikeTargetGroup(spikegroupid_t stg, delaystep_t delay)
     {
-        spikegroupid_t stg;
-        delaystep_t delay;
-        StgNode *next;
-    };
+        StgNode n;
+        n.stg   = stg;
+        n.delay = delay;
+        ringBuffer[ ( currIdx + delay ) % ringBuffer.size() ].push_back( n );
+    }
 
     //! Iterator to loop over the scheduled spikes at a certain delay
     class const_iterator
     {
     public:
         const_iterator(): node(NULL) {};
-        const_iterator(StgNode *n): node(n) {};
+        const_iterator(const StgNode *n): node(n) {};
 
-        StgNode* operator->() { return node; }
+        const StgNode* operator->() { return node; }
         spikegroupid_t operator*() { return node->stg; }
 
         bool operator==(const const_iterator& other) { return ( this->node == other.node ); }
 
         bool operator!=(const const_iterator& other) { return ( this->node != other.node ); }
 
-        inline const_iterator& operator++() { node = node->next; return *this; }
+        inline const_iterator& operator++() { ++node; return *this; }
 
     private:
-        StgNode *node;
+        const StgNode *node;
     };
 
     //! Returns an iterator to loop over all scheduled spike target groups
@@ -92,19 +99,15 @@ public:
      */
     const_iterator beginSpikeTargetGroups(int stepOffset = 0)
     {
-#ifdef DEBUG
-        // this assertion fails if stepOffset < -length()
-        if (const_iterator( ringBufferFront[ (currIdx + stepOffset + length() ) % length()  ] ) != NULL)
-            //        cout << "in beginSTG currT=" << currT << " stepOffset=" << stepOffset << endl;
-            assert( (currIdx + stepOffset + length() ) % length() >= 0 );
-#endif
-        return const_iterator( ringBufferFront[ (currIdx + stepOffset + length() ) % length()  ] );
+        const vector< StgNode >& slot = getSlot( stepOffset );
+        return slot.empty() ? const_iterator() : const_iterator( &slot[0] );
     };
 
-    //! End iterator corresponding to beginSynapseGroups
-    const_iterator endSpikeTargetGroups()
+    //! End iterator corresponding to beginSpikeTargetGroups (with the same stepOffset)
+    const_iterator endSpikeTargetGroups(int stepOffset = 0)
     {
-        return const_iterator(NULL);
+        const vector< StgNode >& slot = getSlot( stepOffset );
+        return slot.empty() ? const_iterator() : const_iterator( &slot[0] + slot.size() );
     };
 
     //! Must be called to tell the buffer that it should move on to the next time step
@@ -117,48 +120,28 @@ public:
     void reset(int minDelay, int maxDelay);
 
     //! Return the actual length of the buffer
-    inline size_t length() { return ringBufferFront.size(); };
-
-    // PropagatedSpikeBuffer & operator=(const PropagatedSpikeBuffer &src);
+    inline size_t length() { return ringBuffer.size(); };
 
 private :
 
     //! Set up internal memory management
     void init(size_t maxDelaySteps);
 
-    //! Get a new StgNode from the internal memory management
-    StgNode *getFreeNode(void);
+    //! Returns the spikes scheduled for time step ( current timestep + stepOffset )
+    const vector< StgNode >& getSlot(int stepOffset)
+    {
+        // this assertion fails if stepOffset < -length()
+        assert( (int)currIdx + stepOffset + (int)length() >= 0 );
+        return ringBuffer[ (currIdx + stepOffset + length() ) % length() ];
+    }
 
     //! The index into the ring buffer which corresponds to the current time step
     int currIdx ;
 
-    //! A ring buffer storing a pointer to the first StgNode of the scheduled spike receiving groups
-    vector< StgNode* > ringBufferFront;
-
-    //! A ring buffer storing a pointer to the last StgNode of the scheduled spike receiving groups
-    vector< StgNode* > ringBufferBack;
-
-    //! Buffer with pointers to chunks of memory allocated
-    vector< StgNode* > chunkBuffer;
-
-    //! Pointer to array of SrgNodes to take from (from position nextFreeSrgNodeIdx)
-    StgNode *currentFreeChunk;
-
-    //! Index into array currentFreeChunk which specifies the next StgNode to use
-    int  nextFreeSrgNodeIdx;
-
-    //! Index into chunkBuffer which specifies the next free chunk of memory to use
-    size_t nextFreeChunkIdx;
-
-    //! Head of list of SrgNodes which can be reused
-    StgNode* recycledNodes;
-
-    //! Number of SrgNodes per chunk of memory to allocate
-    int chunkSize;
+    //! A ring buffer storing the scheduled spike receiving groups of every time step
+    vector< vector< StgNode > > ringBuffer;
 
     int currT;
-
-    double fillitup[32];
 };
 
 #endif /*PROPAGATEDSPIKEBUFFER_H_*/
@@ -75,6 +75,8 @@
 #include <snn_datastructures.h>
 
 #include <propagated_spike_buffer.h>
+#include <cpu_worker_pool.h>
+#include <izhikevich_kernels.h>
 #include <poisson_rate.h>
 #ifndef __NO_CUDA__
 	#include <gpu_random.h>
@@ -223,6 +225,27 @@ public:
 	//! Sets the integration method and the number of integration steps per 1ms simulation time step
 	void setIntegrationMethod(integrationMethod_t method, int numStepsPerMs);
 
+	//! Sets the number of worker threads to use in CPU_MODE_MT
+	void setNumThreads(int numThreads);
+
+	//! Enables/disables delivering spikes on all worker threads in CPU_MODE_MT
+	void setParallelSpikeDelivery(bool isSet);
+
+	//! Sets the spike propagation engine to use in CPU_MODE and CPU_MODE_MT
+	void setSpikePropagation(spikePropagation_t engine, float expectedFiringRate);
+
+	//! Enables/disables decaying the conductances in the same sweep as the neuron state update (CPU only)
+	void setFusedStateUpdate(bool isSet);
+
+	//! Enables/disables looking up the exponential STDP curves in precomputed tables (CPU only)
+	void setSTDPLookupTable(bool isSet);
+
+	//! Enables/disables the AVX2/AVX-512 neuron state update kernels (CPU only)
+	void setSIMDKernels(bool isSet);
+
+	//! Sets the firing rate (Hz) used to size the spike buffers of a group
+	void setSpikeBufferBudget(int grpId, float firingRate);
+
 	//! Sets the Izhikevich parameters a, b, c, and d of a neuron group.
 	/*!
 	 * \brief Parameter values for each neuron are given by a normal distribution with mean _a, _b, _c, _d and standard deviation _a_sd, _b_sd, _c_sd, and _d_sd, respectively
@@ -466,6 +489,8 @@ public:
 	 * keyword ALL (for all groups).
 	 * Core and utility functions can call updateSpikeMonitor at any point in time. The function will automatically
 	 * determine the last time it was called, and update SpikeMonitor information only if necessary.
+	 * All SpikeMonitors that need an update are served by a single pass through the firing table, so the cost of
+	 * updateSpikeMonitor(ALL) does not grow with the number of monitors.
 	 */
 	void updateSpikeMonitor(int grpId=ALL);
 
@@ -553,6 +578,13 @@ public:
 	int getNumPreSynapses() { return preSynCnt; }
 	int getNumPostSynapses() { return postSynCnt; }
 
+	int getNumThreads() { return numThreads_; }
+	bool isParallelSpikeDelivery() { return parallelSpikeDelivery_; }
+	spikePropagation_t getSpikePropagation() { return spikePropagation_; }
+	bool isFusedStateUpdate() { return fusedStateUpdate_; }
+	bool isSTDPLookupTable() { return stdpLookupTable_; }
+	int getNumSpikeBufferOverflows() { return numSpikeBufferOverflows_; }
+
 	int getRandSeed() { return randSeed_; }
 
 	simMode_t getSimMode()		{ return simMode_; }
@@ -579,12 +611,21 @@ public:
 	//! temporary getter to return pointer to current[] \TODO replace with NeuronMonitor
 	float* getCurrent() { return current; }
 
-	std::vector< std::vector<float> > getWeightMatrix2D(short int connId);
+	/*!
+	 * \brief returns the synapses of a connection in CSR layout
+	 * The synapses of post-synaptic neuron j (relative to the group) are synPtr[j]...synPtr[j+1]-1, in the order
+	 * of preSynapticIds. preIds holds the pre-synaptic neuron ID (relative to the group) of every synapse.
+	 */
+	void getConnectionSynapses(short int connId, std::vector<int>& synPtr, std::vector<int>& preIds);
+
+	//! returns the weight magnitudes of a connection, in the order of getConnectionSynapses
+	void getConnectionWeights(short int connId, std::vector<float>& wts);
 
 	std::vector<float> getConductanceAMPA(int grpId);
 	std::vector<float> getConductanceNMDA(int grpId);
 	std::vector<float> getConductanceGABAa(int grpId);
 	std::vector<float> getConductanceGABAb(int grpId);
+	std::vector<float> getVoltage(int grpId);
 
 	//! temporary getter to return pointer to stpu[] \TODO replace with NeuronMonitor or ConnectionMonitor
 	float* getSTPu() { return stpu; }
@@ -609,6 +650,9 @@ public:
 	//! checks whether a point pre lies in the receptive field for point post
 	double getRFDist3D(const RadiusRF& radius, const Point3D& pre, const Point3D& post);
 	bool isPoint3DinRF(const RadiusRF& radius, const Point3D& pre, const Point3D& post);
+	void getRFGridBounds(const RadiusRF& radius, int grpId, const double scale[3], const Point3D& post, int first[3],
+		int last[3]);
+	int getRFGridMaxNeurons(const RadiusRF& radius, int grpId, const double scale[3]);
 
 	bool isSimulationWithCompartments() { return sim_with_compartments; }
 	bool isSimulationWithCOBA() { return sim_with_conductances; }
@@ -635,7 +679,8 @@ private:
 	void buildNetworkInit();
 
 	//! add the entry that the current neuron has spiked
-	int  addSpikeToTable(int id, int g);
+	void addSpikeToTable(int id, int g);
+	void checkSpikeBufferBudget();	//!< grows the spike budget if the spikes of this time step exceeded it (CPU only)
 
 	void buildGroup(int groupId);
 	void buildNetwork();
@@ -651,20 +696,56 @@ private:
 	void checkSpikeCounterRecordDur();
 
 	void compactConnections(); //!< minimize any other wastage in that array by compacting the store
-	void connectFull(grpConnectInfo_t* info);
-	void connectOneToOne(grpConnectInfo_t* info);
-	void connectRandom(grpConnectInfo_t* info);
-	void connectGaussian(grpConnectInfo_t* info);
+	//! builds all synapses of a connection of type random, full, full-no-direct, one-to-one, or gaussian
+	void buildConnection(grpConnectInfo_t* info);
+
+	//! CpuWorkerPool task that runs the current pass of buildConnection on the calling thread's share of post-neurons
+	static void buildConnectionWorker(void* snn, int threadId, int numThreads);
+
+	//! first pass of buildConnection: decides on all synapses onto the post-neurons [firstNId,lastNId)
+	void buildConnectionPreSynapses(int threadId, int firstNId, int lastNId);
+
+	//! second pass of buildConnection: appends the synapses onto [firstNId,lastNId) to the post-synaptic lists
+	void buildConnectionPostSynapses(int threadId, int firstNId, int lastNId);
+
+	//! finds the pre-neurons in the Grid3D box around the RF of postNId (random, gaussian: using geometric skip sampling)
+	void findPreCandidates(grpConnectInfo_t* info, const RadiusRF& radius, int postNId, const Point3D& post,
+		std::vector<int>& cand);
+
 	void connectUserDefined(grpConnectInfo_t* info);
 
 	void deleteObjects();			//!< deallocates all used data structures in snn_cpu.cpp
 
-	void doD1CurrentUpdate();
-	void doD2CurrentUpdate();
+	//! picks the push or pull engine for AUTO_PROPAGATION and sets up the data structures of the pull engine
+	void chooseSpikePropagation();
+
+	void doCurrentUpdate();			//!< delivers all spikes of this time step (calls doD1/doD2/doPullCurrentUpdate)
+	static void doCurrentUpdateWorker(void* snn, int threadId, int numThreads); //!< CpuWorkerPool task
+	void doD1CurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes);
+	void doD2CurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes);
+	void doPullCurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes);
 	void doGPUSim();
 	void doSnnSim();
 	void globalStateDecay();
 
+	//! decays the conductances, STP variables, and average firing rates of all neurons in [firstNId,lastNId)
+	void globalStateDecayNeurons(int firstNId, int lastNId);
+
+	//! CpuWorkerPool task that runs globalStateDecayNeurons on the calling thread's share of the neurons
+	static void globalStateDecayWorker(void* snn, int threadId, int numThreads);
+
+	//! signature of a per-group kernel that works on the neurons of group grpId that fall into [firstNId,lastNId)
+	//! (used for the decay and the weight update kernels)
+	typedef void (CpuSNN::*groupKernel_t)(int grpId, int firstNId, int lastNId);
+
+	//! decay kernel of a single group, specialized for the synapse model and the features the group uses
+	template<bool COBA, bool NMDA_RISE, bool GABAB_RISE, bool STP, bool HOMEO>
+	void decayNeurons(int grpId, int firstNId, int lastNId);
+
+	//! returns the instantiation of decayNeurons that matches the given flags
+	static groupKernel_t getDecayKernel(bool withConductances, bool withNMDARise, bool withGABAbRise,
+		bool withSTP, bool withHomeostasis);
+
 	void findFiring();
 	int findGrpId(int nid);//!< For the given neuron nid, find the group id
 
@@ -672,20 +753,70 @@ private:
 	//! this used to be in updateParameters
 	void findMaxNumSynapses(int* numPostSynapses, int* numPreSynapses);
 
-	void generatePostSpike(unsigned int pre_i, unsigned int idx_d, unsigned int offset, unsigned int tD);
+	void generatePostSpike(unsigned int pre_i, unsigned int syn_i, unsigned int pre_type, unsigned int tD,
+		int* numDASpikes);
+	float getSynapticChange(unsigned int pre_i, float weight, unsigned int tD); //!< weight modulated by STP
+	//! records the arrival of a pre-synaptic spike at synapse pos_i (spike time, dopamine, and STDP LTD)
+	void updateSynapseOnPreSpike(unsigned int post_i, unsigned int pos_i, unsigned int pre_type, int* numDASpikes);
 	void generateSpikes();
 	void generateSpikes(int grpId);
 	void generateSpikesFromFuncPtr(int grpId);
 	void generateSpikesFromRate(int grpId);
 
+	/*!
+	 * \brief draws the Poisson spikes of the neurons [firstNeur,lastNeur) of group grpId in the current time slice
+	 *
+	 * The inter-spike intervals (ISI) are drawn from an exponential distribution by inverting its CDF, shifted by the
+	 * refractory period (the exponential distribution is memoryless, so this is the same as rejecting all ISIs shorter
+	 * than the refractory period). The uniform numbers come from a counter-based RNG (see counter_rng.h) whose counter
+	 * is the neuron ID and the time of the previous spike, so a spike train depends only on the random seed and the
+	 * rates, not on the number of threads or the length of the time slices.
+	 * Neurons are processed in blocks of POISSON_BLOCK_SIZE: every round draws the next spike of all neurons of the
+	 * block that are still active (a branch-free loop that vectorizes), then drops the neurons that are done.
+	 * \param[in]  firstNeur first neuron, relative to the start of the group
+	 * \param[in]  lastNeur  one past the last neuron, relative to the start of the group
+	 * \param[out] spikes    the spikes are appended here, block by block and round by round
+	 */
+	void generateSpikesFromRateNeurons(int grpId, int firstNeur, int lastNeur, std::vector<poissonSpike_t>& spikes);
+
+	//! CpuWorkerPool task that runs generateSpikesFromRateNeurons on the calling thread's share of group poissonGrpId_
+	static void generateSpikesFromRateWorker(void* snn, int threadId, int numThreads);
+
 	//! stops the CPU/GPU timer and retrieves actual execution time for printSimSummary
 	float getActualExecutionTimeMs();
 
 	int getPoissNeuronPos(int nid);
-	float getWeights(int connProp, float initWt, float maxWt, unsigned int nid, int grpId);
+	//! initial weight of the synapse preNId->postNId of connection info (random weights are reproducible)
+	float getWeights(grpConnectInfo_t* info, unsigned int preNId, unsigned int postNId);
 
 	void globalStateUpdate();
 
+	//! integrates all regular neurons with IDs in [firstNId,lastNId) for a single integration step
+	//! if withDecay is set, the conductances (COBA) or currents (CUBA) are prepared for the next time step right after
+	//! they have been used (fused state update)
+	void globalStateUpdateNeurons(int firstNId, int lastNId, bool withDecay);
+
+	//! CpuWorkerPool task that runs globalStateUpdateNeurons on the calling thread's share of the neurons
+	static void globalStateUpdateWorker(void* snn, int threadId, int numThreads);
+
+	//! same as globalStateUpdateWorker, but with withDecay set (last integration step of the fused state update)
+	static void globalStateUpdateDecayWorker(void* snn, int threadId, int numThreads);
+
+	//! points the arguments of a neuron state update kernel to the neurons [startN,endN] of group grpId
+	void setIzhikevichKernelArgs(int grpId, int startN, int endN, IzhikevichKernelArgs& args);
+
+	//! picks the decay, neuron state update, and weight update kernels of every group (called once from setupNetwork)
+	void initNeuronKernels();
+
+	//! samples the exponential STDP curves of every group at every integer ms (called once from setupNetwork)
+	void initSTDPLookupTables();
+
+	//! fills lut with STDP(t,a,tauInv) for all t with t*tauInv < 25 (or leaves it empty if the table is disabled)
+	void buildSTDPExpCurveLUT(stdpExpCurveLUT_t& lut, float a, float tauInv);
+
+	//! returns STDP(t,a,tauInv), taken from the lookup table lut if it has a sample for t
+	double stdpExpCurve(const stdpExpCurveLUT_t& lut, int t, float a, float tauInv);
+
 	//! initialize all the synaptic weights to appropriate values.
 	//! total size of the synaptic connection is 'length'
 	void initSynapticWeights();
@@ -708,25 +839,6 @@ private:
 	//! creates CPU net pointers
 	void makePtrInfo();
 
-	/*!
-	 * \brief generates spike times according to a Poisson process
-	 *
-	 * This function generates the next spike time for a Poisson spike generator, given the current spike time
-	 * <tt>currTime</tt>. The function is used in generateSpikesFromRate.
-	 * A Poisson process will always generate inter-spike-interval (ISI) values from an exponential distribution.
-     * The time between each pair of consecutive events has an exponential distribution with parameter \lambda and
-     * each of these ISI values is assumed to be independent of other ISI values.
-     * What follows a Poisson distribution is the actual number of spikes sent during a certain interval.
-     *
-     * The refractory period (in ms) will assert that all spike pairs are at least <tt>refractPeriod</tt> milliseconds
-     * apart (inclusive). That is, the ISI generated from an exponential distribution will be discarded if it turns
-     * out that ISI < refractPeriod
-     * \param[in] currTime       time of current (or "last") spike
-     * \param[in] frate          mean firing rate to be achieved (same as \lambda of the exponential distribution)
-     * \param[in] refractPeriod  refractory period to be honored (in ms)
-     * \returns next spike time (current time plus generated ISI)
-     */
-	unsigned int poissonSpike(unsigned int currTime, float frate, int refractPeriod);
 
 	// NOTE: all these printer functions should be in printSNNInfo.cpp
 	// FIXME: are any of these actually supposed to be public?? they are not yet in carlsim.h
@@ -747,6 +859,7 @@ private:
 	int loadSimulation_internal(bool onlyPlastic);
 
 	void reorganizeDelay();
+	void reorganizeDelivery();	//!< builds the structure-of-arrays copy of the synapses used for spike delivery
 	void reorganizeNetwork(bool removeTempMemory);
 
 	void resetConductances();
@@ -775,9 +888,11 @@ private:
 	void startCPUTiming();
 	void stopCPUTiming();
 
+	void syncDeliveryWeights();	//!< refreshes synWt from wt (only the plastic synapses if possible)
 	void swapConnections(int nid, int oldPos, int newPos);
 
 	void updateAfterMaxTime();
+	void updateFiringBitmap();		//!< marks the neurons that fired in this time step (only for PULL_PROPAGATION)
 	void updateFiringTable();
 	void updateSpikesFromGrp(int grpId);
 	void updateSpikeGenerators();
@@ -794,6 +909,19 @@ private:
 
 	void updateWeights();
 
+	//! applies the accumulated weight changes to the plastic synapses of all post-synaptic neurons in [firstNId,lastNId)
+	void updateWeightsNeurons(int firstNId, int lastNId);
+
+	//! CpuWorkerPool task that runs updateWeightsNeurons on the calling thread's share of the neurons
+	static void updateWeightsWorker(void* snn, int threadId, int numThreads);
+
+	//! weight update kernel of a single group, specialized for its E-STDP and I-STDP type and homeostasis
+	template<stdpType_t ESTDP_TYPE, stdpType_t ISTDP_TYPE, bool HOMEO>
+	void updateWeightsGroup(int grpId, int firstNId, int lastNId);
+
+	//! returns the instantiation of updateWeightsGroup that matches the given flags
+	static groupKernel_t getWeightUpdateKernel(stdpType_t estdpType, stdpType_t istdpType, bool withHomeostasis);
+
 
 	// +++++ GPU MODE +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ //
 	// TODO: consider moving to snn_gpu.h
@@ -912,6 +1040,48 @@ private:
 	const int ithGPU_;				//!< on which CUDA device to establish a context (only in GPU_MODE)
 	const int randSeed_;			//!< random number seed to use
 
+	int numThreads_;				//!< number of worker threads (only in CPU_MODE_MT)
+	CpuWorkerPool* cpuWorkers_;		//!< persistent worker threads (only in CPU_MODE_MT)
+	bool parallelSpikeDelivery_;	//!< whether to deliver spikes on all worker threads (only in CPU_MODE_MT)
+	int* grpDASpikeCnt;				//!< number of dopaminergic spikes delivered to each group, per thread
+	std::vector<poissonSpike_t>* poissonSpikeBuf;	//!< Poisson spikes drawn by each thread in the current time slice
+	int poissonGrpId_;				//!< group whose Poisson spikes the worker threads are drawing
+
+	grpConnectInfo_t* connBuildInfo_;	//!< connection that the worker threads are building (see buildConnection)
+	int connBuildPass_;				//!< current pass of buildConnection (0: pre-synaptic, 1: post-synaptic)
+	std::vector<Point3D> connBuildPreLoc_;	//!< location of every pre-neuron of connBuildInfo_
+	double connBuildScalePre_[3];	//!< scaling of the pre-neuron locations of connBuildInfo_ (only for gaussian)
+	int* connBuildCnt_;				//!< per thread and pre-neuron: number of new synapses, then next post-synaptic slot
+	int* connBuildFirstSlot_;		//!< first new pre-synaptic slot of every post-neuron of connBuildInfo_
+	int* connBuildOverflow_;		//!< per thread: post-neuron whose pre-synaptic slots ran out, or -1
+	std::vector<int>* connBuildCand_;	//!< per thread: candidate pre-neurons of the current post-neuron
+	uint8_t* connBuildDelay_;		//!< delay of every pre-synaptic slot, while the network is being built
+
+	spikePropagation_t spikePropagation_;	//!< spike propagation engine (AUTO is resolved in setupNetwork)
+	float expectedFiringRate_;		//!< expected mean firing rate (Hz) used by the cost model of AUTO_PROPAGATION
+	uint8_t* preSynDelay;			//!< delay-1 of every pre-synaptic connection (only for PULL_PROPAGATION)
+	uint32_t* firingBitmap;			//!< ring of maxDelay_ bitmaps of the neurons that fired (only for PULL_PROPAGATION)
+	int firingBitmapWords_;			//!< number of 32-bit words per bitmap in firingBitmap
+
+	std::vector<unsigned int>* firingRingD1;	//!< ring of per-ms lists of fired neurons with max delay 1 (CPU only)
+	std::vector<unsigned int>* firingRingD2;	//!< ring of per-ms lists of fired neurons with max delay 2+ (CPU only)
+	int firingRingSize_;			//!< number of ms slots in firingRingD1 and firingRingD2
+	unsigned int spikeBudgetD1_;	//!< number of spikes per ms that every list in firingRingD1 is reserved for
+	unsigned int spikeBudgetD2_;	//!< number of spikes per ms that every list in firingRingD2 is reserved for
+	int numSpikeBufferOverflows_;	//!< number of time steps in which the spikes exceeded spikeBudgetD1_/D2_
+
+	simdLevel_t simdLevel_;			//!< instruction set used by the neuron state update kernels
+	bool fusedStateUpdate_;			//!< whether conductances are decayed by globalStateUpdate (CPU only)
+	bool stdpLookupTable_;			//!< whether to use the STDP lookup tables below (CPU only)
+	stdpExpCurveLUT_t* grpLTPExcLUT;	//!< E-STDP LTP curve of every group (ALPHA_PLUS_EXC, TAU_PLUS_INV_EXC)
+	stdpExpCurveLUT_t* grpLTDExcLUT;	//!< E-STDP LTD curve of every group (ALPHA_MINUS_EXC, TAU_MINUS_INV_EXC)
+	stdpExpCurveLUT_t* grpLTPInbLUT;	//!< I-STDP LTP curve of every group (ALPHA_PLUS_INB, TAU_PLUS_INV_INB)
+	stdpExpCurveLUT_t* grpLTDInbLUT;	//!< I-STDP LTD curve of every group (ALPHA_MINUS_INB, TAU_MINUS_INV_INB)
+	groupKernel_t* grpDecayKernel;	//!< decay kernel of every group (CPU only)
+	groupKernel_t* grpFusedDecayKernel;	//!< conductance decay kernel of every group (fused state update only)
+	groupKernel_t* grpWeightKernel;	//!< weight update kernel of every group, NULL if its weights are fixed (CPU only)
+	izhikevichKernel_t* grpIzhKernel;	//!< neuron state update kernel of every group (CPU only)
+	float* compCurrent;				//!< buffer for the compartmental currents (only if there are compartments)
 
 	//! temporary variables created and deleted by network after initialization
 	uint8_t			*tmp_SynapticDelay;
@@ -996,7 +1166,11 @@ private:
 	//! Keeps track of all neurons that spiked at current time.
 	//! Because integration step can be < 1ms we might want to keep integrating but remember that the neuron fired,
 	//! so that we don't produce more than 1 spike per ms.
+	//! The bool array is only used by GPU_MODE, the CPU keeps the same information in the bitset curSpikeBits
+	//! (SPIKE_BITS_PER_WORD neurons per word), so that findFiring does not have to look at every neuron.
 	bool			*curSpike;
+	uint64_t		*curSpikeBits;
+	int				curSpikeWords_;	//!< number of words in curSpikeBits
 	int         	*nSpikeCnt;     //!< spike counts per neuron
 	unsigned short       	*Npre;			//!< stores the number of input connections to the neuron
 	unsigned short			*Npre_plastic;	//!< stores the number of excitatory input connection to the input
@@ -1019,6 +1193,19 @@ private:
 	post_info_t		*postSynapticIds;		//!< 10 bit syn id, 22 bit neuron id, ordered based on delay
 	delay_info_t    *postDelayInfo;      	//!< delay information
 
+	//! structure-of-arrays copy of the synapses used for spike delivery (only for PUSH_PROPAGATION on the CPU)
+	//! these are stored in the same (delay-sorted) order as postSynapticIds, so that the synapses of a pre-neuron with
+	//! the same delay form a contiguous block
+	unsigned int	*synPostNId;		//!< post-synaptic neuron id
+	unsigned int	*synPrePos;			//!< position of the synapse in the pre-synaptic arrays (wt, wtChange, etc.)
+	float			*synWt;				//!< copy of wt[synPrePos[i]], refreshed whenever synWtDirty_ is set
+	float			*synMulFast;		//!< mulSynFast of the connection
+	float			*synMulSlow;		//!< mulSynSlow of the connection
+	unsigned int	*synPlastic;		//!< indices (into the arrays above) of all plastic synapses, in ascending order
+	unsigned int	numSynPlastic_;		//!< number of entries in synPlastic
+	bool			synWtDirty_;		//!< whether wt has changed since synWt was last refreshed
+	bool			synPlasticWtDirty_;	//!< whether only plastic weights have changed since synWt was last refreshed
+
 	//! size of memory used for different parts of the network
 	typedef struct snnSize_s {
 		unsigned int		neuronInfoSize;
@@ -1036,7 +1223,7 @@ private:
 	unsigned int 	postConnCnt;
 	unsigned int	preConnCnt;
 
-	//! firing info
+	//! firing info (only used in GPU_MODE, the CPU keeps its spikes in firingRingD1 and firingRingD2)
 	unsigned int		*timeTableD2;
 	unsigned int		*timeTableD1;
 	unsigned int		*firingTableD2;
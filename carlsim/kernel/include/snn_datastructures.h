@@ -60,6 +60,18 @@ typedef struct {
 	uint8_t	grpId;
 } post_info_t;
 
+//! exponential STDP curve STDP(t,a,tauInv), sampled at every integer ms t for which t*tauInv < 25 (CPU only)
+typedef struct stdpExpCurveLUT_s {
+	double*	values;		//!< values[t] = STDP(t,a,tauInv), in the same precision as STDP() itself
+	int		length;		//!< number of samples (0 if the lookup table is disabled)
+} stdpExpCurveLUT_t;
+
+//! a spike drawn by the Poisson generator, before it is scheduled in the propagated spike buffer
+typedef struct poissonSpike_s {
+	int				nid;	//!< neuron ID relative to the start of the group
+	unsigned int	time;	//!< spike time (ms)
+} poissonSpike_t;
+
 
 //! network information structure
 /*!
@@ -381,6 +393,8 @@ typedef struct group_info2_s {
 	int			maxPreConn;
 	int			sumPostConn;
 	int			sumPreConn;
+
+	float		spikeBufferRate;	//!< firing rate (Hz) the CPU spike buffers are initially sized for
 } group_info2_t;
 
 #endif
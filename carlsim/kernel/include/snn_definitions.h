@@ -139,6 +139,7 @@ inline bool isInhibitoryNeuron (unsigned int& nid, unsigned int& numNInhPois, un
 #define POISSON_MAX_FIRING_RATE 	  		1000
 
 #define STDP(t,a,b)       ((a)*exp(-(t)*(b))) // consider to use __expf(), which is accelerated by GPU hardware
+#define STDP_LUT_MAX_LENGTH 100000 // max number of samples in an STDP lookup table (longer curves fall back to STDP)
 
 #define PROPAGATED_BUFFER_SIZE  (1023)
 #define MAX_SIMULATION_TIME     ((uint32_t)(0x7fffffff))
@@ -146,8 +147,35 @@ inline bool isInhibitoryNeuron (unsigned int& nid, unsigned int& numNInhPois, un
 
 
 #define MAX_SPIKE_MON_BUFFER_SIZE 52428800 // about 50 MB. size is in bytes. Max size of reduced AER vector in spikeMonitorCore objects.
+#define MAX_SPIKE_MON_GROUP_SIZE (1 << 22) // max number of neurons in a group with a SpikeMonitor (SpikeStore keeps neuron IDs in 22 bits)
 #define LONG_SPIKE_MON_DURATION 600000 // about 10 minutes
 #define LARGE_SPIKE_MON_GRP_SIZE 5000 // about 10 minutes
+#define SPIKE_FILE_BLOCK_SIZE 1048576 // 1 MB. size is in bytes. Size of the blocks in which spike files are written to disk.
+#define CONN_FILE_KEYFRAME_INTERVAL 60 // number of snapshots. A delta-encoded connect file stores all weights every 60 snapshots.
+#define CONN_FILE_WEIGHT_RESOLUTION 1e-4f // relative to the max weight. Resolution of weight changes in delta-encoded connect files.
+
+// rough relative costs used by AUTO_PROPAGATION to choose between the push and pull engines:
+// push pays a scattered read-modify-write of the post-synaptic state for every delivered spike, whereas pull pays a
+// sequential bitmap test for every synapse (spiking or not) plus one write of the conductances per post-neuron
+#define PUSH_COST_PER_SPIKE_SYN		10.0f
+#define PULL_COST_PER_SYN			1.0f
+#define PULL_COST_PER_NEURON		4.0f
+
+// number of neurons that the fused state update integrates before decaying their conductances, small enough for the
+// conductances of a block to still be in the L1 cache when they are decayed
+#define FUSED_UPDATE_BLOCK_SIZE		256
+
+// number of Poisson neurons whose spike times are drawn together, in rounds of one spike per neuron
+#define POISSON_BLOCK_SIZE			256
+
+// streams of the counter-based RNG (see counter_rng.h): the key is the random seed and a stream ID made of the type
+// of the stream (upper 8 bits) and a group or connection ID (lower 24 bits)
+#define RNG_STREAM_POISSON			1	// Poisson spike times per group, addressed by (neuron, time of last spike)
+#define RNG_STREAM_SYNAPSES			2	// existence and delay of synapses per connection, addressed by (pre, post)
+#define RNG_STREAM_WEIGHTS			3	// random initial weights per connection, addressed by (pre, post)
+#define RNG_STREAM_NEURONS			4	// random neuron parameters per group, addressed by (neuron, parameter)
+#define RNG_STREAM_SYNAPSE_GAPS		5	// gaps between random synapses per connection, addressed by (post, draw)
+#define RNG_STREAM_ID(type, id)		((((uint32_t)(type)) << 24) | (((uint32_t)(id)) & 0xFFFFFF))
 
 // This flag is used when having a common poisson generator for both CPU and GPU simulation
 // We basically use the CPU poisson generator. Evaluate if there is any firing due to the
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+#ifndef _VARINT_H_
+#define _VARINT_H_
+
+#include <stdint.h>
+
+//! maximum number of bytes of a varint-encoded uint32_t
+#define MAX_VARINT_BYTES 5
+
+/*!
+ * \brief encodes an unsigned integer as varint
+ *
+ * The value is written in groups of 7 bits, least significant group first, with the high bit set on all but the
+ * last byte. Used by the compact spike file and the delta-encoded connect file.
+ * \param[out] buf buffer with room for at least MAX_VARINT_BYTES bytes
+ * \param[in]  val the value to encode
+ * \returns the number of bytes written
+ */
+inline int encodeVarint(unsigned char* buf, uint32_t val) {
+	int numBytes = 0;
+	while (val >= 0x80) {
+		buf[numBytes++] = (unsigned char)(val | 0x80);
+		val >>= 7;
+	}
+	buf[numBytes++] = (unsigned char)val;
+	return numBytes;
+}
+
+//! maps a signed integer to an unsigned one, so that values close to zero have short varints (zig-zag encoding)
+inline uint32_t zigZagEncode(int32_t val) {
+	return ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+}
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#include <cpu_worker_pool.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#if !defined(WIN32) && !defined(WIN64)
+	#include <unistd.h>
+#endif
+
+CpuWorkerPool::CpuWorkerPool(int numThreads) {
+	assert(numThreads>=1);
+	task_ = NULL;
+	taskArg_ = NULL;
+
+#if defined(WIN32) || defined(WIN64)
+	numThreads_ = 1;
+#else
+	numThreads_ = numThreads;
+	generation_ = 0;
+	numBusy_ = 0;
+	shutdown_ = false;
+
+	pthread_mutex_init(&mutex_, NULL);
+	pthread_cond_init(&startCond_, NULL);
+	pthread_cond_init(&doneCond_, NULL);
+
+	// the calling thread is worker 0, so we only need to spawn the rest
+	threads_ = new pthread_t[numThreads_];
+	workerInfo_ = new workerInfo_t[numThreads_];
+	for (int t=1; t<numThreads_; t++) {
+		workerInfo_[t].pool = this;
+		workerInfo_[t].threadId = t;
+		if (pthread_create(&threads_[t], NULL, &CpuWorkerPool::workerLoop, &workerInfo_[t])) {
+			// could not spawn thread: continue with the ones we have
+			numThreads_ = t;
+			break;
+		}
+	}
+#endif
+}
+
+CpuWorkerPool::~CpuWorkerPool() {
+#if !defined(WIN32) && !defined(WIN64)
+	pthread_mutex_lock(&mutex_);
+	shutdown_ = true;
+	pthread_cond_broadcast(&startCond_);
+	pthread_mutex_unlock(&mutex_);
+
+	for (int t=1; t<numThreads_; t++)
+		pthread_join(threads_[t], NULL);
+
+	delete[] threads_;
+	delete[] workerInfo_;
+
+	pthread_cond_destroy(&doneCond_);
+	pthread_cond_destroy(&startCond_);
+	pthread_mutex_destroy(&mutex_);
+#endif
+}
+
+void CpuWorkerPool::run(workerTask_t task, void* arg) {
+	assert(task!=NULL);
+
+	if (numThreads_==1) {
+		task(arg, 0, 1);
+		return;
+	}
+
+#if !defined(WIN32) && !defined(WIN64)
+	// publish the task and wake up all workers
+	pthread_mutex_lock(&mutex_);
+	task_ = task;
+	taskArg_ = arg;
+	numBusy_ = numThreads_-1;
+	generation_++;
+	pthread_cond_broadcast(&startCond_);
+	pthread_mutex_unlock(&mutex_);
+
+	// do our own share
+	task(arg, 0, numThreads_);
+
+	// wait for the others
+	pthread_mutex_lock(&mutex_);
+	while (numBusy_>0)
+		pthread_cond_wait(&doneCond_, &mutex_);
+	pthread_mutex_unlock(&mutex_);
+#endif
+}
+
+void CpuWorkerPool::getPartition(int numItems, int threadId, int numThreads, int& first, int& last) {
+	assert(numThreads>=1 && threadId>=0 && threadId<numThreads);
+
+	// the first (numItems % numThreads) chunks get one extra item
+	int chunkSize = numItems/numThreads;
+	int remainder = numItems%numThreads;
+	first = threadId*chunkSize + (threadId<remainder ? threadId : remainder);
+	last = first + chunkSize + (threadId<remainder ? 1 : 0);
+}
+
+int CpuWorkerPool::getNumProcessors() {
+#if defined(WIN32) || defined(WIN64)
+	return 1;
+#else
+	long numProcs = sysconf(_SC_NPROCESSORS_ONLN);
+	return (numProcs>0) ? (int)numProcs : 1;
+#endif
+}
+
+void* CpuWorkerPool::workerLoop(void* arg) {
+#if !defined(WIN32) && !defined(WIN64)
+	workerInfo_t* info = (workerInfo_t*)arg;
+	CpuWorkerPool* pool = info->pool;
+	unsigned long lastGeneration = 0;
+
+	pthread_mutex_lock(&pool->mutex_);
+	while (true) {
+		while (pool->generation_==lastGeneration && !pool->shutdown_)
+			pthread_cond_wait(&pool->startCond_, &pool->mutex_);
+		if (pool->shutdown_)
+			break;
+
+		lastGeneration = pool->generation_;
+		workerTask_t task = pool->task_;
+		void* taskArg = pool->taskArg_;
+		pthread_mutex_unlock(&pool->mutex_);
+
+		task(taskArg, info->threadId, pool->numThreads_);
+
+		pthread_mutex_lock(&pool->mutex_);
+		if (--pool->numBusy_==0)
+			pthread_cond_signal(&pool->doneCond_);
+	}
+	pthread_mutex_unlock(&pool->mutex_);
+#endif
+	return NULL;
+}
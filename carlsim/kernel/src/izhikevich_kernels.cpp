@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#include <izhikevich_kernels.h>
+
+#include <stdlib.h>
+
+const char* simdLevel_string[] = {
+	"scalar", "AVX2", "AVX-512"
+};
+
+// The SIMD kernels rely on GCC vector extensions and function-level target attributes, so that the rest of the
+// library can still be compiled for a generic x86-64 and the instruction set can be picked at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__CUDACC__)
+	#define IZH_WITH_X86_SIMD
+	#include <immintrin.h>
+#endif
+
+// Every instruction set must compute bit-identical voltages, so that a simulation does not depend on the CPU it runs
+// on. With -ffast-math (release build), the compiler would be free to reassociate the arithmetic and to contract it
+// into FMA instructions differently for every vector width.
+#if defined(__clang__)
+	#pragma clang fp contract(off) reassociate(off)
+#elif defined(__GNUC__)
+	#pragma GCC optimize("no-fast-math", "fp-contract=off")
+#endif
+
+
+// -------------------------------------------------------------------------------------------------------------------
+// scalar kernels (always available)
+// -------------------------------------------------------------------------------------------------------------------
+namespace izh_scalar {
+	struct Ops {
+		typedef float vec;
+		typedef bool mask;
+		static const int WIDTH = 1;
+
+		static inline vec set1(float x) { return x; }
+		static inline vec load(const float* ptr, int) { return *ptr; }
+		static inline void store(float* ptr, vec x, int) { *ptr = x; }
+		static inline mask gt(vec x, vec y) { return x > y; }
+		static inline mask lt(vec x, vec y) { return x < y; }
+		static inline vec select(mask m, vec x, vec y) { return m ? x : y; }
+		static inline unsigned int bits(mask m) { return m ? 1u : 0u; }
+	};
+
+	#define IZH_TARGET
+	#include "izhikevich_kernels.inc"
+	#undef IZH_TARGET
+}
+
+
+#ifdef IZH_WITH_X86_SIMD
+// -------------------------------------------------------------------------------------------------------------------
+// AVX2 kernels: 8 neurons per instruction
+// -------------------------------------------------------------------------------------------------------------------
+namespace izh_avx2 {
+	#define IZH_TARGET __attribute__((target("avx2")))
+	#define IZH_INLINE __attribute__((target("avx2"), always_inline))
+
+	struct Ops {
+		typedef __m256 vec;
+		typedef __m256 mask;
+		static const int WIDTH = 8;
+
+		// lanes [0,n) are enabled
+		static inline IZH_INLINE __m256i tailMask(int n) {
+			return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		}
+
+		static inline IZH_INLINE vec set1(float x) { return _mm256_set1_ps(x); }
+		static inline IZH_INLINE vec load(const float* ptr, int n) {
+			return (n == WIDTH) ? _mm256_loadu_ps(ptr) : _mm256_maskload_ps(ptr, tailMask(n));
+		}
+		static inline IZH_INLINE void store(float* ptr, vec x, int n) {
+			if (n == WIDTH)
+				_mm256_storeu_ps(ptr, x);
+			else
+				_mm256_maskstore_ps(ptr, tailMask(n), x);
+		}
+		static inline IZH_INLINE mask gt(vec x, vec y) { return _mm256_cmp_ps(x, y, _CMP_GT_OQ); }
+		static inline IZH_INLINE mask lt(vec x, vec y) { return _mm256_cmp_ps(x, y, _CMP_LT_OQ); }
+		static inline IZH_INLINE vec select(mask m, vec x, vec y) { return _mm256_blendv_ps(y, x, m); }
+		static inline IZH_INLINE unsigned int bits(mask m) { return (unsigned int)_mm256_movemask_ps(m); }
+	};
+
+	#include "izhikevich_kernels.inc"
+	#undef IZH_TARGET
+	#undef IZH_INLINE
+}
+
+// -------------------------------------------------------------------------------------------------------------------
+// AVX-512 kernels: 16 neurons per instruction
+// -------------------------------------------------------------------------------------------------------------------
+namespace izh_avx512 {
+	#define IZH_TARGET __attribute__((target("avx512f")))
+	#define IZH_INLINE __attribute__((target("avx512f"), always_inline))
+
+	struct Ops {
+		typedef __m512 vec;
+		typedef __mmask16 mask;
+		static const int WIDTH = 16;
+
+		static inline IZH_INLINE vec set1(float x) { return _mm512_set1_ps(x); }
+		static inline IZH_INLINE vec load(const float* ptr, int n) {
+			return (n == WIDTH) ? _mm512_loadu_ps(ptr) : _mm512_maskz_loadu_ps((__mmask16)((1u << n) - 1u), ptr);
+		}
+		static inline IZH_INLINE void store(float* ptr, vec x, int n) {
+			if (n == WIDTH)
+				_mm512_storeu_ps(ptr, x);
+			else
+				_mm512_mask_storeu_ps(ptr, (__mmask16)((1u << n) - 1u), x);
+		}
+		static inline IZH_INLINE mask gt(vec x, vec y) { return _mm512_cmp_ps_mask(x, y, _CMP_GT_OQ); }
+		static inline IZH_INLINE mask lt(vec x, vec y) { return _mm512_cmp_ps_mask(x, y, _CMP_LT_OQ); }
+		static inline IZH_INLINE vec select(mask m, vec x, vec y) { return _mm512_mask_blend_ps(m, y, x); }
+		static inline IZH_INLINE unsigned int bits(mask m) { return (unsigned int)m; }
+	};
+
+	#include "izhikevich_kernels.inc"
+	#undef IZH_TARGET
+	#undef IZH_INLINE
+}
+#endif
+
+
+simdLevel_t getSupportedSimdLevel() {
+#ifdef IZH_WITH_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+#endif
+	return SIMD_SCALAR;
+}
+
+izhikevichKernel_t getIzhikevichKernel(simdLevel_t simdLevel, integrationMethod_t method, bool withParamModel_9,
+	bool withConductances, bool withNMDARise, bool withGABAbRise, bool withCompartments)
+{
+#ifdef IZH_WITH_X86_SIMD
+	if (simdLevel == SIMD_AVX512)
+		return izh_avx512::getKernel(method, withParamModel_9, withConductances, withNMDARise, withGABAbRise,
+			withCompartments);
+	if (simdLevel == SIMD_AVX2)
+		return izh_avx2::getKernel(method, withParamModel_9, withConductances, withNMDARise, withGABAbRise,
+			withCompartments);
+#endif
+	return izh_scalar::getKernel(method, withParamModel_9, withConductances, withNMDARise, withGABAbRise,
+		withCompartments);
+}
@@ -50,11 +50,13 @@
 #include <stdlib.h> 	// abs, drand48
 #include <algorithm> 	// std::min, std::max
 #include <limits.h> 	// UINT_MAX
+#include <counter_rng.h>	// threefry2x32
 
 #include <connection_monitor.h>
 #include <connection_monitor_core.h>
 #include <spike_monitor.h>
 #include <spike_monitor_core.h>
+#include <spike_file_writer.h>
 #include <group_monitor.h>
 #include <group_monitor_core.h>
 
@@ -144,22 +146,35 @@ short int CpuSNN::connect(int grpId1, int grpId2, const std::string& _type, floa
 	newInfo->next 				= connectBegin; //linked list of connection..
 	connectBegin 				= newInfo;
 
+	// a neuron can only connect to the neurons in the Grid3D box around its RF (for gaussian: the pre-neuron locations
+	// are scaled to the grid of the post-group, see buildConnection)
+	RadiusRF radius(radX, radY, radZ);
+	double noScale[3] = {1.0, 1.0, 1.0};
+	double scalePre[3] = {1.0, 1.0, 1.0};
+	if (_type.find("gaussian") != std::string::npos) {
+		scalePre[0] = 1.0*grp_Info[grpId2].SizeX/grp_Info[grpId1].SizeX;
+		scalePre[1] = 1.0*grp_Info[grpId2].SizeY/grp_Info[grpId1].SizeY;
+		scalePre[2] = 1.0*grp_Info[grpId2].SizeZ/grp_Info[grpId1].SizeZ;
+	}
+	int numPostInRF = getRFGridMaxNeurons(radius, grpId2, noScale);
+	int numPreInRF = getRFGridMaxNeurons(radius, grpId1, scalePre);
+
 	if ( _type.find("random") != std::string::npos) {
 		newInfo->type 	= CONN_RANDOM;
-		newInfo->numPostSynapses = (std::min)(grp_Info[grpId2].SizeN,((int) (prob*grp_Info[grpId2].SizeN +6.5*sqrt(prob*(1-prob)*grp_Info[grpId2].SizeN)+0.5))); // estimate the maximum number of connections we need.  This uses a binomial distribution at 6.5 stds.
-		newInfo->numPreSynapses = (std::min)(grp_Info[grpId1].SizeN,((int) (prob*grp_Info[grpId1].SizeN +6.5*sqrt(prob*(1-prob)*grp_Info[grpId1].SizeN)+0.5))); // estimate the maximum number of connections we need.  This uses a binomial distribution at 6.5 stds.
+		newInfo->numPostSynapses = (std::min)(numPostInRF,((int) (prob*numPostInRF +6.5*sqrt(prob*(1-prob)*numPostInRF)+0.5))); // estimate the maximum number of connections we need.  This uses a binomial distribution at 6.5 stds.
+		newInfo->numPreSynapses = (std::min)(numPreInRF,((int) (prob*numPreInRF +6.5*sqrt(prob*(1-prob)*numPreInRF)+0.5))); // estimate the maximum number of connections we need.  This uses a binomial distribution at 6.5 stds.
 	}
 	//so you're setting the size to be prob*Number of synapses in group info + some standard deviation ...
 	else if ( _type.find("full-no-direct") != std::string::npos) {
 		newInfo->type 	= CONN_FULL_NO_DIRECT;
-		newInfo->numPostSynapses = grp_Info[grpId2].SizeN-1;
-		newInfo->numPreSynapses	= grp_Info[grpId1].SizeN-1;
+		newInfo->numPostSynapses = (std::min)(numPostInRF, grp_Info[grpId2].SizeN-1);
+		newInfo->numPreSynapses	= (std::min)(numPreInRF, grp_Info[grpId1].SizeN-1);
 	}
 	else if ( _type.find("full") != std::string::npos) {
 		newInfo->type 	= CONN_FULL;
 
-		newInfo->numPostSynapses = grp_Info[grpId2].SizeN;
-		newInfo->numPreSynapses = grp_Info[grpId1].SizeN;
+		newInfo->numPostSynapses = numPostInRF;
+		newInfo->numPreSynapses = numPreInRF;
 	}
 	else if ( _type.find("one-to-one") != std::string::npos) {
 		newInfo->type 	= CONN_ONE_TO_ONE;
@@ -167,9 +182,8 @@ short int CpuSNN::connect(int grpId1, int grpId2, const std::string& _type, floa
 		newInfo->numPreSynapses	= 1;
 	} else if ( _type.find("gaussian") != std::string::npos) {
 		newInfo->type   = CONN_GAUSSIAN;
-		// the following is antiquated, just assume the worst case for now
-		newInfo->numPostSynapses = grp_Info[grpId2].SizeN;
-		newInfo->numPreSynapses = grp_Info[grpId1].SizeN;
+		newInfo->numPostSynapses = numPostInRF;
+		newInfo->numPreSynapses = numPreInRF;
 	} else {
 		KERNEL_ERROR("Invalid connection type (should be 'random', 'full', 'one-to-one', 'full-no-direct', or 'gaussian')");
 		exitSimulation(-1);
@@ -475,6 +489,57 @@ void CpuSNN::setIntegrationMethod(integrationMethod_t method, int numStepsPerMs)
 	timeStep_ = 1.0f / simNumStepsPerMs_;
 }
 
+void CpuSNN::setParallelSpikeDelivery(bool isSet) {
+	parallelSpikeDelivery_ = isSet;
+}
+
+void CpuSNN::setSpikePropagation(spikePropagation_t engine, float expectedFiringRate) {
+	assert(expectedFiringRate >= 0.0f);
+	assert(preSynDelay == NULL); // data structures of the pull engine are created in setupNetwork
+	spikePropagation_ = engine;
+	expectedFiringRate_ = expectedFiringRate;
+}
+
+void CpuSNN::setFusedStateUpdate(bool isSet) {
+	assert(grpDecayKernel == NULL); // kernels are picked in setupNetwork
+	fusedStateUpdate_ = isSet;
+}
+
+void CpuSNN::setSTDPLookupTable(bool isSet) {
+	assert(grpLTPExcLUT == NULL); // tables are built in setupNetwork
+	stdpLookupTable_ = isSet;
+}
+
+void CpuSNN::setSIMDKernels(bool isSet) {
+	assert(grpIzhKernel == NULL); // kernels are picked in setupNetwork
+	simdLevel_ = isSet ? getSupportedSimdLevel() : SIMD_SCALAR;
+}
+
+// sets the firing rate the spike buffers of a group are sized for
+void CpuSNN::setSpikeBufferBudget(int grpId, float firingRate) {
+	if (grpId == ALL) { // shortcut for all groups
+		for(int grpId1=0; grpId1<numGrp; grpId1++) {
+			setSpikeBufferBudget(grpId1, firingRate);
+		}
+	} else {
+		assert(firingRate >= 0.0f);
+
+		// the CPU lists grow on demand, so the budget only sets their initial size, whereas the firing tables on the
+		// GPU are allocated once for MaxFiringRate spikes per neuron and second
+		grp_Info2[grpId].spikeBufferRate = firingRate;
+		grp_Info[grpId].MaxFiringRate = (short int)std::max(1.0f, std::min(1000.0f, ceilf(firingRate)));
+
+		KERNEL_INFO("Spike buffer budget set for %d (%s):	firingRate: %3.3f",
+					grpId,grp_Info2[grpId].Name.c_str(),firingRate);
+	}
+}
+
+void CpuSNN::setNumThreads(int numThreads) {
+	assert(numThreads >= 1);
+	assert(cpuWorkers_ == NULL); // worker pool is created in setupNetwork
+	numThreads_ = numThreads;
+}
+
 // set Izhikevich parameters for group
 void CpuSNN::setNeuronParameters(int grpId, float izh_a, float izh_a_sd, float izh_b, float izh_b_sd,
 								float izh_c, float izh_c_sd, float izh_d, float izh_d_sd)
@@ -734,7 +799,7 @@ int CpuSNN::runNetwork(int _nsec, int _nmsec, bool printRunSummary, bool copySta
 	}
 
 	// reset all spike counters
-	if (simMode_==CPU_MODE) {
+	if (simMode_!=GPU_MODE) {
 		resetSpikeCnt(ALL);
 #ifndef __NO_CUDA__
 	} else {
@@ -767,7 +832,7 @@ int CpuSNN::runNetwork(int _nsec, int _nmsec, bool printRunSummary, bool copySta
 	// if nsec=0, simTimeMs=10, we need to run the simulator for 10 timeStep;
 	// if nsec=1, simTimeMs=10, we need to run the simulator for 1*1000+10, time Step;
 	for(int i=0; i<runDurationMs; i++) {
-		if(simMode_ == CPU_MODE) {
+		if(simMode_ != GPU_MODE) {
 			doSnnSim();
 #ifndef __NO_CUDA__
 		} else {
@@ -780,7 +845,7 @@ int CpuSNN::runNetwork(int _nsec, int _nmsec, bool printRunSummary, bool copySta
 			wtANDwtChangeUpdateIntervalCnt_ = 0; // reset counter
 			if (!sim_in_testing) {
 				// keep this if statement separate from the above, so that the counter is updated correctly
-				if (simMode_ == CPU_MODE) {
+				if (simMode_ != GPU_MODE) {
 					updateWeights();
 #ifndef __NO_CUDA__
 				} else{
@@ -803,7 +868,7 @@ int CpuSNN::runNetwork(int _nsec, int _nmsec, bool printRunSummary, bool copySta
 				updateConnectionMonitor();
 			}
 
-			if(simMode_ == CPU_MODE) {
+			if(simMode_ != GPU_MODE) {
 				updateFiringTable();
 #ifndef __NO_CUDA__
 			} else {
@@ -854,6 +919,10 @@ int CpuSNN::runNetwork(int _nsec, int _nmsec, bool printRunSummary, bool copySta
 	updateSpikeMonitor();
 	updateGroupMonitor();
 
+	// spike files are written in blocks: make sure all spikes are on disk when runNetwork returns
+	for (unsigned int i=0; i<numSpikeMonitor; i++)
+		spikeMonCoreList[i]->flushSpikeFile();
+
 	// keep track of simulation time...
 #ifndef __NO_CUDA__
 	CUDA_STOP_TIMER(timer);
@@ -933,6 +1002,8 @@ void CpuSNN::biasWeights(short int connId, float bias, bool updateWeightRange) {
 		}
 #endif
 	}
+
+	synWtDirty_ = true;
 }
 
 // deallocates dynamical structures and exits
@@ -964,7 +1035,7 @@ void CpuSNN::resetSpikeCounter(int grpId) {
 
 		grp_Info[grpId].spkCntRecordDurHelper = 0;
 
-		if (simMode_==CPU_MODE) {
+		if (simMode_!=GPU_MODE) {
 			int bufPos = grp_Info[grpId].spkCntBufPos; // retrieve buf pos
 			memset(spkCntBuf[bufPos],0,grp_Info[grpId].SizeN*sizeof(int)); // set all to 0
 #ifndef __NO_CUDA__
@@ -1039,6 +1110,8 @@ void CpuSNN::scaleWeights(short int connId, float scale, bool updateWeightRange)
 		}
 #endif
 	}
+
+	synWtDirty_ = true;
 }
 
 GroupMonitor* CpuSNN::setGroupMonitor(int grpId, FILE* fid) {
@@ -1202,7 +1275,7 @@ SpikeMonitor* CpuSNN::setSpikeMonitor(int grpId, FILE* fid) {
 
 		// assign spike file ID if we selected to write to a file, else it's NULL
 		// if file pointer exists, it has already been fopened
-		// this will also write the header section of the spike file
+		// the header section of the spike file will be written together with the first spikes
 		// spkMonCoreObj destructor will fclose it
 		spkMonCoreObj->setSpikeFileId(fid);
 
@@ -1288,6 +1361,7 @@ void CpuSNN::setWeight(short int connId, int neurIdPre, int neurIdPost, float we
 
 			wt[pos_ij] = isExcitatoryGroup(connInfo->grpSrc) ? weight : -1.0*weight;
 			maxSynWt[pos_ij] = isExcitatoryGroup(connInfo->grpSrc) ? maxWt : -1.0*maxWt;
+			synWtDirty_ = true;
 
 #ifndef __NO_CUDA__
 			if (simMode_==GPU_MODE) {
@@ -1336,7 +1410,7 @@ void CpuSNN::saveSimulation(FILE* fid, bool saveSynapseInfo) {
 	if (!fwrite(&tmpFloat,sizeof(float),1,fid)) KERNEL_ERROR("saveSimulation fwrite error");
 
 	// write execution time so far (in seconds)
-	if(simMode_ == CPU_MODE) {
+	if(simMode_ != GPU_MODE) {
 		stopCPUTiming();
 		tmpFloat = cpuExecutionTime/1000.0f;
 #ifndef __NO_CUDA__
@@ -1658,6 +1732,21 @@ std::vector<float> CpuSNN::getConductanceGABAb(int grpId) {
 	return gGABAbVec;
 }
 
+std::vector<float> CpuSNN::getVoltage(int grpId) {
+#ifndef __NO_CUDA__
+	// need to copy data from GPU first
+	if (getSimMode()==GPU_MODE) {
+		copyNeuronState(&cpuNetPtrs, &cpu_gpuNetPtrs, cudaMemcpyDeviceToHost, false, grpId);
+	}
+#endif
+
+	std::vector<float> vVec;
+	for (int i=grp_Info[grpId].StartN; i<=grp_Info[grpId].EndN; i++) {
+		vVec.push_back(voltage[i]);
+	}
+	return vVec;
+}
+
 // returns RangeDelay struct of a connection
 RangeDelay CpuSNN::getDelayRange(short int connId) {
 	assert(connId>=0 && connId<numConnections);
@@ -1675,7 +1764,7 @@ uint8_t* CpuSNN::getDelays(int gIDpre, int gIDpost, int& Npre, int& Npost, uint8
 	if (delays == NULL) delays = new uint8_t[Npre*Npost];
 	memset(delays,0,Npre*Npost);
 
-	for (int i=grp_Info[gIDpre].StartN;i<grp_Info[gIDpre].EndN;i++) {
+	for (int i=grp_Info[gIDpre].StartN;i<=grp_Info[gIDpre].EndN;i++) {
 		unsigned int offset = cumulativePost[i];
 
 		for (int t=0;t<maxDelay_;t++) {
@@ -1697,7 +1786,7 @@ uint8_t* CpuSNN::getDelays(int gIDpre, int gIDpost, int& Npre, int& Npost, uint8
 					// get the cumulative position for quick access...
 //					unsigned int pos_i = cumulativePre[p_i] + s_i;
 
-					delays[i+Npre*(p_i-grp_Info[gIDpost].StartN)] = t+1;
+					delays[(i-grp_Info[gIDpre].StartN)+Npre*(p_i-grp_Info[gIDpost].StartN)] = t+1;
 				}
 			}
 		}
@@ -2082,6 +2171,54 @@ void CpuSNN::CpuSNNinit() {
 	// default integration method: Forward-Euler with 0.5ms integration step
 	setIntegrationMethod(FORWARD_EULER, 2);
 
+	// in multi-threaded mode, use all available cores by default
+	numThreads_ = (simMode_ == CPU_MODE_MT) ? CpuWorkerPool::getNumProcessors() : 1;
+	cpuWorkers_ = NULL;
+	parallelSpikeDelivery_ = (simMode_ == CPU_MODE_MT);
+	grpDASpikeCnt = NULL;
+	poissonSpikeBuf = NULL;
+	poissonGrpId_ = -1;
+	connBuildInfo_ = NULL;
+	connBuildPass_ = 0;
+	connBuildCnt_ = NULL;
+	connBuildFirstSlot_ = NULL;
+	connBuildOverflow_ = NULL;
+	connBuildCand_ = NULL;
+	connBuildDelay_ = NULL;
+	spikePropagation_ = PUSH_PROPAGATION;
+	expectedFiringRate_ = 10.0f;
+	preSynDelay = NULL;
+	firingBitmap = NULL;
+	firingBitmapWords_ = 0;
+	firingRingD1 = NULL;
+	firingRingD2 = NULL;
+	firingRingSize_ = 0;
+	spikeBudgetD1_ = 0;
+	spikeBudgetD2_ = 0;
+	numSpikeBufferOverflows_ = 0;
+	synPostNId = NULL;
+	synPrePos = NULL;
+	synWt = NULL;
+	synMulFast = NULL;
+	synMulSlow = NULL;
+	synPlastic = NULL;
+	numSynPlastic_ = 0;
+	synWtDirty_ = false;
+	synPlasticWtDirty_ = false;
+	simdLevel_ = getSupportedSimdLevel();
+	fusedStateUpdate_ = false;
+	stdpLookupTable_ = true;
+	grpLTPExcLUT = NULL;
+	grpLTDExcLUT = NULL;
+	grpLTPInbLUT = NULL;
+	grpLTDInbLUT = NULL;
+	curSpikeWords_ = 0;
+	grpDecayKernel = NULL;
+	grpFusedDecayKernel = NULL;
+	grpWeightKernel = NULL;
+	grpIzhKernel = NULL;
+	compCurrent = NULL;
+
 #ifndef __NO_CUDA__
 	// each CpuSNN object hold its own random number object
 	gpuPoissonRand = NULL;
@@ -2161,6 +2298,7 @@ void CpuSNN::CpuSNNinit() {
 		grp_Info2[i].maxPreConn  = 0;
 		grp_Info2[i].sumPostConn = 0;
 		grp_Info2[i].sumPreConn  = 0;
+		grp_Info2[i].spikeBufferRate = UNKNOWN_NEURON_MAX_FIRING_RATE;
 
 
 	}
@@ -2186,7 +2324,8 @@ void CpuSNN::CpuSNNinit() {
 //! update (initialize) numN, numPostSynapses, numPreSynapses, maxDelay_, postSynCnt, preSynCnt
 //! allocate space for voltage, recovery, Izh_a, Izh_b, Izh_c, Izh_d, current, gAMPA, gNMDA, gGABAa, gGABAb
 //! lastSpikeTime, nSpikeCnt, intrinsicWeight, stpu, stpx, Npre, Npre_plastic, Npost, cumulativePost, cumulativePre
-//! postSynapticIds, tmp_SynapticDely, postDelayInfo, wt, maxSynWt, preSynapticIds, timeTableD2, timeTableD1
+//! postSynapticIds, tmp_SynapticDely, postDelayInfo, wt, maxSynWt, preSynapticIds, timeTableD2, timeTableD1 (GPU)
+//! or firingRingD1, firingRingD2 (CPU)
 void CpuSNN::buildNetworkInit() {
 	// \FIXME: need to figure out STP buffer for delays > 1
 	if (sim_with_stp && maxDelay_>1) {
@@ -2213,6 +2352,10 @@ void CpuSNN::buildNetworkInit() {
 	// keeps track of all neurons that spiked at current time step
 	curSpike = new bool[numNReg];
 	memset(curSpike, 0, sizeof(curSpike[0])*numNReg);
+	curSpikeWords_ = (numNReg + SPIKE_BITS_PER_WORD - 1) / SPIKE_BITS_PER_WORD;
+	curSpikeBits = new uint64_t[curSpikeWords_];
+	memset(curSpikeBits, 0, sizeof(curSpikeBits[0])*curSpikeWords_);
+	cpuSnnSz.neuronInfoSize += sizeof(curSpikeBits[0])*curSpikeWords_;
 
 	cpuSnnSz.neuronInfoSize += (sizeof(float)*numNReg*8);
 
@@ -2323,18 +2466,37 @@ void CpuSNN::buildNetworkInit() {
 	// size due to weights and maximum weights
 	cpuSnnSz.synapticInfoSize += ((sizeof(int) + 2 * sizeof(float) + sizeof(post_info_t)) * (preSynCnt + 100));
 
-	timeTableD2  = new unsigned int[1000 + maxDelay_ + 1];
-	timeTableD1  = new unsigned int[1000 + maxDelay_ + 1];
-	resetTimingTable();
-	cpuSnnSz.spikingInfoSize += sizeof(int) * 2 * (1000 + maxDelay_ + 1);
+	if (simMode_ == GPU_MODE) {
+		timeTableD2  = new unsigned int[1000 + maxDelay_ + 1];
+		timeTableD1  = new unsigned int[1000 + maxDelay_ + 1];
+		resetTimingTable();
+		cpuSnnSz.spikingInfoSize += sizeof(int) * 2 * (1000 + maxDelay_ + 1);
+	} else {
+		// one list of fired neurons per ms: the last maxDelay_ lists hold the spikes still in transit, the older ones
+		// are kept around for the spike monitors, which are updated at least once every second
+		firingRingSize_ = 1000 + maxDelay_ + 1;
+		firingRingD1 = new std::vector<unsigned int>[firingRingSize_];
+		firingRingD2 = new std::vector<unsigned int>[firingRingSize_];
+		cpuSnnSz.spikingInfoSize += sizeof(std::vector<unsigned int>) * 2 * firingRingSize_;
+
+		// every list is reserved for the expected number of spikes per ms when it is recycled (see doSnnSim)
+		float budgetD1 = 0.0f, budgetD2 = 0.0f;
+		for (int g=0; g<numGrp; g++) {
+			if (grp_Info[g].MaxDelay == 1)
+				budgetD1 += grp_Info[g].SizeN * grp_Info2[g].spikeBufferRate / 1000.0f;
+			else
+				budgetD2 += grp_Info[g].SizeN * grp_Info2[g].spikeBufferRate / 1000.0f;
+		}
+		spikeBudgetD1_ = (unsigned int)ceilf(budgetD1);
+		spikeBudgetD2_ = (unsigned int)ceilf(budgetD2);
+	}
 
 	// poisson Firing Rate
 	cpuSnnSz.neuronInfoSize += (sizeof(int) * numNPois);
 }
 
 
-int CpuSNN::addSpikeToTable(int nid, int g) {
-	int spikeBufferFull = 0;
+void CpuSNN::addSpikeToTable(int nid, int g) {
 	lastSpikeTime[nid] = simTime;
 	nSpikeCnt[nid]++;
 	if (sim_with_homeostasis)
@@ -2344,7 +2506,7 @@ int CpuSNN::addSpikeToTable(int nid, int g) {
 	if (simMode_ == GPU_MODE) {
 		assert(grp_Info[g].isSpikeGenerator == true);
 		setSpikeGenBit_GPU(nid, g);
-		return 0;
+		return;
 	}
 #endif
 
@@ -2361,26 +2523,32 @@ int CpuSNN::addSpikeToTable(int nid, int g) {
 		stpx[ind_plus] -= stpu[ind_plus]*stpx[ind_minus];
 	}
 
+	// the lists are reserved for spikeBudgetD1_/D2_ spikes, and only grow here if a burst exceeds the budget
+	assert(nid < numN);
 	if (grp_Info[g].MaxDelay == 1) {
-		assert(nid < numN);
-		firingTableD1[secD1fireCntHost] = nid;
+		firingRingD1[simTime % firingRingSize_].push_back(nid);
 		secD1fireCntHost++;
-		grp_Info[g].FiringCount1sec++;
-		if (secD1fireCntHost >= maxSpikesD1) {
-			spikeBufferFull = 2;
-			secD1fireCntHost = maxSpikesD1-1;
-		}
 	} else {
-		assert(nid < numN);
-		firingTableD2[secD2fireCntHost] = nid;
-		grp_Info[g].FiringCount1sec++;
+		firingRingD2[simTime % firingRingSize_].push_back(nid);
 		secD2fireCntHost++;
-		if (secD2fireCntHost >= maxSpikesD2) {
-			spikeBufferFull = 1;
-			secD2fireCntHost = maxSpikesD2-1;
-		}
 	}
-	return spikeBufferFull;
+	grp_Info[g].FiringCount1sec++;
+}
+
+void CpuSNN::checkSpikeBufferBudget() {
+	// if more neurons fired than budgeted for, the lists of this time step had to grow in the middle of the time step:
+	// count the overflow and double the budget, so that the other lists grow when they are recycled instead
+	unsigned int numD1 = firingRingD1[simTime % firingRingSize_].size();
+	unsigned int numD2 = firingRingD2[simTime % firingRingSize_].size();
+	if (numD1 > spikeBudgetD1_ || numD2 > spikeBudgetD2_) {
+		numSpikeBufferOverflows_++;
+		if (numD1 > spikeBudgetD1_)
+			spikeBudgetD1_ = std::max(2*spikeBudgetD1_, numD1);
+		if (numD2 > spikeBudgetD2_)
+			spikeBudgetD2_ = std::max(2*spikeBudgetD2_, numD2);
+		KERNEL_DEBUG("Spike buffer overflow at t=%u: %u+%u spikes, new budget %u+%u", simTime, numD1, numD2,
+			spikeBudgetD1_, spikeBudgetD2_);
+	}
 }
 
 
@@ -2547,6 +2715,9 @@ void CpuSNN::buildNetwork() {
 			newInfo2 = newInfo2->next;
 		}
 
+		// delays of the pre-synaptic slots, until buildConnection has moved them to the post-synaptic side
+		connBuildDelay_ = new uint8_t[preSynCnt];
+
 		// build all the connections here...
 		// we run over the linked list two times...
 		// first time, we make all plastic connections...
@@ -2570,19 +2741,11 @@ void CpuSNN::buildNetwork() {
 				if( ((con == 0) && (synWtType == SYN_PLASTIC)) || ((con == 1) && (synWtType == SYN_FIXED))) {
 					switch(newInfo->type) {
 						case CONN_RANDOM:
-							connectRandom(newInfo);
-							break;
 						case CONN_FULL:
-							connectFull(newInfo);
-							break;
 						case CONN_FULL_NO_DIRECT:
-							connectFull(newInfo);
-							break;
 						case CONN_ONE_TO_ONE:
-							connectOneToOne(newInfo);
-							break;
 						case CONN_GAUSSIAN:
-							connectGaussian(newInfo);
+							buildConnection(newInfo);
 							break;
 						case CONN_USER_DEFINED:
 							connectUserDefined(newInfo);
@@ -2597,6 +2760,9 @@ void CpuSNN::buildNetwork() {
 				newInfo = newInfo->next;
 			}
 		}
+
+		delete[] connBuildDelay_;
+		connBuildDelay_ = NULL;
 	}
 }
 
@@ -2645,7 +2811,7 @@ void CpuSNN::checkSpikeCounterRecordDur() {
 		if ( (simTime % ++grp_Info[g].spkCntRecordDurHelper) != 1)
 			continue;
 
- 		if (simMode_==CPU_MODE) {
+ 		if (simMode_!=GPU_MODE) {
 			resetSpikeCounter(g);
 #ifndef __NO_CUDA__
 		} else {
@@ -2772,135 +2938,315 @@ void CpuSNN::compactConnections() {
 	postSynCnt	= tmp_postSynCnt;
 }
 
-// make 'C' full connections from grpSrc to grpDest
-void CpuSNN::connectFull(grpConnectInfo_t* info) {
+// builds all synapses of a connection of type random, full, full-no-direct, one-to-one, or gaussian
+// Building a connection takes two passes over the post-synaptic neurons, which are split among the worker threads (in
+// CPU_MODE_MT): the first pass decides on every synapse and fills the pre-synaptic slots of each post-neuron, the
+// second pass appends the synapses to the post-synaptic lists of the pre-neurons. Each thread counts the synapses of
+// every pre-neuron in the first pass, so that every thread knows where to put its synapses in the second pass.
+// Since all random numbers are addressed by (pre, post) or (post, draw), the result is the same as if the synapses had
+// been created one by one in the order (pre, post), no matter how many threads are used.
+void CpuSNN::buildConnection(grpConnectInfo_t* info) {
 	int grpSrc = info->grpSrc;
 	int grpDest = info->grpDest;
-	bool noDirect = (info->type == CONN_FULL_NO_DIRECT);
+	int numPre = grp_Info[grpSrc].SizeN;
+	int numPost = grp_Info[grpDest].SizeN;
+	int numThreads = (cpuWorkers_ != NULL) ? numThreads_ : 1;
+
+	if (info->type == CONN_ONE_TO_ONE)
+		assert(grp_Info[grpDest].SizeN == grp_Info[grpSrc].SizeN);
+
+	// look up the location of every pre-neuron only once
+	// for gaussian: in case pre and post have different Grid3D sizes, scale pre to the grid size of post
+	Point3D scalePre(1.0, 1.0, 1.0);
+	if (info->type == CONN_GAUSSIAN) {
+		Grid3D grid_i = getGroupGrid3D(grpSrc);
+		Grid3D grid_j = getGroupGrid3D(grpDest);
+		scalePre = Point3D(grid_j.x, grid_j.y, grid_j.z) / Point3D(grid_i.x, grid_i.y, grid_i.z);
+	}
+	connBuildScalePre_[0] = scalePre.x;
+	connBuildScalePre_[1] = scalePre.y;
+	connBuildScalePre_[2] = scalePre.z;
+	connBuildPreLoc_.clear();
+	for (int i=0; i<numPre; i++)
+		connBuildPreLoc_.push_back(getNeuronLocation3D(grpSrc, i) * scalePre);
+
+	connBuildInfo_ = info;
+	connBuildCnt_ = new int[numThreads*numPre];
+	connBuildFirstSlot_ = new int[numPost];
+	connBuildOverflow_ = new int[numThreads];
+	connBuildCand_ = new std::vector<int>[numThreads];
+	memset(connBuildCnt_, 0, sizeof(int)*numThreads*numPre);
+	for (int t=0; t<numThreads; t++)
+		connBuildOverflow_[t] = -1;
+
+	// first pass: pre-synaptic slots
+	connBuildPass_ = 0;
+	if (cpuWorkers_ != NULL) {
+		cpuWorkers_->run(&CpuSNN::buildConnectionWorker, this);
+	} else {
+		buildConnectionWorker(this, 0, 1);
+	}
 
-	// rebuild struct for easier handling
-	RadiusRF radius(info->radX, info->radY, info->radZ);
+	int numSyn = 0;
+	for (int t=0; t<numThreads; t++) {
+		if (connBuildOverflow_[t] >= 0) {
+			int nid = connBuildOverflow_[t];
+			KERNEL_ERROR("Large number of presynaptic connections established for neuron %d (Grp=%s), max for this "
+				"group %d.", nid, grp_Info2[grpDest].Name.c_str(), grp_Info[grpDest].numPreSynapses);
+			exitSimulation(1);
+		}
+	}
+	for (int j=grp_Info[grpDest].StartN; j<=grp_Info[grpDest].EndN; j++) {
+		numSyn += Npre[j] - connBuildFirstSlot_[j-grp_Info[grpDest].StartN];
+		if (Npre[j] > CONN_SYN_MASK+1) {
+			KERNEL_ERROR("Error: Syn Id (%d) exceeds maximum limit (%d) for neuron %d (group %d)", Npre[j]-1,
+				CONN_SYN_MASK, j, grpDest);
+			exitSimulation(1);
+		}
+		if (Npre[j] > grp_Info2[grpDest].maxPreConn)
+			grp_Info2[grpDest].maxPreConn = Npre[j];
+	}
+
+	// turn the number of synapses that every thread has found for a pre-neuron into the post-synaptic slot where the
+	// thread will put the first of them
+	int homeoPreNId = -1;
+	int homeoSlot = -1;
+	for (int i=0; i<numPre; i++) {
+		int nid = grp_Info[grpSrc].StartN + i;
+		unsigned int slot = Npost[nid];
+		for (int t=0; t<numThreads; t++) {
+			int cnt = connBuildCnt_[t*numPre + i];
+			connBuildCnt_[t*numPre + i] = slot;
+			slot += cnt;
+		}
+		if (slot > (unsigned int)grp_Info[grpSrc].numPostSynapses || slot > CONN_SYN_MASK+1) {
+			KERNEL_ERROR("Large number of postsynaptic connections established for neuron %d (Grp=%s), max for this "
+				"group %d.", nid, grp_Info2[grpSrc].Name.c_str(), grp_Info[grpSrc].numPostSynapses);
+			exitSimulation(1);
+		}
 
-	for(int i = grp_Info[grpSrc].StartN; i <= grp_Info[grpSrc].EndN; i++)  {
-		Point3D loc_i = getNeuronLocation3D(i); // 3D coordinates of i
-		for(int j = grp_Info[grpDest].StartN; j <= grp_Info[grpDest].EndN; j++) { // j: the temp neuron id
-			// if flag is set, don't connect direct connections
-			if((noDirect) && (i - grp_Info[grpSrc].StartN) == (j - grp_Info[grpDest].StartN))
-				continue;
+		// homeostasis: the first post-neuron (in the order (pre, post)) will be printed
+		if (homeoPreNId == -1 && slot > Npost[nid]) {
+			homeoPreNId = nid;
+			homeoSlot = Npost[nid];
+		}
 
-			// check whether pre-neuron location is in RF of post-neuron
-			Point3D loc_j = getNeuronLocation3D(j); // 3D coordinates of j
-			if (!isPoint3DinRF(radius, loc_i, loc_j))
-				continue;
+		Npost[nid] = slot;
+		if (Npost[nid] > grp_Info2[grpSrc].maxPostConn)
+			grp_Info2[grpSrc].maxPostConn = Npost[nid];
+	}
 
-			//uint8_t dVal = info->minDelay + (int)(0.5 + (drand48() * (info->maxDelay - info->minDelay)));
-			uint8_t dVal = info->minDelay + rand() % (info->maxDelay - info->minDelay + 1);
-			assert((dVal >= info->minDelay) && (dVal <= info->maxDelay));
-			float synWt = getWeights(info->connProp, info->initWt, info->maxWt, i, grpSrc);
+	// second pass: post-synaptic lists
+	connBuildPass_ = 1;
+	if (cpuWorkers_ != NULL) {
+		cpuWorkers_->run(&CpuSNN::buildConnectionWorker, this);
+	} else {
+		buildConnectionWorker(this, 0, 1);
+	}
 
-			setConnection(grpSrc, grpDest, i, j, synWt, info->maxWt, dVal, info->connProp, info->connId);
-			info->numberOfConnections++;
-		}
+	if (GET_FIXED_PLASTIC(info->connProp) == SYN_PLASTIC && numSyn > 0) {
+		sim_with_fixedwts = false; // if network has any plastic synapses at all, this will be set to true
+		if (grp_Info[grpDest].WithHomeostasis && grp_Info[grpDest].homeoId == -1)
+			grp_Info[grpDest].homeoId = GET_CONN_NEURON_ID(postSynapticIds[cumulativePost[homeoPreNId] + homeoSlot]);
 	}
 
+	info->numberOfConnections += numSyn;
+	grp_Info2[grpSrc].numPostConn += numSyn;
+	grp_Info2[grpDest].numPreConn += numSyn;
 	grp_Info2[grpSrc].sumPostConn += info->numberOfConnections;
 	grp_Info2[grpDest].sumPreConn += info->numberOfConnections;
+
+	delete[] connBuildCnt_;
+	delete[] connBuildFirstSlot_;
+	delete[] connBuildOverflow_;
+	delete[] connBuildCand_;
+	connBuildCnt_ = NULL;
+	connBuildFirstSlot_ = NULL;
+	connBuildOverflow_ = NULL;
+	connBuildCand_ = NULL;
+	connBuildInfo_ = NULL;
+}
+
+void CpuSNN::buildConnectionWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int grpDest = self->connBuildInfo_->grpDest;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->grp_Info[grpDest].SizeN, threadId, numThreads, firstNId, lastNId);
+	firstNId += self->grp_Info[grpDest].StartN;
+	lastNId += self->grp_Info[grpDest].StartN;
+
+	if (self->connBuildPass_ == 0) {
+		self->buildConnectionPreSynapses(threadId, firstNId, lastNId);
+	} else {
+		self->buildConnectionPostSynapses(threadId, firstNId, lastNId);
+	}
 }
 
-void CpuSNN::connectGaussian(grpConnectInfo_t* info) {
+void CpuSNN::buildConnectionPreSynapses(int threadId, int firstNId, int lastNId) {
+	grpConnectInfo_t* info = connBuildInfo_;
+	int grpSrc = info->grpSrc;
+	int grpDest = info->grpDest;
+	int numPre = grp_Info[grpSrc].SizeN;
+	int* cnt = &connBuildCnt_[threadId*numPre];
+
 	// rebuild struct for easier handling
-	// adjust with sqrt(2) in order to make the Gaussian kernel depend on 2*sigma^2
 	RadiusRF radius(info->radX, info->radY, info->radZ);
 
-	// in case pre and post have different Grid3D sizes: scale pre to the grid size of post
-	int grpSrc = info->grpSrc;
-	int grpDest = info->grpDest;
-	Grid3D grid_i = getGroupGrid3D(grpSrc);
-	Grid3D grid_j = getGroupGrid3D(grpDest);
-	Point3D scalePre = Point3D(grid_j.x, grid_j.y, grid_j.z) / Point3D(grid_i.x, grid_i.y, grid_i.z);
+	// the delay of every synapse is drawn from the stream of this connection, addressed by (pre, post)
+	CounterRNG synRNG(randSeed_, RNG_STREAM_ID(RNG_STREAM_SYNAPSES, info->connId));
+
+	// adjust sign of weight based on pre-group (negative if pre is inhibitory)
+	float sign = isExcitatoryGroup(grpSrc) ? 1.0f : -1.0f;
+	float maxWt = sign*fabs(info->maxWt);
+	bool isPlastic = (GET_FIXED_PLASTIC(info->connProp) == SYN_PLASTIC);
+
+	for (int post_nid=firstNId; post_nid<lastNId; post_nid++) {
+		int j = post_nid - grp_Info[grpDest].StartN;
+		Point3D loc_post = getNeuronLocation3D(post_nid); // 3D coordinates of j
+		connBuildFirstSlot_[j] = Npre[post_nid];
+
+		// collect the pre-neurons that might connect to j, in ascending order
+		std::vector<int>& cand = connBuildCand_[threadId];
+		cand.clear();
+		if (info->type == CONN_ONE_TO_ONE) {
+			// one-to-one only connects the neurons with the same index
+			// NOTE: RadiusRF does not make a difference here: ignore
+			cand.push_back(j);
+		} else {
+			// for random and gaussian, this already draws the existence of every synapse
+			findPreCandidates(info, radius, post_nid, loc_post, cand);
+		}
 
-	for(int i = grp_Info[grpSrc].StartN; i <= grp_Info[grpSrc].EndN; i++)  {
-		Point3D loc_i = getNeuronLocation3D(i)*scalePre; // i: adjusted 3D coordinates
+		for (unsigned int c=0; c<cand.size(); c++) {
+			int i = cand[c];
+			int pre_nid = grp_Info[grpSrc].StartN + i;
+			float synWt = 0.0f;
+			uint32_t bits[2];
 
-		for(int j = grp_Info[grpDest].StartN; j <= grp_Info[grpDest].EndN; j++) { // j: the temp neuron id
-			// check whether pre-neuron location is in RF of post-neuron
-			Point3D loc_j = getNeuronLocation3D(j); // 3D coordinates of j
+			if (info->type == CONN_GAUSSIAN) {
+				// make sure point is in RF
+				double rfDist = getRFDist3D(radius, connBuildPreLoc_[i], loc_post);
+				if (rfDist < 0.0 || rfDist > 1.0)
+					continue;
 
-			// make sure point is in RF
-			double rfDist = getRFDist3D(radius,loc_i,loc_j);
-			if (rfDist < 0.0 || rfDist > 1.0)
-				continue;
+				// if rfDist is valid, it returns a number between 0 and 1
+				// we want these numbers to fit to Gaussian weigths, so that rfDist=0 corresponds to max Gaussian weight
+				// and rfDist=1 corresponds to 0.1 times max Gaussian weight
+				// so we're looking at gauss = exp(-a*rfDist), where a such that exp(-a)=0.1
+				// solving for a, we find that a = 2.3026
+				double gauss = exp(-2.3026*rfDist);
+				if (gauss < 0.1)
+					continue;
 
-			// if rfDist is valid, it returns a number between 0 and 1
-			// we want these numbers to fit to Gaussian weigths, so that rfDist=0 corresponds to max Gaussian weight
-			// and rfDist=1 corresponds to 0.1 times max Gaussian weight
-			// so we're looking at gauss = exp(-a*rfDist), where a such that exp(-a)=0.1
-			// solving for a, we find that a = 2.3026
-			double gauss = exp(-2.3026*rfDist);
-			if (gauss < 0.1)
-				continue;
+				synRNG.getBits(pre_nid, post_nid, bits);
+				synWt = gauss * info->initWt; // scale weight according to gauss distance
+			} else {
+				// if flag is set, don't connect direct connections
+				if (info->type == CONN_FULL_NO_DIRECT && i == j)
+					continue;
 
-			if (drand48() < info->p) {
-				uint8_t dVal = info->minDelay + rand() % (info->maxDelay - info->minDelay + 1);
-				assert((dVal >= info->minDelay) && (dVal <= info->maxDelay));
-				float synWt = gauss * info->initWt; // scale weight according to gauss distance
-				setConnection(grpSrc, grpDest, i, j, synWt, info->maxWt, dVal, info->connProp, info->connId);
-				info->numberOfConnections++;
+				// check whether pre-neuron location is in RF of post-neuron
+				if (info->type != CONN_ONE_TO_ONE && !isPoint3DinRF(radius, connBuildPreLoc_[i], loc_post))
+					continue;
+
+				synRNG.getBits(pre_nid, post_nid, bits);
+				synWt = getWeights(info, pre_nid, post_nid);
+			}
+
+			uint8_t dVal = info->minDelay + bits[1] % (info->maxDelay - info->minDelay + 1);
+			assert((dVal >= info->minDelay) && (dVal <= info->maxDelay));
+			assert((dVal >=1) && (dVal <= maxDelay_));
+
+			// we have exceeded the number of possible connections for one neuron (reported by buildConnection)
+			if (Npre[post_nid] >= grp_Info[grpDest].numPreSynapses) {
+				connBuildOverflow_[threadId] = post_nid;
+				return;
 			}
+
+			// the synapse ID on the post-synaptic side is filled in by the second pass
+			unsigned int pre_pos = cumulativePre[post_nid] + Npre[post_nid];
+			assert(pre_pos < preSynCnt);
+			preSynapticIds[pre_pos] = SET_CONN_ID(pre_nid, 0, grpSrc);
+			wt[pre_pos] = sign*fabs(synWt);
+			maxSynWt[pre_pos] = maxWt;
+			cumConnIdPre[pre_pos] = info->connId;
+			connBuildDelay_[pre_pos] = dVal;
+
+			if (isPlastic)
+				Npre_plastic[post_nid]++;
+			Npre[post_nid]++;
+			cnt[i]++;
 		}
 	}
-
-	grp_Info2[grpSrc].sumPostConn += info->numberOfConnections;
-	grp_Info2[grpDest].sumPreConn += info->numberOfConnections;
 }
 
-void CpuSNN::connectOneToOne (grpConnectInfo_t* info) {
+void CpuSNN::buildConnectionPostSynapses(int threadId, int firstNId, int lastNId) {
+	grpConnectInfo_t* info = connBuildInfo_;
 	int grpSrc = info->grpSrc;
 	int grpDest = info->grpDest;
-	assert( grp_Info[grpDest].SizeN == grp_Info[grpSrc].SizeN );
-
-	// NOTE: RadiusRF does not make a difference here: ignore
-	for(int nid=grp_Info[grpSrc].StartN,j=grp_Info[grpDest].StartN; nid<=grp_Info[grpSrc].EndN; nid++, j++)  {
-		uint8_t dVal = info->minDelay + rand() % (info->maxDelay - info->minDelay + 1);
-		assert((dVal >= info->minDelay) && (dVal <= info->maxDelay));
-		float synWt = getWeights(info->connProp, info->initWt, info->maxWt, nid, grpSrc);
-		setConnection(grpSrc, grpDest, nid, j, synWt, info->maxWt, dVal, info->connProp, info->connId);
-		info->numberOfConnections++;
+	int* nextSlot = &connBuildCnt_[threadId*grp_Info[grpSrc].SizeN];
+
+	for (int post_nid=firstNId; post_nid<lastNId; post_nid++) {
+		for (int s=connBuildFirstSlot_[post_nid-grp_Info[grpDest].StartN]; s<Npre[post_nid]; s++) {
+			unsigned int pre_pos = cumulativePre[post_nid] + s;
+			int pre_nid = GET_CONN_NEURON_ID(preSynapticIds[pre_pos]);
+			int p = nextSlot[pre_nid - grp_Info[grpSrc].StartN]++;
+
+			unsigned int post_pos = cumulativePost[pre_nid] + p;
+			assert(post_pos < postSynCnt);
+			postSynapticIds[post_pos] = SET_CONN_ID(post_nid, s, grpDest);
+			tmp_SynapticDelay[post_pos] = connBuildDelay_[pre_pos];
+			preSynapticIds[pre_pos] = SET_CONN_ID(pre_nid, p, grpSrc);
+		}
 	}
-
-	grp_Info2[grpSrc].sumPostConn += info->numberOfConnections;
-	grp_Info2[grpDest].sumPreConn += info->numberOfConnections;
 }
 
-// make 'C' random connections from grpSrc to grpDest
-void CpuSNN::connectRandom (grpConnectInfo_t* info) {
+// finds the pre-neurons that might connect to the post-neuron postNId, in ascending order
+// Only the pre-neurons in the Grid3D box around the RF of postNId are considered, so that RF-limited connections cost
+// O(N x RF size) instead of O(N^2). The caller has to check whether a pre-neuron really lies in the (ellipsoid) RF.
+// For random and gaussian connections, the existence of every synapse is decided here: instead of flipping a coin for
+// every pre-neuron, the number of pre-neurons to skip until the next synapse is drawn from a geometric distribution,
+// so the cost grows with the number of synapses rather than the number of pairs. Every candidate is still connected
+// with probability p.
+void CpuSNN::findPreCandidates(grpConnectInfo_t* info, const RadiusRF& radius, int postNId, const Point3D& post,
+	std::vector<int>& cand)
+{
 	int grpSrc = info->grpSrc;
-	int grpDest = info->grpDest;
+	bool sampleSynapses = (info->type == CONN_RANDOM || info->type == CONN_GAUSSIAN);
+	if (sampleSynapses && info->p <= 0.0f)
+		return;
 
-	// rebuild struct for easier handling
-	RadiusRF radius(info->radX, info->radY, info->radZ);
+	int first[3], last[3], num[3];
+	getRFGridBounds(radius, grpSrc, connBuildScalePre_, post, first, last);
+	for (int d=0; d<3; d++) {
+		num[d] = last[d] - first[d] + 1;
+		if (num[d] <= 0)
+			return;
+	}
+	double numCand = 1.0*num[0]*num[1]*num[2];
 
-	for(int pre_nid=grp_Info[grpSrc].StartN; pre_nid<=grp_Info[grpSrc].EndN; pre_nid++) {
-		Point3D loc_pre = getNeuronLocation3D(pre_nid); // 3D coordinates of i
-		for(int post_nid=grp_Info[grpDest].StartN; post_nid<=grp_Info[grpDest].EndN; post_nid++) {
-			// check whether pre-neuron location is in RF of post-neuron
-			Point3D loc_post = getNeuronLocation3D(post_nid); // 3D coordinates of j
-			if (!isPoint3DinRF(radius, loc_pre, loc_post))
-				continue;
+	// the gaps are drawn from the stream of this connection, addressed by (post, number of the draw)
+	CounterRNG gapRNG(randSeed_, RNG_STREAM_ID(RNG_STREAM_SYNAPSE_GAPS, info->connId));
+	double logQ = log1p(-(double)info->p);
 
-			if (drand48() < info->p) {
-				//uint8_t dVal = info->minDelay + (int)(0.5+(drand48()*(info->maxDelay-info->minDelay)));
-				uint8_t dVal = info->minDelay + rand() % (info->maxDelay - info->minDelay + 1);
-				assert((dVal >= info->minDelay) && (dVal <= info->maxDelay));
-				float synWt = getWeights(info->connProp, info->initWt, info->maxWt, pre_nid, grpSrc);
-				setConnection(grpSrc, grpDest, pre_nid, post_nid, synWt, info->maxWt, dVal, info->connProp, info->connId);
-				info->numberOfConnections++;
-			}
+	uint32_t draw = 0;
+	double c = -1.0; // index of the current candidate in the box
+	while (true) {
+		if (sampleSynapses && info->p < 1.0f) {
+			uint32_t bits[2];
+			gapRNG.getBits(postNId, draw++, bits);
+			c += floor(log(uniformDoubleFromBits(bits)) / logQ);
 		}
-	}
+		c += 1.0;
+		if (c >= numCand)
+			break;
 
-	grp_Info2[grpSrc].sumPostConn += info->numberOfConnections;
-	grp_Info2[grpDest].sumPreConn += info->numberOfConnections;
+		int idx = (int)c;
+		int x = first[0] + idx % num[0];
+		int y = first[1] + (idx / num[0]) % num[1];
+		int z = first[2] + idx / (num[0]*num[1]);
+		cand.push_back(x + grp_Info[grpSrc].SizeX*(y + grp_Info[grpSrc].SizeY*z));
+	}
 }
 
 // user-defined functions called here...
@@ -2972,7 +3318,7 @@ void CpuSNN::printSimSummary() {
 // stop CPU/GPU timer and retrieve actual execution time for printSimSummary
 float CpuSNN::getActualExecutionTimeMs() {
 	float etime;
-	if (simMode_ == CPU_MODE) {
+	if (simMode_ != GPU_MODE) {
 		stopCPUTiming();
 		etime = cpuExecutionTime;
 #ifndef __NO_CUDA__
@@ -3014,74 +3360,212 @@ void CpuSNN::deleteObjects() {
 	simulatorDeleted = true;
 }
 
+// For AUTO_PROPAGATION, estimate the work per ms of both engines: push touches every synapse whose pre-neuron fired
+// (fan-out x firing rate), whereas pull visits every synapse once (fan-in) and writes every post-neuron once.
+// If the pull engine is used, set up the delay of every pre-synaptic connection and the bitmap of recent spikes.
+void CpuSNN::chooseSpikePropagation() {
+	if (spikePropagation_ == AUTO_PROPAGATION) {
+		float costPush = preSynCnt * expectedFiringRate_ / 1000.0f * PUSH_COST_PER_SPIKE_SYN;
+		float costPull = preSynCnt * PULL_COST_PER_SYN + numNReg * PULL_COST_PER_NEURON;
+		spikePropagation_ = (costPull < costPush) ? PULL_PROPAGATION : PUSH_PROPAGATION;
+		KERNEL_INFO("Spike propagation: estimated cost push=%.1f, pull=%.1f (%.1f Hz) => using %s engine", costPush,
+			costPull, expectedFiringRate_, spikePropagation_string[spikePropagation_]);
+	}
+
+	if (spikePropagation_ != PULL_PROPAGATION || preSynDelay != NULL)
+		return;
+
+	preSynDelay = new uint8_t[preSynCnt+1];
+	memset(preSynDelay, 0, sizeof(uint8_t)*(preSynCnt+1));
+	for (int nid=0; nid<numN; nid++) {
+		unsigned int offset = cumulativePost[nid];
+		for (int tD=0; tD<maxDelay_; tD++) {
+			delay_info_t dPar = postDelayInfo[nid*(maxDelay_+1)+tD];
+			for (int idx_d=dPar.delay_index_start; idx_d<dPar.delay_index_start+dPar.delay_length; idx_d++) {
+				post_info_t post_info = postSynapticIds[offset+idx_d];
+				unsigned int pos_i = cumulativePre[GET_CONN_NEURON_ID(post_info)] + GET_CONN_SYN_ID(post_info);
+				preSynDelay[pos_i] = tD;
+			}
+		}
+	}
+
+	int numSlots = maxDelay_ > 1 ? maxDelay_ : 1;
+	firingBitmapWords_ = (numN+31)/32;
+	firingBitmap = new uint32_t[numSlots*firingBitmapWords_];
+	memset(firingBitmap, 0, sizeof(uint32_t)*numSlots*firingBitmapWords_);
+
+	cpuSnnSz.networkInfoSize += sizeof(uint8_t)*(preSynCnt+1) + sizeof(uint32_t)*numSlots*firingBitmapWords_;
+}
+
+// This method delivers the spikes of all neurons that fired in this time step (as well as spikes still in transit) to
+// the appropriate post-synaptic neurons. In CPU_MODE_MT with parallel spike delivery enabled, every thread owns a
+// contiguous range of post-synaptic neurons and scans the entire firing table, but only delivers the spikes that
+// target its own range. This way, every post-synaptic variable is written by exactly one thread, and in the same order
+// as in the serial version.
+// With PULL_PROPAGATION, the same partitioning of post-synaptic neurons is used, but every thread only visits the
+// synapses of its own neurons.
+void CpuSNN::doCurrentUpdate() {
+	if (spikePropagation_ == PUSH_PROPAGATION && (synWtDirty_ || synPlasticWtDirty_))
+		syncDeliveryWeights();
 
+	if (cpuWorkers_ != NULL && parallelSpikeDelivery_) {
+		cpuWorkers_->run(&CpuSNN::doCurrentUpdateWorker, this);
+	} else if (spikePropagation_ == PULL_PROPAGATION) {
+		doPullCurrentUpdate(0, numNReg, grpDASpikeCnt);
+	} else {
+		doD2CurrentUpdate(0, numNReg, grpDASpikeCnt);
+		doD1CurrentUpdate(0, numNReg, grpDASpikeCnt);
+	}
 
-// This method loops through all spikes that are generated by neurons with a delay of 1ms
-// and delivers the spikes to the appropriate post-synaptic neuron
-void CpuSNN::doD1CurrentUpdate() {
-	int k     = secD1fireCntHost-1;
-	int k_end = timeTableD1[simTimeMs+maxDelay_];
+	// Got spikes from dopaminergic neurons, increase dopamine concentration in the target area.
+	// All increments are identical, so the order in which the threads counted them does not matter.
+	int numCounters = (cpuWorkers_ != NULL && parallelSpikeDelivery_) ? numThreads_ : 1;
+	for (int t=0; t<numCounters; t++) {
+		int* cnt = &grpDASpikeCnt[t*numGrp];
+		for (int g=0; g<numGrp; g++) {
+			for (int c=0; c<cnt[g]; c++)
+				cpuNetPtrs.grpDA[g] += 0.04;
+			cnt[g] = 0;
+		}
+	}
+}
+
+void CpuSNN::doCurrentUpdateWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->numNReg, threadId, numThreads, firstNId, lastNId);
+	if (self->spikePropagation_ == PULL_PROPAGATION) {
+		self->doPullCurrentUpdate(firstNId, lastNId, &self->grpDASpikeCnt[threadId*self->numGrp]);
+	} else {
+		self->doD2CurrentUpdate(firstNId, lastNId, &self->grpDASpikeCnt[threadId*self->numGrp]);
+		self->doD1CurrentUpdate(firstNId, lastNId, &self->grpDASpikeCnt[threadId*self->numGrp]);
+	}
+}
 
-	while((k>=k_end) && (k>=0)) {
+// This method loops through all spikes that are generated by neurons with a delay of 1ms
+// and delivers the spikes to the appropriate post-synaptic neuron (if it falls into [firstPostNId,lastPostNId))
+void CpuSNN::doD1CurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes) {
+	const std::vector<unsigned int>& fired = firingRingD1[simTime % firingRingSize_];
 
-		int neuron_id      = firingTableD1[k];
+	for (int k=(int)fired.size()-1; k>=0; k--) {
+		int neuron_id      = fired[k];
 		assert(neuron_id<numN);
 
 		delay_info_t dPar = postDelayInfo[neuron_id*(maxDelay_+1)];
 
 		unsigned int  offset = cumulativePost[neuron_id];
-
-		for(int idx_d = dPar.delay_index_start;
-			idx_d < (dPar.delay_index_start + dPar.delay_length);
-			idx_d = idx_d+1) {
-				generatePostSpike( neuron_id, idx_d, offset, 0);
+		unsigned int pre_type = grp_Info[grpIds[neuron_id]].Type;
+
+		// the synapses with a delay of 1ms form a contiguous block in the delivery arrays
+		unsigned int syn_end = offset + dPar.delay_index_start + dPar.delay_length;
+		for (unsigned int syn_i = offset + dPar.delay_index_start; syn_i < syn_end; syn_i++) {
+			unsigned int post_i = synPostNId[syn_i];
+			if (post_i >= (unsigned int)firstPostNId && post_i < (unsigned int)lastPostNId)
+				generatePostSpike(neuron_id, syn_i, pre_type, 0, numDASpikes);
 		}
-		k=k-1;
 	}
 }
 
 // This method loops through all spikes that are generated by neurons with a delay of 2+ms
-// and delivers the spikes to the appropriate post-synaptic neuron
-void CpuSNN::doD2CurrentUpdate() {
-	int k = secD2fireCntHost-1;
-	int k_end = timeTableD2[simTimeMs+1];
-	int t_pos = simTimeMs;
+// and delivers the spikes to the appropriate post-synaptic neuron (if it falls into [firstPostNId,lastPostNId))
+void CpuSNN::doD2CurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes) {
+	// the spikes that were fired tD ms ago live in slot simTime-tD of the ring, so there is no need to search for the
+	// firing time of a spike (the slots of the first ms of the simulation are empty)
+	for (int tD=0; tD<maxDelay_; tD++) {
+		const std::vector<unsigned int>& fired = firingRingD2[(simTime + firingRingSize_ - tD) % firingRingSize_];
 
-	while((k>=k_end)&& (k >=0)) {
+		for (int k=(int)fired.size()-1; k>=0; k--) {
+			int i  = fired[k];
+			assert(i<numN);
 
-		// get the neuron id from the index k
-		int i  = firingTableD2[k];
+			delay_info_t dPar = postDelayInfo[i*(maxDelay_+1)+tD];
 
-		// find the time of firing from the timeTable using index k
-		while (!(((unsigned int)k >= timeTableD2[t_pos+maxDelay_]) 
-			&& ((unsigned int)k < timeTableD2[t_pos+maxDelay_+1]))) {
-			t_pos = t_pos - 1;
-			assert((t_pos+maxDelay_-1)>=0);
+			unsigned int offset = cumulativePost[i];
+			unsigned int pre_type = grp_Info[grpIds[i]].Type;
+
+			// the synapses with a delay of tD+1 ms form a contiguous block in the delivery arrays
+			unsigned int syn_end = offset + dPar.delay_index_start + dPar.delay_length;
+			for (unsigned int syn_i = offset + dPar.delay_index_start; syn_i < syn_end; syn_i++) {
+				unsigned int post_i = synPostNId[syn_i];
+				if (post_i >= (unsigned int)firstPostNId && post_i < (unsigned int)lastPostNId)
+					generatePostSpike(i, syn_i, pre_type, tD, numDASpikes);
+			}
 		}
+	}
+}
 
-		// \TODO: Instead of using the complex timeTable, can neuronFiringTime value...???
-		// Calculate the time difference between time of firing of neuron and the current time...
-		int tD = simTimeMs - t_pos;
+// This method delivers the spikes of this time step from the point of view of the post-synaptic neurons in
+// [firstPostNId,lastPostNId): every post-neuron walks over its own (contiguous) slice of pre-synaptic connections,
+// looks up in firingBitmap whether the pre-neuron fired exactly delay ms ago, and sums up the contributions of all
+// arriving spikes locally. This way, every conductance (or current) is written only once per time step.
+void CpuSNN::doPullCurrentUpdate(int firstPostNId, int lastPostNId, int* numDASpikes) {
+	int numSlots = maxDelay_ > 1 ? maxDelay_ : 1;
 
-		assert((tD<maxDelay_)&&(tD>=0));
-		assert(i<numN);
+	for (int post_i=firstPostNId; post_i<lastPostNId; post_i++) {
+		float sumAMPA = 0.0f, sumNMDA = 0.0f, sumGABAa = 0.0f, sumGABAb = 0.0f;
+		unsigned int offset = cumulativePre[post_i];
 
-		delay_info_t dPar = postDelayInfo[i*(maxDelay_+1)+tD];
+		for (int j=0; j<Npre[post_i]; j++) {
+			unsigned int pos_i = offset + j;
+			unsigned int pre_i = GET_CONN_NEURON_ID(preSynapticIds[pos_i]);
+			unsigned int tD = preSynDelay[pos_i];
 
-		unsigned int offset = cumulativePost[i];
+			// did pre_i fire at time simTime-tD?
+			uint32_t* bitmap = &firingBitmap[((simTime + numSlots - tD) % numSlots) * firingBitmapWords_];
+			if (!(bitmap[pre_i/32] & (1u << (pre_i%32))))
+				continue;
+
+			unsigned int pre_type = grp_Info[grpIds[pre_i]].Type;
+			short int mulIndex = cumConnIdPre[pos_i];
+			assert(mulIndex>=0 && mulIndex<numConnections);
+
+			float change = getSynapticChange(pre_i, wt[pos_i], tD);
+			if (sim_with_conductances) {
+				if (pre_type & TARGET_AMPA)
+					sumAMPA += change*mulSynFast[mulIndex];
+				if (pre_type & TARGET_NMDA)
+					sumNMDA += change*mulSynSlow[mulIndex];
+				if (pre_type & TARGET_GABAa)
+					sumGABAa += change*mulSynFast[mulIndex];
+				if (pre_type & TARGET_GABAb)
+					sumGABAb += change*mulSynSlow[mulIndex];
+			} else {
+				sumAMPA += change;
+			}
 
-		// for each delay variables
-		for(int idx_d = dPar.delay_index_start;
-			idx_d < (dPar.delay_index_start + dPar.delay_length);
-			idx_d = idx_d+1) {
-			generatePostSpike( i, idx_d, offset, tD);
+			updateSynapseOnPreSpike(post_i, pos_i, pre_type, numDASpikes);
 		}
 
-		k=k-1;
+		// write back, wt should be negative for GABAa and GABAb
+		if (sim_with_conductances) {
+			gAMPA[post_i] += sumAMPA;
+			if (sim_with_NMDA_rise) {
+				gNMDA_r[post_i] += sumNMDA*sNMDA;
+				gNMDA_d[post_i] += sumNMDA*sNMDA;
+			} else {
+				gNMDA[post_i] += sumNMDA;
+			}
+			gGABAa[post_i] -= sumGABAa;
+			if (sim_with_GABAb_rise) {
+				gGABAb_r[post_i] -= sumGABAb*sGABAb;
+				gGABAb_d[post_i] -= sumGABAb*sGABAb;
+			} else {
+				gGABAb[post_i] -= sumGABAb;
+			}
+		} else {
+			current[post_i] += sumAMPA;
+		}
 	}
 }
 
 void CpuSNN::doSnnSim() {
+	// recycle the oldest list of fired neurons for the spikes of this time step, and make room for the budgeted
+	// number of spikes now rather than while the spikes are added
+	firingRingD1[simTime % firingRingSize_].clear();
+	firingRingD2[simTime % firingRingSize_].clear();
+	firingRingD1[simTime % firingRingSize_].reserve(spikeBudgetD1_);
+	firingRingD2[simTime % firingRingSize_].reserve(spikeBudgetD2_);
+
 	// for all Spike Counters, reset their spike counts to zero if simTime % recordDur == 0
 	if (sim_with_spikecounters) {
 		checkSpikeCounterRecordDur();
@@ -3098,11 +3582,12 @@ void CpuSNN::doSnnSim() {
 	// find the neurons that has fired..
 	findFiring();
 
-	timeTableD2[simTimeMs+maxDelay_+1] = secD2fireCntHost;
-	timeTableD1[simTimeMs+maxDelay_+1] = secD1fireCntHost;
+	checkSpikeBufferBudget();
 
-	doD2CurrentUpdate();
-	doD1CurrentUpdate();
+	if (spikePropagation_ == PULL_PROPAGATION)
+		updateFiringBitmap();
+
+	doCurrentUpdate();
 
 	globalStateUpdate();
 
@@ -3110,86 +3595,140 @@ void CpuSNN::doSnnSim() {
 }
 
 void CpuSNN::globalStateDecay() {
-	int spikeBufferFull = 0;
-
-	// having outer loop is grpId produces slightly more code (every flag needs its own neurId inner loop)
-	// but avoids having to check the condition for every neuron in the network (= faster)
-
-	// decay the STP variables before adding new spikes.
-	for (int grpId=0; (grpId < numGrp) & !spikeBufferFull; grpId++) {
-		// decay homeostasis avg firing
-		if (grp_Info[grpId].WithHomeostasis) {
-			for(int i=grp_Info[grpId].StartN; i<=grp_Info[grpId].EndN; i++) {
-				avgFiring[i] *= grp_Info[grpId].avgTimeScale_decay;
-			}
-		}
-
-		// decay the STP variables before adding new spikes.
-		if (grp_Info[grpId].WithSTP) {
-			for(int i=grp_Info[grpId].StartN; i<=grp_Info[grpId].EndN; i++) {
-				int ind_plus  = STP_BUF_POS(i,simTime);
-				int ind_minus = STP_BUF_POS(i,(simTime-1));
-				stpu[ind_plus] = stpu[ind_minus]*(1.0-grp_Info[grpId].STP_tau_u_inv);
-				stpx[ind_plus] = stpx[ind_minus] + (1.0-stpx[ind_minus])*grp_Info[grpId].STP_tau_x_inv;
-			}
-		}
-
+	// decay dopamine concentration
+	for (int grpId=0; grpId < numGrp; grpId++) {
 		if (grp_Info[grpId].Type&POISSON_NEURON)
 			continue;
 
-		// decay dopamine concentration
 		if ((grp_Info[grpId].WithESTDPtype == DA_MOD || grp_Info[grpId].WithISTDP == DA_MOD) && 
 			cpuNetPtrs.grpDA[grpId] > grp_Info[grpId].baseDP)
 		{
 			cpuNetPtrs.grpDA[grpId] *= grp_Info[grpId].decayDP;
 		}
+	}
 
-		// decay conductances
-		if (sim_with_conductances) {
-			for(int i=grp_Info[grpId].StartN; i<=grp_Info[grpId].EndN; i++) {
-				gAMPA[i]  *= dAMPA;
-				gGABAa[i] *= dGABAa;
+	// decay the STP variables before adding new spikes, and the conductances
+	if (cpuWorkers_ != NULL) {
+		cpuWorkers_->run(&CpuSNN::globalStateDecayWorker, this);
+	} else {
+		globalStateDecayNeurons(0, numN);
+	}
 
-				if (sim_with_NMDA_rise) {
-					gNMDA_r[i] *= rNMDA;	// rise
-					gNMDA_d[i] *= dNMDA;	// decay
-				} else {
-					gNMDA[i]   *= dNMDA;	// instantaneous rise
-				}
+	// In CUBA mode, reset current to 0 each time step
+	// (the fused state update already did this, along with decaying the conductances, in the previous time step)
+	if (!sim_with_conductances && !fusedStateUpdate_) {
+		resetCurrent();
+	}
+}
 
-				if (sim_with_GABAb_rise) {
-					gGABAb_r[i] *= rGABAb;	// rise
-					gGABAb_d[i] *= dGABAb;	// decay
-				} else {
-					gGABAb[i] *= dGABAb;	// instantaneous rise
-				}
-			}
+void CpuSNN::globalStateDecayWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->numN, threadId, numThreads, firstNId, lastNId);
+	self->globalStateDecayNeurons(firstNId, lastNId);
+}
+
+void CpuSNN::globalStateDecayNeurons(int firstNId, int lastNId) {
+	// having outer loop is grpId produces slightly more code (every flag needs its own neurId inner loop)
+	// but avoids having to check the condition for every neuron in the network (= faster)
+	for (int grpId=0; grpId < numGrp; grpId++) {
+		(this->*grpDecayKernel[grpId])(grpId, firstNId, lastNId);
+	}
+}
+
+template<bool COBA, bool NMDA_RISE, bool GABAB_RISE, bool STP, bool HOMEO>
+void CpuSNN::decayNeurons(int grpId, int firstNId, int lastNId) {
+	// only look at the neurons of this group that fall into [firstNId,lastNId)
+	int startN = std::max(grp_Info[grpId].StartN, firstNId);
+	int endN = std::min(grp_Info[grpId].EndN, lastNId-1);
+
+	// decay homeostasis avg firing
+	if (HOMEO) {
+		float avgTimeScale_decay = grp_Info[grpId].avgTimeScale_decay;
+		for(int i=startN; i<=endN; i++) {
+			avgFiring[i] *= avgTimeScale_decay;
 		}
-	} // end grpId loop
+	}
 
-	// In CUBA mode, reset current to 0 each time step
-	if (!sim_with_conductances) {
-		resetCurrent();
+	// decay the STP variables before adding new spikes.
+	if (STP) {
+		double uDecay = 1.0-grp_Info[grpId].STP_tau_u_inv;
+		float tau_x_inv = grp_Info[grpId].STP_tau_x_inv;
+		for(int i=startN; i<=endN; i++) {
+			int ind_plus  = STP_BUF_POS(i,simTime);
+			int ind_minus = STP_BUF_POS(i,(simTime-1));
+			stpu[ind_plus] = stpu[ind_minus]*uDecay;
+			stpx[ind_plus] = stpx[ind_minus] + (1.0-stpx[ind_minus])*tau_x_inv;
+		}
+	}
+
+	// decay conductances
+	if (COBA) {
+		for(int i=startN; i<=endN; i++) {
+			gAMPA[i]  *= dAMPA;
+			gGABAa[i] *= dGABAa;
+
+			if (NMDA_RISE) {
+				gNMDA_r[i] *= rNMDA;	// rise
+				gNMDA_d[i] *= dNMDA;	// decay
+			} else {
+				gNMDA[i]   *= dNMDA;	// instantaneous rise
+			}
+
+			if (GABAB_RISE) {
+				gGABAb_r[i] *= rGABAb;	// rise
+				gGABAb_d[i] *= dGABAb;	// decay
+			} else {
+				gGABAb[i] *= dGABAb;	// instantaneous rise
+			}
+		}
 	}
 }
 
-void CpuSNN::findFiring() {
-	int spikeBufferFull = 0;
+// The flags are turned into template arguments one at a time. Groups without conductances never look at the rise
+// times, so those are only instantiated for COBA.
+CpuSNN::groupKernel_t CpuSNN::getDecayKernel(bool withConductances, bool withNMDARise, bool withGABAbRise,
+	bool withSTP, bool withHomeostasis)
+{
+	#define DECAY_KERNEL(COBA, NMDA_RISE, GABAB_RISE) \
+		(withSTP ? (withHomeostasis ? &CpuSNN::decayNeurons<COBA,NMDA_RISE,GABAB_RISE,true,true> \
+			: &CpuSNN::decayNeurons<COBA,NMDA_RISE,GABAB_RISE,true,false>) \
+		: (withHomeostasis ? &CpuSNN::decayNeurons<COBA,NMDA_RISE,GABAB_RISE,false,true> \
+			: &CpuSNN::decayNeurons<COBA,NMDA_RISE,GABAB_RISE,false,false>))
+
+	groupKernel_t kernel;
+	if (!withConductances)
+		kernel = DECAY_KERNEL(false, false, false);
+	else if (withNMDARise)
+		kernel = withGABAbRise ? DECAY_KERNEL(true, true, true) : DECAY_KERNEL(true, true, false);
+	else
+		kernel = withGABAbRise ? DECAY_KERNEL(true, false, true) : DECAY_KERNEL(true, false, false);
+
+	#undef DECAY_KERNEL
+	return kernel;
+}
 
-	for(int g=0; (g < numGrp) & !spikeBufferFull; g++) {
+void CpuSNN::findFiring() {
+	for(int g=0; g < numGrp; g++) {
 		// given group of neurons belong to the poisson group....
 		if (grp_Info[g].Type&POISSON_NEURON)
 			continue;
 
-		// his flag is set if with_stdp is set and also grpType is set to have GROUP_SYN_FIXED
-		for(int i=grp_Info[g].StartN; i <= grp_Info[g].EndN; i++) {
-			assert(i < numNReg);
-
-			// 9-param model can set vpeak, but it's hardcoded in 4-param model
-			//float vpeak = (grp_Info[g].withParamModel_9) ? Izh_vpeak[i] : 30.0f;
-			//if (voltage[i] >= vpeak) {
-			if (curSpike[i]) {
-				curSpike[i] = false;
+		// only visit the neurons of this group whose bit is set in curSpikeBits, in increasing order
+		int firstWord = grp_Info[g].StartN / SPIKE_BITS_PER_WORD;
+		int lastWord = grp_Info[g].EndN / SPIKE_BITS_PER_WORD;
+		for (int w=firstWord; w<=lastWord; w++) {
+			uint64_t bits = curSpikeBits[w];
+			if (w == firstWord)
+				bits &= ~0ULL << (grp_Info[g].StartN % SPIKE_BITS_PER_WORD);
+			if (w == lastWord && grp_Info[g].EndN % SPIKE_BITS_PER_WORD != SPIKE_BITS_PER_WORD-1)
+				bits &= (1ULL << (grp_Info[g].EndN % SPIKE_BITS_PER_WORD + 1)) - 1;
+
+			while (bits) {
+				int i = w*SPIKE_BITS_PER_WORD + countTrailingZeros(bits);
+				assert(i < numNReg);
+				bits &= bits - 1;
+				curSpikeBits[w] &= ~(1ULL << (i % SPIKE_BITS_PER_WORD));
 
 				// if flag hasSpkMonRT is set, we want to keep track of how many spikes per neuron in the group
 				if (grp_Info[g].withSpikeCounter) {// put the condition for runNetwork
@@ -3197,10 +3736,7 @@ void CpuSNN::findFiring() {
 					int bufNeur = i-grp_Info[g].StartN;
 					spkCntBuf[bufPos][bufNeur]++;
 				}
-				spikeBufferFull = addSpikeToTable(i, g);
-
-				if (spikeBufferFull)
-					break;
+				addSpikeToTable(i, g);
 
 				// STDP calculation: the post-synaptic neuron fires after the arrival of a pre-synaptic spike
 				if (!sim_in_testing && grp_Info[g].WithSTDP) {
@@ -3216,14 +3752,14 @@ void CpuSNN::findFiring() {
 								switch (grp_Info[g].WithESTDPcurve) {
 								case EXP_CURVE: // exponential curve
 									if (stdp_tDiff * grp_Info[g].TAU_PLUS_INV_EXC < 25)
-										wtChange[pos_ij] += STDP(stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
+										wtChange[pos_ij] += stdpExpCurve(grpLTPExcLUT[g], stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
 									break;
 								case TIMING_BASED_CURVE: // sc curve
 									if (stdp_tDiff * grp_Info[g].TAU_PLUS_INV_EXC < 25) {
 										if (stdp_tDiff <= grp_Info[g].GAMMA)
-											wtChange[pos_ij] += grp_Info[g].OMEGA + grp_Info[g].KAPPA * STDP(stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
+											wtChange[pos_ij] += grp_Info[g].OMEGA + grp_Info[g].KAPPA * stdpExpCurve(grpLTPExcLUT[g], stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
 										else // stdp_tDiff > GAMMA
-											wtChange[pos_ij] -= STDP(stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
+											wtChange[pos_ij] -= stdpExpCurve(grpLTPExcLUT[g], stdp_tDiff, grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
 									}
 									break;
 								default:
@@ -3235,7 +3771,7 @@ void CpuSNN::findFiring() {
 								switch (grp_Info[g].WithISTDPcurve) {
 								case EXP_CURVE: // exponential curve
 									if (stdp_tDiff * grp_Info[g].TAU_PLUS_INV_INB < 25) { // LTP of inhibitory synapse, which decreases synapse weight
-										wtChange[pos_ij] -= STDP(stdp_tDiff, grp_Info[g].ALPHA_PLUS_INB, grp_Info[g].TAU_PLUS_INV_INB);
+										wtChange[pos_ij] -= stdpExpCurve(grpLTPInbLUT[g], stdp_tDiff, grp_Info[g].ALPHA_PLUS_INB, grp_Info[g].TAU_PLUS_INV_INB);
 									}
 									break;
 								case PULSE_CURVE: // pulse curve
@@ -3288,90 +3824,95 @@ void CpuSNN::findMaxNumSynapses(int* numPostSynapses, int* numPreSynapses) {
 	}
 }
 
-void CpuSNN::generatePostSpike(unsigned int pre_i, unsigned int idx_d, unsigned int offset, unsigned int tD) {
-	// get synaptic info...
-	post_info_t post_info = postSynapticIds[offset + idx_d];
-
-	// get post-neuron id
-	unsigned int post_i = GET_CONN_NEURON_ID(post_info);
-	assert(post_i<(unsigned int)numN);
-
-	// get syn id
-	int s_i = GET_CONN_SYN_ID(post_info);
-	assert(s_i<(Npre[post_i]));
-
-	// get the cumulative position for quick access
-	unsigned int pos_i = cumulativePre[post_i] + s_i;
-	assert(post_i < (unsigned int)numNReg); // \FIXME is this assert supposed to be for pos_i?
-
-	// get group id of pre- / post-neuron
-	short int post_grpId = grpIds[post_i];
-	short int pre_grpId = grpIds[pre_i];
+void CpuSNN::generatePostSpike(unsigned int pre_i, unsigned int syn_i, unsigned int pre_type, unsigned int tD,
+	int* numDASpikes)
+{
+	// all synaptic info needed for delivery is stored in the same place (syn_i) of the delivery arrays
+	unsigned int post_i = synPostNId[syn_i];
+	assert(post_i < (unsigned int)numNReg);
 
-	unsigned int pre_type = grp_Info[pre_grpId].Type;
+	// position of the synapse in the pre-synaptic arrays, needed for synSpikeTime and STDP
+	unsigned int pos_i = synPrePos[syn_i];
+	assert(pos_i < preSynCnt);
 
-	// get connect info from the cumulative synapse index for mulSynFast/mulSynSlow (requires less memory than storing
-	// mulSynFast/Slow per synapse or storing a pointer to grpConnectInfo_s)
 	// mulSynFast will be applied to fast currents (either AMPA or GABAa)
 	// mulSynSlow will be applied to slow currents (either NMDA or GABAb)
-	short int mulIndex = cumConnIdPre[pos_i];
-	assert(mulIndex>=0 && mulIndex<numConnections);
-
+	float mulFast = synMulFast[syn_i];
+	float mulSlow = synMulSlow[syn_i];
 
 	// for each presynaptic spike, postsynaptic (synaptic) current is going to increase by some amplitude (change)
 	// generally speaking, this amplitude is the weight; but it can be modulated by STP
-	float change = wt[pos_i];
-
-	if (grp_Info[pre_grpId].WithSTP) {
-		// if pre-group has STP enabled, we need to modulate the weight
-		// NOTE: Order is important! (Tsodyks & Markram, 1998; Mongillo, Barak, & Tsodyks, 2008)
-		// use u^+ (value right after spike-update) but x^- (value right before spike-update)
-
-		// dI/dt = -I/tau_S + A * u^+ * x^- * \delta(t-t_{spk})
-		// I noticed that for connect(.., RangeDelay(1), ..) tD will be 0
-		int ind_minus = STP_BUF_POS(pre_i,(simTime-tD-1));
-		int ind_plus  = STP_BUF_POS(pre_i,(simTime-tD));
-
-		change *= grp_Info[pre_grpId].STP_A*stpu[ind_plus]*stpx[ind_minus];
-
-//		fprintf(stderr,"%d: %d[%d], numN=%d, td=%d, maxDelay_=%d, ind-=%d, ind+=%d, stpu=[%f,%f], stpx=[%f,%f], change=%f, wt=%f\n",
-//			simTime, pre_grpId, pre_i,
-//					numN, tD, maxDelay_, ind_minus, ind_plus,
-//					stpu[ind_minus], stpu[ind_plus], stpx[ind_minus], stpx[ind_plus], change, wt[pos_i]);
-	}
+	float change = getSynapticChange(pre_i, synWt[syn_i], tD);
 
 	// update currents
 	// NOTE: it's faster to += 0.0 rather than checking for zero and not updating
 	if (sim_with_conductances) {
 		if (pre_type & TARGET_AMPA) // if post_i expresses AMPAR
-			gAMPA [post_i] += change*mulSynFast[mulIndex]; // scale by some factor
+			gAMPA [post_i] += change*mulFast; // scale by some factor
 		if (pre_type & TARGET_NMDA) {
 			if (sim_with_NMDA_rise) {
-				gNMDA_r[post_i] += change*sNMDA*mulSynSlow[mulIndex];
-				gNMDA_d[post_i] += change*sNMDA*mulSynSlow[mulIndex];
+				gNMDA_r[post_i] += change*sNMDA*mulSlow;
+				gNMDA_d[post_i] += change*sNMDA*mulSlow;
 			} else {
-				gNMDA [post_i] += change*mulSynSlow[mulIndex];
+				gNMDA [post_i] += change*mulSlow;
 			}
 		}
 		if (pre_type & TARGET_GABAa)
-			gGABAa[post_i] -= change*mulSynFast[mulIndex]; // wt should be negative for GABAa and GABAb
+			gGABAa[post_i] -= change*mulFast; // wt should be negative for GABAa and GABAb
 		if (pre_type & TARGET_GABAb) {
 			if (sim_with_GABAb_rise) {
-				gGABAb_r[post_i] -= change*sGABAb*mulSynSlow[mulIndex];
-				gGABAb_d[post_i] -= change*sGABAb*mulSynSlow[mulIndex];
+				gGABAb_r[post_i] -= change*sGABAb*mulSlow;
+				gGABAb_d[post_i] -= change*sGABAb*mulSlow;
 			} else {
-				gGABAb[post_i] -= change*mulSynSlow[mulIndex];
+				gGABAb[post_i] -= change*mulSlow;
 			}
 		}
 	} else {
 		current[post_i] += change;
 	}
 
-	synSpikeTime[pos_i] = simTime;
+	updateSynapseOnPreSpike(post_i, pos_i, pre_type, numDASpikes);
+}
+
+// for each presynaptic spike, postsynaptic (synaptic) current is going to increase by some amplitude (change)
+// generally speaking, this amplitude is the weight; but it can be modulated by STP
+float CpuSNN::getSynapticChange(unsigned int pre_i, float weight, unsigned int tD) {
+	short int pre_grpId = grpIds[pre_i];
+
+	float change = weight;
+
+	if (grp_Info[pre_grpId].WithSTP) {
+		// if pre-group has STP enabled, we need to modulate the weight
+		// NOTE: Order is important! (Tsodyks & Markram, 1998; Mongillo, Barak, & Tsodyks, 2008)
+		// use u^+ (value right after spike-update) but x^- (value right before spike-update)
+
+		// dI/dt = -I/tau_S + A * u^+ * x^- * \delta(t-t_{spk})
+		// I noticed that for connect(.., RangeDelay(1), ..) tD will be 0
+		int ind_minus = STP_BUF_POS(pre_i,(simTime-tD-1));
+		int ind_plus  = STP_BUF_POS(pre_i,(simTime-tD));
+
+		change *= grp_Info[pre_grpId].STP_A*stpu[ind_plus]*stpx[ind_minus];
+
+//		fprintf(stderr,"%d: %d[%d], numN=%d, td=%d, maxDelay_=%d, ind-=%d, ind+=%d, stpu=[%f,%f], stpx=[%f,%f], change=%f, wt=%f\n",
+//			simTime, pre_grpId, pre_i,
+//					numN, tD, maxDelay_, ind_minus, ind_plus,
+//					stpu[ind_minus], stpu[ind_plus], stpx[ind_minus], stpx[ind_plus], change, weight);
+	}
 
-	// Got one spike from dopaminergic neuron, increase dopamine concentration in the target area
+	return change;
+}
+
+// the spike of a pre-synaptic neuron has arrived at synapse pos_i of neuron post_i
+void CpuSNN::updateSynapseOnPreSpike(unsigned int post_i, unsigned int pos_i, unsigned int pre_type,
+	int* numDASpikes)
+{
+	short int post_grpId = grpIds[post_i];
+
+	synSpikeTime[pos_i] = simTime;
+
+	// Got one spike from dopaminergic neuron: count it, dopamine concentration is increased in doCurrentUpdate
 	if (pre_type & TARGET_DA) {
-		cpuNetPtrs.grpDA[post_grpId] += 0.04;
+		numDASpikes[post_grpId]++;
 	}
 
 	// STDP calculation: the post-synaptic neuron fires before the arrival of a pre-synaptic spike
@@ -3384,7 +3925,8 @@ void CpuSNN::generatePostSpike(unsigned int pre_i, unsigned int idx_d, unsigned
 				switch (grp_Info[post_grpId].WithISTDPcurve) {
 				case EXP_CURVE: // exponential curve
 					if ((stdp_tDiff*grp_Info[post_grpId].TAU_MINUS_INV_INB)<25) { // LTD of inhibitory syanpse, which increase synapse weight
-						wtChange[pos_i] -= STDP(stdp_tDiff, grp_Info[post_grpId].ALPHA_MINUS_INB, grp_Info[post_grpId].TAU_MINUS_INV_INB);
+						wtChange[pos_i] -= stdpExpCurve(grpLTDInbLUT[post_grpId], stdp_tDiff, grp_Info[post_grpId].ALPHA_MINUS_INB,
+							grp_Info[post_grpId].TAU_MINUS_INV_INB);
 					}
 					break;
 				case PULSE_CURVE: // pulse curve
@@ -3404,7 +3946,8 @@ void CpuSNN::generatePostSpike(unsigned int pre_i, unsigned int idx_d, unsigned
 				case EXP_CURVE: // exponential curve
 				case TIMING_BASED_CURVE: // sc curve
 					if (stdp_tDiff * grp_Info[post_grpId].TAU_MINUS_INV_EXC < 25)
-						wtChange[pos_i] += STDP(stdp_tDiff, grp_Info[post_grpId].ALPHA_MINUS_EXC, grp_Info[post_grpId].TAU_MINUS_INV_EXC);
+						wtChange[pos_i] += stdpExpCurve(grpLTDExcLUT[post_grpId], stdp_tDiff, grp_Info[post_grpId].ALPHA_MINUS_EXC,
+							grp_Info[post_grpId].TAU_MINUS_INV_EXC);
 					break;
 				default:
 					KERNEL_ERROR("Invalid E-STDP curve");
@@ -3416,6 +3959,7 @@ void CpuSNN::generatePostSpike(unsigned int pre_i, unsigned int idx_d, unsigned
 	}
 }
 
+
 void CpuSNN::generateSpikes() {
 	PropagatedSpikeBuffer::const_iterator srg_iter;
 	PropagatedSpikeBuffer::const_iterator srg_iter_end = pbuf->endSpikeTargetGroups();
@@ -3488,12 +4032,8 @@ void CpuSNN::generateSpikesFromFuncPtr(int grpId) {
 }
 
 void CpuSNN::generateSpikesFromRate(int grpId) {
-	bool done;
 	PoissonRate* rate = grp_Info[grpId].RatePtr;
-	float refPeriod = grp_Info[grpId].RefractPeriod;
-	int timeSlice   = grp_Info[grpId].CurrTimeSlice;
 	unsigned int currTime = simTime;
-	int spikeCnt = 0;
 
 	if (rate == NULL)
 		return;
@@ -3510,34 +4050,109 @@ void CpuSNN::generateSpikesFromRate(int grpId) {
 		exitSimulation(1);
 	}
 
-	for (int neurId=0; neurId<nNeur; neurId++) {
-		float frate = rate->getRate(neurId);
+	// draw the spikes, in parallel if the group is large enough for every thread to get a block
+	bool inParallel = cpuWorkers_ != NULL && nNeur >= numThreads_*POISSON_BLOCK_SIZE;
+	if (inParallel) {
+		poissonGrpId_ = grpId;
+		cpuWorkers_->run(&CpuSNN::generateSpikesFromRateWorker, this);
+	} else {
+		poissonSpikeBuf[0].clear();
+		generateSpikesFromRateNeurons(grpId, 0, nNeur, poissonSpikeBuf[0]);
+	}
+
+	// schedule the spikes block by block (the same order for any number of threads)
+	for (int t=0; t<(inParallel ? numThreads_ : 1); t++) {
+		for (size_t i=0; i<poissonSpikeBuf[t].size(); i++) {
+			const poissonSpike_t& spk = poissonSpikeBuf[t][i];
+			pbuf->scheduleSpikeTargetGroup(grp_Info[grpId].StartN + spk.nid, spk.time - currTime);
+
+			// update number of spikes if SpikeCounter set
+			if (grp_Info[grpId].withSpikeCounter) {
+				int bufPos = grp_Info[grpId].spkCntBufPos; // retrieve buf pos
+				spkCntBuf[bufPos][spk.nid]++;
+			}
+		}
+	}
+}
+
+void CpuSNN::generateSpikesFromRateWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int grpId = self->poissonGrpId_;
+
+	// hand out whole blocks, so that the blocks are the same as for a single thread
+	int numBlocks = (self->grp_Info[grpId].SizeN + POISSON_BLOCK_SIZE - 1) / POISSON_BLOCK_SIZE;
+	int firstBlock, lastBlock;
+	CpuWorkerPool::getPartition(numBlocks, threadId, numThreads, firstBlock, lastBlock);
+
+	self->poissonSpikeBuf[threadId].clear();
+	self->generateSpikesFromRateNeurons(grpId, firstBlock*POISSON_BLOCK_SIZE,
+		std::min(lastBlock*POISSON_BLOCK_SIZE, self->grp_Info[grpId].SizeN), self->poissonSpikeBuf[threadId]);
+}
+
+void CpuSNN::generateSpikesFromRateNeurons(int grpId, int firstNeur, int lastNeur,
+	std::vector<poissonSpike_t>& spikes)
+{
+	PoissonRate* rate = grp_Info[grpId].RatePtr;
+	const int startN = grp_Info[grpId].StartN;
+	const unsigned int currTime = simTime;
+	const unsigned int endTime = simTime + grp_Info[grpId].CurrTimeSlice;
+
+	// refractory period must be 1 or greater, 0 means could have multiple spikes specified at the same time.
+	const unsigned int refPeriod = (unsigned int)grp_Info[grpId].RefractPeriod;
+	assert(refPeriod > 0);
+
+	// ISIs longer than this cannot end in the current time slice, capping them keeps the spike times from overflowing
+	const float maxISI = (float)endTime;
+
+	const uint32_t key[2] = {(uint32_t)randSeed_, RNG_STREAM_ID(RNG_STREAM_POISSON, grpId)};
+
+	int nId[POISSON_BLOCK_SIZE];			// neuron ID (relative to group)
+	unsigned int spkTime[POISSON_BLOCK_SIZE];	// time of last spike
+	float isiScale[POISSON_BLOCK_SIZE];		// mean ISI (ms) = 1000/rate
+
+	for (int blockStart=firstNeur; blockStart<lastNeur; blockStart+=POISSON_BLOCK_SIZE) {
+		int blockEnd = std::min(blockStart+POISSON_BLOCK_SIZE, lastNeur);
 
 		// start the time from the last time it spiked, that way we can ensure that the refractory period is maintained
-		unsigned int nextTime = lastSpikeTime[grp_Info[grpId].StartN + neurId];
-		if (nextTime == MAX_SIMULATION_TIME)
-			nextTime = 0;
+		int numActive = 0;
+		for (int neurId=blockStart; neurId<blockEnd; neurId++) {
+			float frate = rate->getRate(neurId);
+			if (frate <= 0.0f)
+				continue;
 
-		done = false;
-		while (!done && frate>0) {
-			nextTime = poissonSpike(nextTime, frate/1000.0, refPeriod);
-			// found a valid timeSlice
-			if (nextTime < (currTime+timeSlice)) {
-				if (nextTime >= currTime) {
-//					int nid = grp_Info[grpId].StartN+cnt;
-					pbuf->scheduleSpikeTargetGroup(grp_Info[grpId].StartN + neurId, nextTime-currTime);
-					spikeCnt++;
-
-					// update number of spikes if SpikeCounter set
-					if (grp_Info[grpId].withSpikeCounter) {
-						int bufPos = grp_Info[grpId].spkCntBufPos; // retrieve buf pos
-						spkCntBuf[bufPos][neurId]++;
-					}
-				}
+			unsigned int lastTime = lastSpikeTime[startN + neurId];
+			nId[numActive] = neurId;
+			spkTime[numActive] = (lastTime == MAX_SIMULATION_TIME) ? 0 : lastTime;
+			isiScale[numActive] = 1000.0f/frate;
+			numActive++;
+		}
+
+		while (numActive > 0) {
+			// draw the next spike of every active neuron
+			for (int i=0; i<numActive; i++) {
+				uint32_t ctr[2] = {(uint32_t)(startN + nId[i]), spkTime[i]};
+				uint32_t bits[2];
+				threefry2x32(ctr, key, bits);
+				float isi = std::min(-logf(uniformFromBits(bits[0])) * isiScale[i], maxISI);
+				spkTime[i] += refPeriod + (unsigned int)isi;
 			}
-			else {
-				done=true;
+
+			// keep the spikes that fall into the time slice, drop the neurons that are past it
+			int numLeft = 0;
+			for (int i=0; i<numActive; i++) {
+				if (spkTime[i] >= endTime)
+					continue;
+
+				if (spkTime[i] >= currTime) {
+					poissonSpike_t spk = {nId[i], spkTime[i]};
+					spikes.push_back(spk);
+				}
+				nId[numLeft] = nId[i];
+				spkTime[numLeft] = spkTime[i];
+				isiScale[numLeft] = isiScale[i];
+				numLeft++;
 			}
+			numActive = numLeft;
 		}
 	}
 }
@@ -3553,51 +4168,30 @@ inline int CpuSNN::getPoissNeuronPos(int nid) {
 //We need pass the neuron id (nid) and the grpId just for the case when we want to
 //ramp up/down the weights.  In that case we need to set the weights of each synapse
 //depending on their nid (their position with respect to one another). -- KDC
-float CpuSNN::getWeights(int connProp, float initWt, float maxWt, unsigned int nid, int grpId) {
+//Random weights are drawn from the stream of the connection at (preNId,postNId), so that resetting the weights
+//restores the initial ones.
+float CpuSNN::getWeights(grpConnectInfo_t* info, unsigned int preNId, unsigned int postNId) {
 	float actWts;
+	float initWt = info->initWt;
+	float maxWt = info->maxWt;
+	int grpId = info->grpSrc;
 	// \FIXME: are these ramping thingies still supported?
-	bool setRandomWeights   = GET_INITWTS_RANDOM(connProp);
-	bool setRampDownWeights = GET_INITWTS_RAMPDOWN(connProp);
-	bool setRampUpWeights   = GET_INITWTS_RAMPUP(connProp);
+	bool setRandomWeights   = GET_INITWTS_RANDOM(info->connProp);
+	bool setRampDownWeights = GET_INITWTS_RAMPDOWN(info->connProp);
+	bool setRampUpWeights   = GET_INITWTS_RAMPUP(info->connProp);
 
 	if (setRandomWeights)
-		actWts = initWt * drand48();
+		actWts = initWt * CounterRNG(randSeed_, RNG_STREAM_ID(RNG_STREAM_WEIGHTS, info->connId)).getUniform(preNId, postNId);
 	else if (setRampUpWeights)
-		actWts = (initWt + ((nid - grp_Info[grpId].StartN) * (maxWt - initWt) / grp_Info[grpId].SizeN));
+		actWts = (initWt + ((preNId - grp_Info[grpId].StartN) * (maxWt - initWt) / grp_Info[grpId].SizeN));
 	else if (setRampDownWeights)
-		actWts = (maxWt - ((nid - grp_Info[grpId].StartN) * (maxWt - initWt) / grp_Info[grpId].SizeN));
+		actWts = (maxWt - ((preNId - grp_Info[grpId].StartN) * (maxWt - initWt) / grp_Info[grpId].SizeN));
 	else
 		actWts = initWt;
 
 	return actWts;
 }
 
-// single integration step for voltage equation of 4-param Izhikevich
-inline
-float dvdtIzhikevich4(float volt, float recov, float totalCurrent, float timeStep=1.0f) {
-	return ( ((0.04f * volt + 5.0f) * volt + 140.0f - recov + totalCurrent) * timeStep );
-}
-
-// single integration step for recovery equation of 4-param Izhikevich
-inline
-float dudtIzhikevich4(float volt, float recov, float izhA, float izhB, float timeStep=1.0f) {
-	return ( izhA * (izhB * volt - recov) * timeStep );
-}
-
-// single integration step for voltage equation of 9-param Izhikevich
-inline
-float dvdtIzhikevich9(float volt, float recov, float invCapac, float izhK, float voltRest,
-	float voltInst,float totalCurrent, float timeStep=1.0f)
-{
-	return ( (izhK * (volt - voltRest) * (volt - voltInst) - recov + totalCurrent) * invCapac * timeStep );
-}
-
-// single integration step for recovery equation of 9-param Izhikevich
-inline
-float dudtIzhikevich9(float volt, float recov, float voltRest, float izhA, float izhB, float timeStep=1.0f) {
-	return ( izhA * (izhB * (volt - voltRest) - recov) * timeStep );
-}
-
 float CpuSNN::getCompCurrent(int grpId, int neurId, float const0, float const1) {
 	float compCurrent = 0.0f;
 	for (int k=0; k<grp_Info[grpId].numCompNeighbors; k++) {
@@ -3618,174 +4212,246 @@ void  CpuSNN::globalStateUpdate() {
 	// integration step.
 	// We do it this way because compartmental currents depend on neighboring neuron's voltages.
 	// We don't need a nextRecovery buffer because every neuron depends only on its own recovery value.
+	// This also means that every neuron can be updated independently, which is what CPU_MODE_MT makes use of.
+	for(int g=0; g<numGrp; g++) {
+		if (grp_Info[g].Type & POISSON_NEURON) {
+			continue;
+		}
+
+		// update group dopamine
+		cpuNetPtrs.grpDABuffer[g][simTimeMs] = cpuNetPtrs.grpDA[g];
+	}
+
 	for (int j=1; j<=simNumStepsPerMs_; j++) {
-		for(int g=0; g<numGrp; g++) {
-			if (grp_Info[g].Type & POISSON_NEURON) {
-				continue;
+		// In the fused state update, the last integration step also decays the conductances for the next time step.
+		// This is the same as decaying them at the beginning of the next time step (in globalStateDecay), because
+		// nothing else touches the conductances in between. Spikes are still delivered after the decay.
+		bool withDecay = fusedStateUpdate_ && j == simNumStepsPerMs_;
+
+		if (cpuWorkers_ != NULL) {
+			// every thread integrates a contiguous chunk of regular neurons
+			cpuWorkers_->run(withDecay ? &CpuSNN::globalStateUpdateDecayWorker : &CpuSNN::globalStateUpdateWorker,
+				this);
+		} else {
+			globalStateUpdateNeurons(0, numNReg, withDecay);
+		}
+
+		// Only after we are done computing nextVoltage for all neurons do we copy the new values to the voltage array.
+		// This is crucial for GPU (asynchronous kernel launch) and the multi-threaded CPU version.
+		memcpy(voltage, nextVoltage, sizeof(float)*numNReg);
+	}  // end simNumStepsPerMs_ loop
+}
+
+void CpuSNN::globalStateUpdateWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->numNReg, threadId, numThreads, firstNId, lastNId);
+	self->globalStateUpdateNeurons(firstNId, lastNId, false);
+}
+
+void CpuSNN::globalStateUpdateDecayWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->numNReg, threadId, numThreads, firstNId, lastNId);
+	self->globalStateUpdateNeurons(firstNId, lastNId, true);
+}
+
+void CpuSNN::globalStateUpdateNeurons(int firstNId, int lastNId, bool withDecay) {
+	for(int g=0; g<numGrp; g++) {
+		if (grp_Info[g].Type & POISSON_NEURON) {
+			continue;
+		}
+
+		// only look at the neurons of this group that fall into [firstNId,lastNId)
+		int startN = std::max(grp_Info[g].StartN, firstNId);
+		int endN = std::min(grp_Info[g].EndN, lastNId-1);
+		if (startN > endN) {
+			continue;
+		}
+
+		// compartmental currents depend on the voltage of other neurons, so compute them up front
+		if (grp_Info[g].withCompartments) {
+			for (int i=startN; i<=endN; i++) {
+				compCurrent[i] = getCompCurrent(g, i);
 			}
+		}
 
-			// update group dopamine
-			cpuNetPtrs.grpDABuffer[g][simTimeMs] = cpuNetPtrs.grpDA[g];
-
-			for (int i=grp_Info[g].StartN; i<=grp_Info[g].EndN; i++) {
-				// pre-load izhikevich variables to avoid unnecessary memory accesses + unclutter the code.
-				float k = Izh_k[i];
-				float vr = Izh_vr[i];
-				float vt = Izh_vt[i];
-				float inverse_C = 1.0f / Izh_C[i];
-				float a = Izh_a[i];
-				float b = Izh_b[i];
-
-				// sum up total current = synaptic + external + compartmental
-				float totalCurrent = extCurrent[i];
-				if (sim_with_conductances) { // COBA model
-					float tmp_gNMDA = sim_with_NMDA_rise ? gNMDA_d[i]-gNMDA_r[i] : gNMDA[i];
-					float tmp_gGABAb = sim_with_GABAb_rise ? gGABAb_d[i]-gGABAb_r[i] : gGABAb[i];
-					float tmp_iNMDA = (voltage[i] + 80.0f) * (voltage[i] + 80.0f) / 60.0f / 60.0f;
-
-					totalCurrent += -(gAMPA[i] * (voltage[i] - 0.0f) +
-						tmp_gNMDA * tmp_iNMDA / (1.0f + tmp_iNMDA) * (voltage[i] - 0.0f) +
-						gGABAa[i] * (voltage[i] + 70.0f) +
-						tmp_gGABAb * (voltage[i] + 90.0f));
-				} else { // CUBA model
-					totalCurrent += current[i];
-				}
-				if (grp_Info[g].withCompartments) {
-					totalCurrent += getCompCurrent(g, i);
-				}
+		// the kernel was specialized for this group's neuron model and the integration method in setupNetwork
+		IzhikevichKernelArgs args;
+		if (!withDecay) {
+			setIzhikevichKernelArgs(g, startN, endN, args);
+			grpIzhKernel[g](args);
+			continue;
+		}
 
-				switch (simIntegrationMethod_) {
-				case FORWARD_EULER:
-					if (!grp_Info[g].withParamModel_9) {
-						// 4-param Izhikevich
-						nextVoltage[i] = voltage[i] + dvdtIzhikevich4(voltage[i], recovery[i], totalCurrent, timeStep_);
-						if (nextVoltage[i] > 30.0f) {
-							nextVoltage[i] = 30.0f;
-							curSpike[i] = true;
-							nextVoltage[i] = Izh_c[i];
-							recovery[i] += Izh_d[i];
-						}
-					} else {
-						// 9-param Izhikevich
-						nextVoltage[i] = voltage[i] + dvdtIzhikevich9(voltage[i], recovery[i], inverse_C, k, vr, vt, 
-							totalCurrent, timeStep_);
-						if (nextVoltage[i] > Izh_vpeak[i]) {
-							nextVoltage[i] = Izh_vpeak[i];
-							curSpike[i] = true;
-							nextVoltage[i] = Izh_c[i];
-							recovery[i] += Izh_d[i];
-						}
-					}
-					if (nextVoltage[i] < -90.0f) {
-						nextVoltage[i] = -90.0f;
-					}
-					#if defined(WIN32) || defined(WIN64)
-						assert(!_isnan(nextVoltage[i]));
-						assert(_finite(nextVoltage[i]));
-					#else
-						assert(!isnan(nextVoltage[i]));
-						assert(!isinf(nextVoltage[i]));
-					#endif
-
-					// To maintain consistency with Izhikevich' original Matlab code, recovery is based on nextVoltage.
-					if (!grp_Info[g].withParamModel_9) {
-						recovery[i] += dudtIzhikevich4(nextVoltage[i], recovery[i], a, b, timeStep_);
-					} else {
-						recovery[i] += dudtIzhikevich9(nextVoltage[i], recovery[i], vr, a, b, timeStep_);
-					}
+		// Fused state update: integrate a block of neurons, then decay their conductances (or reset their currents)
+		// while these are still in the cache. Kernels give the same results no matter how the neurons are split up.
+		for (int blockStartN=startN; blockStartN<=endN; blockStartN+=FUSED_UPDATE_BLOCK_SIZE) {
+			int blockEndN = std::min(blockStartN+FUSED_UPDATE_BLOCK_SIZE-1, endN);
+			setIzhikevichKernelArgs(g, blockStartN, blockEndN, args);
+			grpIzhKernel[g](args);
 
-					break;
-				case RUNGE_KUTTA4:
-					// TODO for Stas
-					if (!grp_Info[g].withParamModel_9) {
-						// 4-param Izhikevich
-						float k1 = dvdtIzhikevich4(voltage[i], recovery[i], totalCurrent, timeStep_);
-						float l1 = dudtIzhikevich4(voltage[i], recovery[i], a, b, timeStep_);
-
-						float k2 = dvdtIzhikevich4(voltage[i] + k1/2.0f, recovery[i] + l1/2.0f, totalCurrent, 
-							timeStep_);
-						float l2 = dudtIzhikevich4(voltage[i] + k1/2.0f, recovery[i] + l1/2.0f, a, b, timeStep_);
-
-						float k3 = dvdtIzhikevich4(voltage[i] + k2/2.0f, recovery[i] + l2/2.0f, totalCurrent, 
-							timeStep_);
-						float l3 = dudtIzhikevich4(voltage[i] + k2/2.0f, recovery[i] + l2/2.0f, a, b, timeStep_);
-
-						float k4 = dvdtIzhikevich4(voltage[i] + k3, recovery[i] + l3, totalCurrent, timeStep_);
-						float l4 = dudtIzhikevich4(voltage[i] + k3, recovery[i] + l3, a, b, timeStep_);
-
-						nextVoltage[i] = voltage[i] + (1.0f / 6.0f) * (k1 + 2.0f * k2 + 2.0f * k3 + k4);
-						if (nextVoltage[i] > 30.0f) {
-							nextVoltage[i] = 30.0f;
-							curSpike[i] = true;
-							nextVoltage[i] = Izh_c[i];
-							recovery[i] += Izh_d[i];
-						}
-						if (nextVoltage[i] < -90.0f) {
-							nextVoltage[i] = -90.0f;
-						}
-						#if defined(WIN32) || defined(WIN64)
-						assert(!_isnan(nextVoltage[i]));
-						assert(_finite(nextVoltage[i]));
-						#else
-						assert(!isnan(nextVoltage[i]));
-						assert(!isinf(nextVoltage[i]));
-						#endif
-
-						recovery[i] += (1.0f / 6.0f) * (l1 + 2.0f * l2 + 2.0f * l3 + l4);
-					} else {
-						// 9-param Izhikevich
-
-						float k1 = dvdtIzhikevich9(voltage[i], recovery[i], inverse_C, k, vr, vt, totalCurrent, 
-							timeStep_);
-						float l1 = dudtIzhikevich9(voltage[i], recovery[i], vr, a, b, timeStep_);
-
-						float k2 = dvdtIzhikevich9(voltage[i] + k1/2.0f, recovery[i] + l1/2.0f, inverse_C, k, vr, vt, 
-							totalCurrent, timeStep_);
-						float l2 = dudtIzhikevich9(voltage[i] + k1/2.0f, recovery[i] + l1/2.0f, vr, a, b, timeStep_);
-
-						float k3 = dvdtIzhikevich9(voltage[i] + k2/2.0f, recovery[i] + l2/2.0f, inverse_C, k, vr, vt,
-							totalCurrent, timeStep_);
-						float l3 = dudtIzhikevich9(voltage[i] + k2/2.0f, recovery[i] + l2/2.0f, vr, a, b, timeStep_);
-
-						float k4 = dvdtIzhikevich9(voltage[i] + k3, recovery[i] + l3, inverse_C, k, vr, vt, 
-							totalCurrent, timeStep_);
-						float l4 = dudtIzhikevich9(voltage[i] + k3, recovery[i] + l3, vr, a, b, timeStep_);
-
-						nextVoltage[i] = voltage[i] + (1.0f / 6.0f) * (k1 + 2.0f * k2 + 2.0f * k3 + k4);
-
-						if (nextVoltage[i] > Izh_vpeak[i]) {
-							nextVoltage[i] = Izh_vpeak[i];
-							curSpike[i] = true;
-							nextVoltage[i] = Izh_c[i];
-							recovery[i] += Izh_d[i];
-						}
+			if (sim_with_conductances) {
+				(this->*grpFusedDecayKernel[g])(g, blockStartN, blockEndN+1);
+			} else {
+				memset(&current[blockStartN], 0, sizeof(float)*(blockEndN-blockStartN+1));
+			}
+		}
+	}  // end numGrp
+}
 
-						if (nextVoltage[i] < -90.0f) {
-							nextVoltage[i] = -90.0f;
-						}
-						#if defined(WIN32) || defined(WIN64)
-						assert(!_isnan(nextVoltage[i]));
-						assert(_finite(nextVoltage[i]));
-						#else
-						assert(!isnan(nextVoltage[i]));
-						assert(!isinf(nextVoltage[i]));
-						#endif
-
-						recovery[i] += (1.0f / 6.0f) * (l1 + 2.0f * l2 + 2.0f * l3 + l4);
-					}
-					break;
-				case UNKNOWN_INTEGRATION:
-				default:
-					KERNEL_ERROR("Unknown integration method.");
-					exitSimulation(1);
-				}
-			}  // end StartN...EndN
-		}  // end numGrp
+void CpuSNN::setIzhikevichKernelArgs(int grpId, int startN, int endN, IzhikevichKernelArgs& args) {
+	args.numNeurons = endN - startN + 1;
+	args.timeStep = timeStep_;
+	args.extCurrent = &extCurrent[startN];
+	args.compCurrent = grp_Info[grpId].withCompartments ? &compCurrent[startN] : NULL;
+	args.current = NULL;
+	args.gAMPA = args.gNMDA = args.gNMDA_r = args.gNMDA_d = NULL;
+	args.gGABAa = args.gGABAb = args.gGABAb_r = args.gGABAb_d = NULL;
+	if (sim_with_conductances) {
+		args.gAMPA = &gAMPA[startN];
+		if (sim_with_NMDA_rise) {
+			args.gNMDA_r = &gNMDA_r[startN];
+			args.gNMDA_d = &gNMDA_d[startN];
+		} else {
+			args.gNMDA = &gNMDA[startN];
+		}
+		args.gGABAa = &gGABAa[startN];
+		if (sim_with_GABAb_rise) {
+			args.gGABAb_r = &gGABAb_r[startN];
+			args.gGABAb_d = &gGABAb_d[startN];
+		} else {
+			args.gGABAb = &gGABAb[startN];
+		}
+	} else {
+		args.current = &current[startN];
+	}
+	args.Izh_a = &Izh_a[startN];
+	args.Izh_b = &Izh_b[startN];
+	args.Izh_c = &Izh_c[startN];
+	args.Izh_d = &Izh_d[startN];
+	args.Izh_C = &Izh_C[startN];
+	args.Izh_k = &Izh_k[startN];
+	args.Izh_vr = &Izh_vr[startN];
+	args.Izh_vt = &Izh_vt[startN];
+	args.Izh_vpeak = &Izh_vpeak[startN];
+	args.voltage = &voltage[startN];
+	args.nextVoltage = &nextVoltage[startN];
+	args.recovery = &recovery[startN];
+	args.firstNId = startN;
+	args.spikeBits = curSpikeBits;
+}
+
+// STDP only ever evaluates its exponential curves at an integer number of ms since the last pre- or post-synaptic
+// spike, and only as long as t*tauInv < 25. So instead of calling exp() for every plastic synapse of every spike, the
+// curves are sampled once per group. The samples are computed with the same expression and kept in double precision
+// (which is what STDP() returns), so that wtChange receives exactly the same values and results do not change.
+void CpuSNN::initSTDPLookupTables() {
+	grpLTPExcLUT = new stdpExpCurveLUT_t[numGrp];
+	grpLTDExcLUT = new stdpExpCurveLUT_t[numGrp];
+	grpLTPInbLUT = new stdpExpCurveLUT_t[numGrp];
+	grpLTDInbLUT = new stdpExpCurveLUT_t[numGrp];
+	memset(grpLTPExcLUT, 0, sizeof(stdpExpCurveLUT_t)*numGrp);
+	memset(grpLTDExcLUT, 0, sizeof(stdpExpCurveLUT_t)*numGrp);
+	memset(grpLTPInbLUT, 0, sizeof(stdpExpCurveLUT_t)*numGrp);
+	memset(grpLTDInbLUT, 0, sizeof(stdpExpCurveLUT_t)*numGrp);
 
-		// Only after we are done computing nextVoltage for all neurons do we copy the new values to the voltage array.
-		// This is crucial for GPU (asynchronous kernel launch) and in the future for a multi-threaded CARLsim version.
-		memcpy(voltage, nextVoltage, sizeof(float)*numNReg);
-	}  // end simNumStepsPerMs_ loop
+	for (int g=0; g<numGrp; g++) {
+		if (grp_Info[g].WithESTDP) {
+			// EXP_CURVE and TIMING_BASED_CURVE share the same exponentials
+			buildSTDPExpCurveLUT(grpLTPExcLUT[g], grp_Info[g].ALPHA_PLUS_EXC, grp_Info[g].TAU_PLUS_INV_EXC);
+			buildSTDPExpCurveLUT(grpLTDExcLUT[g], grp_Info[g].ALPHA_MINUS_EXC, grp_Info[g].TAU_MINUS_INV_EXC);
+		}
+		if (grp_Info[g].WithISTDP && grp_Info[g].WithISTDPcurve == EXP_CURVE) {
+			buildSTDPExpCurveLUT(grpLTPInbLUT[g], grp_Info[g].ALPHA_PLUS_INB, grp_Info[g].TAU_PLUS_INV_INB);
+			buildSTDPExpCurveLUT(grpLTDInbLUT[g], grp_Info[g].ALPHA_MINUS_INB, grp_Info[g].TAU_MINUS_INV_INB);
+		}
+	}
+}
+
+// The sampling loop must not be vectorized: with -ffast-math the compiler would otherwise call a vector version of
+// exp() that rounds differently from the scalar one used by STDP() on the fly.
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC push_options
+	#pragma GCC optimize("no-tree-vectorize")
+#endif
+void CpuSNN::buildSTDPExpCurveLUT(stdpExpCurveLUT_t& lut, float a, float tauInv) {
+	lut.values = NULL;
+	lut.length = 0;
+	if (!stdpLookupTable_ || tauInv <= 0.0f)
+		return;
+
+	// very slow curves are not worth the memory, they fall back to computing STDP
+	int length = 0;
+	while (length < STDP_LUT_MAX_LENGTH && length*tauInv < 25)
+		length++;
+
+	lut.values = new double[length];
+#if defined(__clang__)
+	#pragma clang loop vectorize(disable)
+#endif
+	for (int t=0; t<length; t++)
+		lut.values[t] = STDP(t, a, tauInv);
+	lut.length = length;
+	cpuSnnSz.addInfoSize += sizeof(double)*length;
+}
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC pop_options
+#endif
+
+double CpuSNN::stdpExpCurve(const stdpExpCurveLUT_t& lut, int t, float a, float tauInv) {
+	return (t < lut.length) ? lut.values[t] : STDP(t, a, tauInv);
+}
+
+// Every group gets a decay kernel, a neuron state update kernel, and a weight update kernel that are specialized for
+// everything that is fixed once the network is set up: the synapse model (COBA or CUBA, NMDA and GABAb rise times),
+// STP, homeostasis, compartments, the neuron model (4-param or 9-param Izhikevich), the integration method, and the
+// STDP types. This way none of these have to be checked inside the per-neuron loops. All kernels work on a range of
+// neurons, so any engine that splits up the neurons (such as CPU_MODE_MT) can use them as is. The neuron state update
+// kernels use the widest instruction set supported by the CPU.
+void CpuSNN::initNeuronKernels() {
+	if (simIntegrationMethod_ != FORWARD_EULER && simIntegrationMethod_ != RUNGE_KUTTA4) {
+		KERNEL_ERROR("Unknown integration method.");
+		exitSimulation(1);
+	}
+
+	grpDecayKernel = new groupKernel_t[numGrp];
+	if (fusedStateUpdate_)
+		grpFusedDecayKernel = new groupKernel_t[numGrp];
+	grpIzhKernel = new izhikevichKernel_t[numGrp];
+	grpWeightKernel = new groupKernel_t[numGrp];
+	bool withCompartments = false;
+	for (int g=0; g<numGrp; g++) {
+		// Poisson neurons have no conductances
+		bool withConductances = sim_with_conductances && !(grp_Info[g].Type & POISSON_NEURON);
+		if (fusedStateUpdate_) {
+			// conductances are decayed by globalStateUpdate, everything else by globalStateDecay
+			grpDecayKernel[g] = getDecayKernel(false, false, false, grp_Info[g].WithSTP, grp_Info[g].WithHomeostasis);
+			grpFusedDecayKernel[g] = getDecayKernel(withConductances, sim_with_NMDA_rise, sim_with_GABAb_rise, false,
+				false);
+		} else {
+			grpDecayKernel[g] = getDecayKernel(withConductances, sim_with_NMDA_rise, sim_with_GABAb_rise,
+				grp_Info[g].WithSTP, grp_Info[g].WithHomeostasis);
+		}
+		grpIzhKernel[g] = getIzhikevichKernel(simdLevel_, simIntegrationMethod_, grp_Info[g].withParamModel_9,
+			sim_with_conductances, sim_with_NMDA_rise, sim_with_GABAb_rise, grp_Info[g].withCompartments);
+		withCompartments |= grp_Info[g].withCompartments;
+
+		if (grp_Info[g].FixedInputWts || !grp_Info[g].WithSTDP) {
+			grpWeightKernel[g] = NULL;
+		} else {
+			grpWeightKernel[g] = getWeightUpdateKernel(grp_Info[g].WithESTDPtype, grp_Info[g].WithISTDPtype,
+				grp_Info[g].WithHomeostasis);
+		}
+	}
+
+	if (withCompartments) {
+		compCurrent = new float[numNReg];
+		memset(compCurrent, 0, sizeof(float)*numNReg);
+		cpuSnnSz.neuronInfoSize += sizeof(float)*numNReg;
+	}
+
+	KERNEL_INFO("Using %s kernels for the neuron state update", simdLevel_string[simdLevel_]);
 }
 
 // initialize all the synaptic weights to appropriate values..
@@ -3972,6 +4638,49 @@ bool CpuSNN::isPoint3DinRF(const RadiusRF& radius, const Point3D& pre, const Poi
 	return (rfDist >= 0.0 && rfDist <= 1.0);
 }
 
+// finds the range of grid indices [first,last] along x, y, and z of group grpId in which neurons can lie in the RF of
+// a post-neuron at location post (the range is empty if first>last)
+// scale is applied to the locations of grpId before comparing them to post (see buildConnection for gaussian)
+void CpuSNN::getRFGridBounds(const RadiusRF& radius, int grpId, const double scale[3], const Point3D& post,
+	int first[3], int last[3])
+{
+	int size[3] = {grp_Info[grpId].SizeX, grp_Info[grpId].SizeY, grp_Info[grpId].SizeZ};
+	double rad[3] = {radius.radX, radius.radY, radius.radZ};
+	double center[3] = {post.x, post.y, post.z};
+
+	for (int d=0; d<3; d++) {
+		if (rad[d] < 0) {
+			// the RF is not limited along this dimension
+			first[d] = 0;
+			last[d] = size[d] - 1;
+		} else {
+			// a neuron with grid index k lies at (k-(size-1)/2)*scale (see getNeuronLocation3D)
+			// be generous with rounding, the exact RF test is done by the caller
+			double offset = (size[d]-1)/2.0;
+			first[d] = (int)std::max(0.0, ceil((center[d] - rad[d])/scale[d] + offset - 1e-6));
+			last[d] = (int)std::min(size[d]-1.0, floor((center[d] + rad[d])/scale[d] + offset + 1e-6));
+		}
+	}
+}
+
+// returns an upper bound for the number of neurons of group grpId that lie in the RF of any single neuron, where the
+// locations of grpId are scaled by scale (see getRFGridBounds)
+int CpuSNN::getRFGridMaxNeurons(const RadiusRF& radius, int grpId, const double scale[3]) {
+	int size[3] = {grp_Info[grpId].SizeX, grp_Info[grpId].SizeY, grp_Info[grpId].SizeZ};
+	double rad[3] = {radius.radX, radius.radY, radius.radZ};
+
+	int numNeurons = 1;
+	for (int d=0; d<3; d++) {
+		if (rad[d] < 0) {
+			numNeurons *= size[d];
+		} else {
+			// same rounding as getRFGridBounds
+			numNeurons *= (int)std::min(1.0*size[d], floor(2.0*rad[d]/scale[d] + 2e-6) + 1.0);
+		}
+	}
+	return numNeurons;
+}
+
 double CpuSNN::getRFDist3D(const RadiusRF& radius, const Point3D& pre, const Point3D& post) {
 	// Note: RadiusRF rad is assumed to be the fanning in to the post neuron. So if the radius is 10 pixels, it means
 	// that if you look at the post neuron, it will receive input from neurons that code for locations no more than
@@ -4060,35 +4769,6 @@ void CpuSNN::makePtrInfo() {
 	cpuNetPtrs.stpx				= stpx;
 }
 
-// will be used in generateSpikesFromRate
-// The time between each pair of consecutive events has an exponential distribution with parameter \lambda and
-// each of these ISI values is assumed to be independent of other ISI values.
-// What follows a Poisson distribution is the actual number of spikes sent during a certain interval.
-unsigned int CpuSNN::poissonSpike(unsigned int currTime, float frate, int refractPeriod) {
-	// refractory period must be 1 or greater, 0 means could have multiple spikes specified at the same time.
-	assert(refractPeriod>0);
-	assert(frate>=0.0f);
-
-	bool done = false;
-	unsigned int nextTime = 0;
-	while (!done) {
-		// A Poisson process will always generate inter-spike-interval (ISI) values from an exponential distribution.
-		float randVal = drand48();
-		unsigned int tmpVal  = -log(randVal)/frate;
-
-		// add new ISI to current time
-		// this might be faster than keeping currTime fixed until drand48() returns a large enough value for the ISI
-		nextTime = currTime + tmpVal;
-
-		// reject new firing time if ISI is smaller than refractory period
-		if ((nextTime - currTime) >= (unsigned) refractPeriod)
-			done = true;
-	}
-
-	assert(nextTime != 0);
-	return nextTime;
-}
-
 int CpuSNN::loadSimulation_internal(bool onlyPlastic) {
 	// TSC: so that we can restore the file position later...
 	// MB: not sure why though...
@@ -4371,6 +5051,50 @@ void CpuSNN::reorganizeDelay() {
 	}
 }
 
+// Spike delivery (push) walks the post-synaptic connections of a pre-neuron in the order of postSynapticIds, which is
+// sorted by delay (see reorganizeDelay). Looking up the target of every synapse from there requires a chain of
+// dependent loads (postSynapticIds -> cumulativePre -> wt, cumConnIdPre -> mulSynFast/mulSynSlow).
+// Here we resolve that chain once and store the result in a structure-of-arrays copy that uses the same indexing as
+// postSynapticIds, so that delivering a spike streams linearly through a few contiguous arrays. The pre-synaptic
+// arrays remain the primary storage (e.g., for STDP); synWt is refreshed from wt whenever synWtDirty_ is set.
+// updateWeights only ever changes plastic synapses, so their indices are collected in synPlastic, and only those are
+// refreshed when synPlasticWtDirty_ is set.
+void CpuSNN::reorganizeDelivery() {
+	synPostNId	= new unsigned int[postSynCnt+1];
+	synPrePos	= new unsigned int[postSynCnt+1];
+	synWt		= new float[postSynCnt+1];
+	synMulFast	= new float[postSynCnt+1];
+	synMulSlow	= new float[postSynCnt+1];
+	cpuSnnSz.synapticInfoSize += (2*sizeof(unsigned int) + 3*sizeof(float)) * (postSynCnt+1);
+
+	// plastic synapses come first among the pre-synaptic connections of a neuron
+	numSynPlastic_ = 0;
+	for (int nid=0; nid<numN; nid++) {
+		for (unsigned int j=cumulativePost[nid]; j<cumulativePost[nid]+Npost[nid]; j++) {
+			unsigned int post_i = GET_CONN_NEURON_ID(postSynapticIds[j]);
+			unsigned int pos_i = cumulativePre[post_i] + GET_CONN_SYN_ID(postSynapticIds[j]);
+			short int connId = cumConnIdPre[pos_i];
+			assert(connId>=0 && connId<numConnections);
+
+			synPostNId[j]	= post_i;
+			synPrePos[j]	= pos_i;
+			synMulFast[j]	= mulSynFast[connId];
+			synMulSlow[j]	= mulSynSlow[connId];
+			if (GET_CONN_SYN_ID(postSynapticIds[j]) < Npre_plastic[post_i])
+				numSynPlastic_++;
+		}
+	}
+
+	synPlastic = new unsigned int[numSynPlastic_+1];
+	cpuSnnSz.synapticInfoSize += sizeof(unsigned int) * (numSynPlastic_+1);
+	for (unsigned int j=0, k=0; j<postSynCnt; j++) {
+		if (GET_CONN_SYN_ID(postSynapticIds[j]) < Npre_plastic[synPostNId[j]])
+			synPlastic[k++] = j;
+	}
+
+	synWtDirty_ = true;
+}
+
 // after all the initalization. Its time to create the synaptic weights, weight change and also
 // time of firing these are the mostly costly arrays so dense packing is essential to minimize wastage of space
 void CpuSNN::reorganizeNetwork(bool removeTempMemory) {
@@ -4476,6 +5200,16 @@ void CpuSNN::resetFiringInformation() {
 	resetPropogationBuffer();
 	// reset Timing  Table..
 	resetTimingTable();
+
+	// forget about all spikes in the ring of fired neurons
+	for (int t=0; t<firingRingSize_; t++) {
+		firingRingD1[t].clear();
+		firingRingD2[t].clear();
+	}
+
+	// forget about all spikes still in transit
+	if (firingBitmap != NULL)
+		memset(firingBitmap, 0, sizeof(uint32_t)*(maxDelay_ > 1 ? maxDelay_ : 1)*firingBitmapWords_);
 }
 
 #ifndef __NO_CUDA__
@@ -4522,15 +5256,17 @@ void CpuSNN::resetNeuron(unsigned int neurId, int grpId) {
 		exitSimulation(1);
 	}
 
-	Izh_C[neurId] = grp_Info2[grpId].Izh_C + grp_Info2[grpId].Izh_C_sd*(float)drand48();
-	Izh_k[neurId] = grp_Info2[grpId].Izh_k + grp_Info2[grpId].Izh_k_sd*(float)drand48();
-	Izh_vr[neurId] = grp_Info2[grpId].Izh_vr + grp_Info2[grpId].Izh_vr_sd*(float)drand48();
-	Izh_vt[neurId] = grp_Info2[grpId].Izh_vt + grp_Info2[grpId].Izh_vt_sd*(float)drand48();
-	Izh_a[neurId] = grp_Info2[grpId].Izh_a + grp_Info2[grpId].Izh_a_sd*(float)drand48();
-	Izh_b[neurId] = grp_Info2[grpId].Izh_b + grp_Info2[grpId].Izh_b_sd*(float)drand48();
-	Izh_vpeak[neurId] = grp_Info2[grpId].Izh_vpeak + grp_Info2[grpId].Izh_vpeak_sd*(float)drand48();
-	Izh_c[neurId] = grp_Info2[grpId].Izh_c + grp_Info2[grpId].Izh_c_sd*(float)drand48();
-	Izh_d[neurId] = grp_Info2[grpId].Izh_d + grp_Info2[grpId].Izh_d_sd*(float)drand48();
+	// the parameter variability of every neuron is drawn from the stream of its group, addressed by (neuron, parameter)
+	CounterRNG rng(randSeed_, RNG_STREAM_ID(RNG_STREAM_NEURONS, grpId));
+	Izh_C[neurId] = grp_Info2[grpId].Izh_C + grp_Info2[grpId].Izh_C_sd*rng.getUniform(neurId, 0);
+	Izh_k[neurId] = grp_Info2[grpId].Izh_k + grp_Info2[grpId].Izh_k_sd*rng.getUniform(neurId, 1);
+	Izh_vr[neurId] = grp_Info2[grpId].Izh_vr + grp_Info2[grpId].Izh_vr_sd*rng.getUniform(neurId, 2);
+	Izh_vt[neurId] = grp_Info2[grpId].Izh_vt + grp_Info2[grpId].Izh_vt_sd*rng.getUniform(neurId, 3);
+	Izh_a[neurId] = grp_Info2[grpId].Izh_a + grp_Info2[grpId].Izh_a_sd*rng.getUniform(neurId, 4);
+	Izh_b[neurId] = grp_Info2[grpId].Izh_b + grp_Info2[grpId].Izh_b_sd*rng.getUniform(neurId, 5);
+	Izh_vpeak[neurId] = grp_Info2[grpId].Izh_vpeak + grp_Info2[grpId].Izh_vpeak_sd*rng.getUniform(neurId, 6);
+	Izh_c[neurId] = grp_Info2[grpId].Izh_c + grp_Info2[grpId].Izh_c_sd*rng.getUniform(neurId, 7);
+	Izh_d[neurId] = grp_Info2[grpId].Izh_d + grp_Info2[grpId].Izh_d_sd*rng.getUniform(neurId, 8);
 
 	// initialize membrane potential to reset potential
 	float vreset = grp_Info[grpId].withParamModel_9 ? Izh_vr[neurId] : Izh_c[neurId];
@@ -4541,10 +5277,12 @@ void CpuSNN::resetNeuron(unsigned int neurId, int grpId) {
 
  	if (grp_Info[grpId].WithHomeostasis) {
 		// set the baseFiring with some standard deviation.
-		if (drand48()>0.5)   {
-			baseFiring[neurId] = grp_Info2[grpId].baseFiring + grp_Info2[grpId].baseFiringSD*-log(drand48());
+		uint32_t bits[2];
+		rng.getBits(neurId, 9, bits);
+		if (uniform01FromBits(bits[0])>0.5)   {
+			baseFiring[neurId] = grp_Info2[grpId].baseFiring + grp_Info2[grpId].baseFiringSD*-log(uniformFromBits(bits[1]));
 		} else  {
-			baseFiring[neurId] = grp_Info2[grpId].baseFiring - grp_Info2[grpId].baseFiringSD*-log(drand48());
+			baseFiring[neurId] = grp_Info2[grpId].baseFiring - grp_Info2[grpId].baseFiringSD*-log(uniformFromBits(bits[1]));
 			if(baseFiring[neurId] < 0.1) baseFiring[neurId] = 0.1;
 		}
 
@@ -4606,6 +5344,44 @@ void CpuSNN::resetPointers(bool deallocate) {
 	if (spikeGenBits!=NULL && deallocate) delete[] spikeGenBits;
 	pbuf=NULL; spikeGenBits=NULL;
 
+	if (cpuWorkers_!=NULL && deallocate) delete cpuWorkers_;
+	if (grpDASpikeCnt!=NULL && deallocate) delete[] grpDASpikeCnt;
+	if (poissonSpikeBuf!=NULL && deallocate) delete[] poissonSpikeBuf;
+	cpuWorkers_=NULL; grpDASpikeCnt=NULL; poissonSpikeBuf=NULL;
+
+	if (preSynDelay!=NULL && deallocate) delete[] preSynDelay;
+	if (firingBitmap!=NULL && deallocate) delete[] firingBitmap;
+	preSynDelay=NULL; firingBitmap=NULL;
+
+	if (firingRingD1!=NULL && deallocate) delete[] firingRingD1;
+	if (firingRingD2!=NULL && deallocate) delete[] firingRingD2;
+	firingRingD1=NULL; firingRingD2=NULL;
+
+	if (synPostNId!=NULL && deallocate) delete[] synPostNId;
+	if (synPrePos!=NULL && deallocate) delete[] synPrePos;
+	if (synWt!=NULL && deallocate) delete[] synWt;
+	if (synMulFast!=NULL && deallocate) delete[] synMulFast;
+	if (synMulSlow!=NULL && deallocate) delete[] synMulSlow;
+	if (synPlastic!=NULL && deallocate) delete[] synPlastic;
+	synPostNId=NULL; synPrePos=NULL; synWt=NULL; synMulFast=NULL; synMulSlow=NULL; synPlastic=NULL;
+
+	if (grpDecayKernel!=NULL && deallocate) delete[] grpDecayKernel;
+	if (grpFusedDecayKernel!=NULL && deallocate) delete[] grpFusedDecayKernel;
+	if (grpWeightKernel!=NULL && deallocate) delete[] grpWeightKernel;
+	if (grpIzhKernel!=NULL && deallocate) delete[] grpIzhKernel;
+	if (compCurrent!=NULL && deallocate) delete[] compCurrent;
+	grpDecayKernel=NULL; grpFusedDecayKernel=NULL; grpWeightKernel=NULL; grpIzhKernel=NULL; compCurrent=NULL;
+
+	stdpExpCurveLUT_t* stdpLUTs[] = {grpLTPExcLUT, grpLTDExcLUT, grpLTPInbLUT, grpLTDInbLUT};
+	for (int k=0; k<4; k++) {
+		if (stdpLUTs[k]!=NULL && deallocate) {
+			for (int g=0; g<numGrp; g++)
+				delete[] stdpLUTs[k][g].values;
+			delete[] stdpLUTs[k];
+		}
+	}
+	grpLTPExcLUT=NULL; grpLTDExcLUT=NULL; grpLTPInbLUT=NULL; grpLTDInbLUT=NULL;
+
 	// clear all existing connection info
 	if (deallocate) {
 		while (connectBegin) {
@@ -4667,7 +5443,9 @@ void CpuSNN::resetPointers(bool deallocate) {
 	if (current!=NULL && deallocate) delete[] current;
 	if (extCurrent!=NULL && deallocate) delete[] extCurrent;
 	if (curSpike!=NULL && deallocate) delete[] curSpike;
+	if (curSpikeBits!=NULL && deallocate) delete[] curSpikeBits;
 	voltage=NULL; nextVoltage=NULL; recovery=NULL; current=NULL; extCurrent=NULL; curSpike = NULL;
+	curSpikeBits = NULL;
 
 	if (Izh_C != NULL && deallocate) delete[] Izh_C;
 	if (Izh_k != NULL && deallocate) delete[] Izh_k;
@@ -4847,7 +5625,7 @@ void CpuSNN::resetSynapticConnections(bool changeWeights) {
 				// if connection was plastic or if the connection weights were updated we need to reset the weights
 				// TODO: How to account for user-defined connection reset
 				if ((synWtType == SYN_PLASTIC) || connInfo->newUpdates) {
-					*synWtPtr = getWeights(connInfo->connProp, connInfo->initWt, connInfo->maxWt, nid, srcGrp);
+					*synWtPtr = getWeights(connInfo, preId, nid);
 					*maxWtPtr = connInfo->maxWt;
 				}
 			}
@@ -4861,11 +5639,17 @@ void CpuSNN::resetSynapticConnections(bool changeWeights) {
 		connInfo->newUpdates = false;
 		connInfo = connInfo->next;
 	}
+
+	synWtDirty_ = true;
 }
 
 void CpuSNN::resetTimingTable() {
-		memset(timeTableD2, 0, sizeof(int) * (1000 + maxDelay_ + 1));
-		memset(timeTableD1, 0, sizeof(int) * (1000 + maxDelay_ + 1));
+	// the timing tables only exist in GPU_MODE
+	if (timeTableD2 == NULL)
+		return;
+
+	memset(timeTableD2, 0, sizeof(int) * (1000 + maxDelay_ + 1));
+	memset(timeTableD1, 0, sizeof(int) * (1000 + maxDelay_ + 1));
 }
 
 
@@ -4948,7 +5732,7 @@ inline void CpuSNN::setConnection(int srcGrp,  int destGrp,  unsigned int src, u
 	if (Npost[src] > grp_Info2[srcGrp].maxPostConn)
 		grp_Info2[srcGrp].maxPostConn = Npost[src];
 	if (Npre[dest] > grp_Info2[destGrp].maxPreConn)
-	grp_Info2[destGrp].maxPreConn = Npre[src];
+		grp_Info2[destGrp].maxPreConn = Npre[dest];
 }
 
 void CpuSNN::setGrpTimeSlice(int grpId, int timeSlice) {
@@ -4979,9 +5763,37 @@ int CpuSNN::setRandSeed(int seed) {
 // of all variable for carrying out the simulation..
 // this code is run only one time during network initialization
 void CpuSNN::setupNetwork(bool removeTempMem) {
+	// spawn the worker threads once, they will be used to build the network and then reused every time step
+	if (simMode_ == CPU_MODE_MT && cpuWorkers_ == NULL) {
+		cpuWorkers_ = new CpuWorkerPool(numThreads_);
+		numThreads_ = cpuWorkers_->getNumThreads();
+		KERNEL_INFO("Running CPU_MODE_MT with %d thread(s)", numThreads_);
+	}
+
 	if(!doneReorganization)
 		reorganizeNetwork(removeTempMem);
 
+	// every thread counts the dopaminergic spikes it delivers in its own set of per-group counters
+	if (grpDASpikeCnt == NULL) {
+		grpDASpikeCnt = new int[numThreads_*numGrp];
+		memset(grpDASpikeCnt, 0, sizeof(int)*numThreads_*numGrp);
+	}
+
+	// every thread draws Poisson spikes into its own buffer
+	if (poissonSpikeBuf == NULL)
+		poissonSpikeBuf = new std::vector<poissonSpike_t>[numThreads_];
+
+	if (simMode_ != GPU_MODE) {
+		if (grpIzhKernel == NULL)
+			initNeuronKernels();
+		if (grpLTPExcLUT == NULL)
+			initSTDPLookupTables();
+
+		chooseSpikePropagation();
+		if (spikePropagation_ == PUSH_PROPAGATION && synPostNId == NULL)
+			reorganizeDelivery();
+	}
+
 #ifndef __NO_CUDA__
 	if((simMode_ == GPU_MODE) && (cpu_gpuNetPtrs.allocated == false))
 		allocateSNN_GPU();
@@ -5018,7 +5830,7 @@ void CpuSNN::startTesting(bool shallUpdateWeights) {
 			float storeScaleSTDP = stdpScaleFactor_;
 			stdpScaleFactor_ = 1.0f/wtANDwtChangeUpdateIntervalCnt_;
 
-			if (simMode_ == CPU_MODE) {
+			if (simMode_ != GPU_MODE) {
 				updateWeights();
 #ifndef __NO_CUDA__
 			} else{
@@ -5054,6 +5866,21 @@ void CpuSNN::stopTesting() {
 }
 
 
+// refreshes the delivery copy of the weights after wt has changed (only for PUSH_PROPAGATION on the CPU)
+void CpuSNN::syncDeliveryWeights() {
+	if (synWtDirty_) {
+		for (unsigned int j=0; j<postSynCnt; j++)
+			synWt[j] = wt[synPrePos[j]];
+	} else {
+		for (unsigned int k=0; k<numSynPlastic_; k++) {
+			unsigned int j = synPlastic[k];
+			synWt[j] = wt[synPrePos[j]];
+		}
+	}
+	synWtDirty_ = false;
+	synPlasticWtDirty_ = false;
+}
+
 void CpuSNN::swapConnections(int nid, int oldPos, int newPos) {
 	unsigned int cumN=cumulativePost[nid];
 
@@ -5100,62 +5927,61 @@ void CpuSNN::updateConnectionMonitor(short int connId) {
 			int timeInterval = connMonCoreList[monId]->getUpdateTimeIntervalSec();
 			if (timeInterval==1 || (timeInterval>1 && (getSimTime()%timeInterval)==0)) {
 				// this ConnectionMonitor wants periodic recording
-				connMonCoreList[monId]->writeConnectFileSnapshot(simTime,
-					getWeightMatrix2D(connMonCoreList[monId]->getConnectId()));
+				connMonCoreList[monId]->writeConnectFileSnapshot(simTime);
 			}
 		}
 	}
 }
 
 
-std::vector< std::vector<float> > CpuSNN::getWeightMatrix2D(short int connId) {
+// the synapses of a connection in CSR layout, aligned with the order of preSynapticIds
+void CpuSNN::getConnectionSynapses(short int connId, std::vector<int>& synPtr, std::vector<int>& preIds) {
 	assert(connId!=ALL);
-	grpConnectInfo_t* connInfo = connectBegin;
-	std::vector< std::vector<float> > wtConnId;
+	grpConnectInfo_t* connInfo = getConnectInfo(connId);
+	int grpIdPre = connInfo->grpSrc;
+	int grpIdPost = connInfo->grpDest;
+
+	synPtr.clear();
+	preIds.clear();
+	synPtr.reserve(grp_Info[grpIdPost].SizeN+1);
+	synPtr.push_back(0);
+	for (int postId=grp_Info[grpIdPost].StartN; postId<=grp_Info[grpIdPost].EndN; postId++) {
+		unsigned int pos_ij = cumulativePre[postId];
+		for (int i=0; i<Npre[postId]; i++, pos_ij++) {
+			// skip synapses that belong to a different connection ID
+			if (cumConnIdPre[pos_ij]!=connId)
+				continue;
 
-	// loop over all connections and find the ones with Connection Monitors
-	while (connInfo) {
-		if (connInfo->connId==connId) {
-			int grpIdPre = connInfo->grpSrc;
-			int grpIdPost = connInfo->grpDest;
-
-			// init weight matrix with right dimensions
-			for (int i=0; i<grp_Info[grpIdPre].SizeN; i++) {
-				std::vector<float> wtSlice;
-				for (int j=0; j<grp_Info[grpIdPost].SizeN; j++) {
-					wtSlice.push_back(NAN);
-				}
-				wtConnId.push_back(wtSlice);
-			}
+			preIds.push_back(GET_CONN_NEURON_ID(preSynapticIds[pos_ij]) - grp_Info[grpIdPre].StartN);
+		}
+		synPtr.push_back(preIds.size());
+	}
+}
+
+// the weight magnitudes of a connection, in the order of getConnectionSynapses
+void CpuSNN::getConnectionWeights(short int connId, std::vector<float>& wts) {
+	assert(connId!=ALL);
+	grpConnectInfo_t* connInfo = getConnectInfo(connId);
+	int grpIdPost = connInfo->grpDest;
 
 #ifndef __NO_CUDA__
-			// copy the weights for a given post-group from device
-			// \TODO: check if the weights for this grpIdPost have already been copied
-			// \TODO: even better, but tricky because of ordering, make copyWeightState connection-based
-			if (simMode_==GPU_MODE) {
-				copyWeightState(&cpuNetPtrs, &cpu_gpuNetPtrs, cudaMemcpyDeviceToHost, false, grpIdPost);
-			}
+	// copy the weights for a given post-group from device
+	// \TODO: check if the weights for this grpIdPost have already been copied
+	// \TODO: even better, but tricky because of ordering, make copyWeightState connection-based
+	if (simMode_==GPU_MODE) {
+		copyWeightState(&cpuNetPtrs, &cpu_gpuNetPtrs, cudaMemcpyDeviceToHost, false, grpIdPost);
+	}
 #endif
 
-			for (int postId=grp_Info[grpIdPost].StartN; postId<=grp_Info[grpIdPost].EndN; postId++) {
-				unsigned int pos_ij = cumulativePre[postId];
-				for (int i=0; i<Npre[postId]; i++, pos_ij++) {
-					// skip synapses that belong to a different connection ID
-					if (cumConnIdPre[pos_ij]!=connInfo->connId)
-						continue;
-
-					// find pre-neuron ID and update ConnectionMonitor container
-					int preId = GET_CONN_NEURON_ID(preSynapticIds[pos_ij]);
-					wtConnId[preId-getGroupStartNeuronId(grpIdPre)][postId-getGroupStartNeuronId(grpIdPost)] =
-						fabs(wt[pos_ij]);
-				}
-			}
-			break;
+	// the vector keeps its capacity, so there is no allocation after the first call
+	wts.clear();
+	for (int postId=grp_Info[grpIdPost].StartN; postId<=grp_Info[grpIdPost].EndN; postId++) {
+		unsigned int pos_ij = cumulativePre[postId];
+		for (int i=0; i<Npre[postId]; i++, pos_ij++) {
+			if (cumConnIdPre[pos_ij]==connId)
+				wts.push_back(fabs(wt[pos_ij]));
 		}
-		connInfo = connInfo->next;
 	}
-
-	return wtConnId;
 }
 
 void CpuSNN::updateGroupMonitor(int grpId) {
@@ -5317,6 +6143,7 @@ void CpuSNN::updateSpikeGeneratorsInit() {
 }
 
 //! update CpuSNN::maxSpikesD1, CpuSNN::maxSpikesD2 and allocate sapce for CpuSNN::firingTableD1 and CpuSNN::firingTableD2
+//! (GPU_MODE only)
 /*!
  * \return maximum delay in groups
  */
@@ -5340,6 +6167,11 @@ int CpuSNN::updateSpikeTables() {
 		newInfo = newInfo->next;
 	}
 
+	// the fixed-size firing tables are only needed on the GPU, the CPU stores its spikes in a ring of growable lists
+	// (see buildNetworkInit)
+	if (simMode_ != GPU_MODE)
+		return curD;
+
 	for(int g = 0; g < numGrp; g++) {
 		if (grp_Info[g].MaxDelay == 1)
 			maxSpikesD1 += (grp_Info[g].SizeN * grp_Info[g].MaxFiringRate);
@@ -5355,41 +6187,45 @@ int CpuSNN::updateSpikeTables() {
 
 	firingTableD2 = new unsigned int[maxSpikesD2];
 	firingTableD1 = new unsigned int[maxSpikesD1];
-	cpuSnnSz.spikingInfoSize += sizeof(int) * ((maxSpikesD2 + maxSpikesD1) + 2* (1000 + maxDelay_ + 1));
+	cpuSnnSz.spikingInfoSize += sizeof(int) * (maxSpikesD2 + maxSpikesD1);
 
 	return curD;
 }
 
 // This function is called every second by simulator...
-// This function updates the firingTable by removing older firing values...
+// This function accumulates the firing counts of the last second. There is no need to compact the firing table anymore,
+// because every slot of firingRingD1 and firingRingD2 is simply recycled once it is too old.
 void CpuSNN::updateFiringTable() {
-	// Read the neuron ids that fired in the last maxDelay_ seconds
-	// and put it to the beginning of the firing table...
-	for(unsigned int p=timeTableD2[999],k=0;p<timeTableD2[999+maxDelay_+1];p++,k++) {
-		firingTableD2[k]=firingTableD2[p];
-	}
-
-	for(int i=0; i < maxDelay_; i++) {
-		timeTableD2[i+1] = timeTableD2[1000+i+1]-timeTableD2[1000];
-	}
-
-	timeTableD1[maxDelay_] = 0;
-
 	/* the code of weight update has been moved to CpuSNN::updateWeights() */
 
 	spikeCountAllHost	+= spikeCountAll1secHost;
-	spikeCountD2Host += (secD2fireCntHost-timeTableD2[maxDelay_]);
+	spikeCountD2Host += secD2fireCntHost;
 	spikeCountD1Host += secD1fireCntHost;
 
 	secD1fireCntHost  = 0;
 	spikeCountAll1secHost = 0;
-	secD2fireCntHost = timeTableD2[maxDelay_];
+	secD2fireCntHost = 0;
 
 	for (int i=0; i < numGrp; i++) {
 		grp_Info[i].FiringCount1sec=0;
 	}
 }
 
+// marks all neurons that fired in this time step in firingBitmap (only for PULL_PROPAGATION)
+// the bitmap of time t lives in slot t%maxDelay_, overwriting the spikes that are too old to be delivered anymore
+void CpuSNN::updateFiringBitmap() {
+	int numSlots = maxDelay_ > 1 ? maxDelay_ : 1;
+	uint32_t* bitmap = &firingBitmap[(simTime % numSlots) * firingBitmapWords_];
+	memset(bitmap, 0, sizeof(uint32_t)*firingBitmapWords_);
+
+	const std::vector<unsigned int>& firedD2 = firingRingD2[simTime % firingRingSize_];
+	for (size_t k=0; k<firedD2.size(); k++)
+		bitmap[firedD2[k]/32] |= (1u << (firedD2[k]%32));
+	const std::vector<unsigned int>& firedD1 = firingRingD1[simTime % firingRingSize_];
+	for (size_t k=0; k<firedD1.size(); k++)
+		bitmap[firedD1[k]/32] |= (1u << (firedD1[k]%32));
+}
+
 // updates simTime, returns true when new second started
 bool CpuSNN::updateTime() {
 	bool finishedOneSec = false;
@@ -5417,18 +6253,25 @@ void CpuSNN::updateSpikeMonitor(int grpId) {
 	if (!numSpikeMonitor)
 		return;
 
-	if (grpId==ALL) {
-		for (int g=0; g<numGrp; g++)
-			updateSpikeMonitor(g);
-	} else {
-		// update spike monitor of a specific group
+	// all monitors that need an update are served by a single pass through the firing table
+	// for every monitor, record the time from which on spikes are new to it (or -1 if it is up-to-date)
+	int64_t updateFrom[MAX_GRP_PER_SNN];
+	SpikeFileWriter* spkFileWriter[MAX_GRP_PER_SNN];
+	bool writeSpikesToArray[MAX_GRP_PER_SNN];
+	int64_t minLastUpdate = -1;
+	for (unsigned int i=0; i<numSpikeMonitor; i++)
+		updateFrom[i] = -1;
+
+	for (int g=0; g<numGrp; g++) {
+		if (grpId!=ALL && g!=grpId)
+			continue;
 
 		// find index in spike monitor arrays
-		int monitorId = grp_Info[grpId].SpikeMonitorId;
+		int monitorId = grp_Info[g].SpikeMonitorId;
 
 		// don't continue if no spike monitor enabled for this group
 		if (monitorId<0)
-			return;
+			continue;
 
 		// find last update time for this group
 		SpikeMonitorCore* spkMonObj = spikeMonCoreList[monitorId];
@@ -5436,94 +6279,113 @@ void CpuSNN::updateSpikeMonitor(int grpId) {
 
 		// don't continue if time interval is zero (nothing to update)
 		if ( ((int64_t)getSimTime()) - lastUpdate <=0)
-			return;
+			continue;
 
 		if ( ((int64_t)getSimTime()) - lastUpdate > 1000)
-			KERNEL_ERROR("updateSpikeMonitor(grpId=%d) must be called at least once every second",grpId);
+			KERNEL_ERROR("updateSpikeMonitor(grpId=%d) must be called at least once every second",g);
 
         // AER buffer max size warning here.
         // Because of C++ short-circuit evaluation, the last condition should not be evaluated
         // if the previous conditions are false.
         if (spkMonObj->getAccumTime() > LONG_SPIKE_MON_DURATION \
-                && this->getGroupNumNeurons(grpId) > LARGE_SPIKE_MON_GRP_SIZE \
+                && this->getGroupNumNeurons(g) > LARGE_SPIKE_MON_GRP_SIZE \
                 && spkMonObj->isBufferBig()){
             // change this warning message to correct message
-            KERNEL_WARN("updateSpikeMonitor(grpId=%d) is becoming very large. (>%ld MB)",grpId,(int64_t) MAX_SPIKE_MON_BUFFER_SIZE/1024 );// make this better
-            KERNEL_WARN("Reduce the cumulative recording time (currently %lu minutes) or the group size (currently %d) to avoid this.",spkMonObj->getAccumTime()/(1000*60),this->getGroupNumNeurons(grpId));
+            KERNEL_WARN("updateSpikeMonitor(grpId=%d) is becoming very large. (>%ld MB)",g,(int64_t) MAX_SPIKE_MON_BUFFER_SIZE/1024 );// make this better
+            KERNEL_WARN("Reduce the cumulative recording time (currently %lu minutes) or the group size (currently %d) to avoid this.",spkMonObj->getAccumTime()/(1000*60),this->getGroupNumNeurons(g));
 		}
+
+		// prepare fast access
+		// spikes are encoded into blocks in memory, which are written to disk by a background thread
+		updateFrom[monitorId] = lastUpdate;
+		spkFileWriter[monitorId] = spkMonObj->getSpikeFileWriter();
+		writeSpikesToArray[monitorId] = spkMonObj->needsSpikes();
+		if (minLastUpdate<0 || lastUpdate<minLastUpdate)
+			minLastUpdate = lastUpdate;
+
+		// save current time as last update time
+		spkMonObj->setLastUpdated( (int64_t)getSimTime() );
+	}
+
+	// don't continue if all monitors are up-to-date
+	if (minLastUpdate<0)
+		return;
+
 #ifndef __NO_CUDA__
-		if (simMode_ == GPU_MODE) {
-			// copy the neuron firing information from the GPU to the CPU..
-			copyFiringInfo_GPU();
-		}
+	if (simMode_ == GPU_MODE) {
+		// copy the neuron firing information from the GPU to the CPU..
+		copyFiringInfo_GPU();
+	}
 #endif
 
-		// find the time interval in which to update spikes
-		// usually, we call updateSpikeMonitor once every second, so the time interval is [0,1000)
-		// however, updateSpikeMonitor can be called at any time t \in [0,1000)... so we can have the cases
-		// [0,t), [t,1000), and even [t1, t2)
-		int numMsMin = lastUpdate%1000; // lower bound is given by last time we called update
-		int numMsMax = getSimTimeMs(); // upper bound is given by current time
-		if (numMsMax==0)
-			numMsMax = 1000; // special case: full second
-		assert(numMsMin<numMsMax);
+	// find the time interval in which to update spikes
+	// usually, we call updateSpikeMonitor once every second, so the time interval is [0,1000)
+	// however, updateSpikeMonitor can be called at any time t \in [0,1000)... so we can have the cases
+	// [0,t), [t,1000), and even [t1, t2)
+	// the interval covers the monitor that was updated longest ago, the others skip the spikes they already have
+	int numMsMin = minLastUpdate%1000; // lower bound is given by last time we called update
+	int numMsMax = getSimTimeMs(); // upper bound is given by current time
+	if (numMsMax==0)
+		numMsMax = 1000; // special case: full second
+	assert(numMsMin<numMsMax);
+
+	// current time is last completed second in milliseconds (plus t to be added below)
+	// special case is after each completed second where !getSimTimeMs(): here we look 1s back
+	int currentTimeSec = getSimTimeSec();
+	if (!getSimTimeMs())
+		currentTimeSec--;
+
+	// Read one spike at a time from the buffer and put the spikes to an appopriate monitor buffer. Later the user
+	// may need need to dump these spikes to an output file
+	for (int k=0; k < 2; k++) {
+		for(int t=numMsMin; t<numMsMax; t++) {
+			// find the neurons that fired at time t, either in the ring (CPU) or in the firing table copied from
+			// the GPU
+			unsigned int* fireTablePtr;
+			unsigned int numFired;
+			if (simMode_ == GPU_MODE) {
+				unsigned int* timeTablePtr = (k==0)?timeTableD2:timeTableD1;
+				fireTablePtr = ((k==0)?firingTableD2:firingTableD1) + timeTablePtr[t+maxDelay_];
+				numFired = timeTablePtr[t+maxDelay_+1] - timeTablePtr[t+maxDelay_];
+			} else {
+				// the slot of time t is still intact, because the ring holds more than 1000 ms
+				std::vector<unsigned int>& fired = ((k==0)?firingRingD2:firingRingD1)[(currentTimeSec*1000 + t)
+					% firingRingSize_];
+				fireTablePtr = fired.empty() ? NULL : &fired[0];
+				numFired = fired.size();
+			}
 
-		// current time is last completed second in milliseconds (plus t to be added below)
-		// special case is after each completed second where !getSimTimeMs(): here we look 1s back
-		int currentTimeSec = getSimTimeSec();
-		if (!getSimTimeMs())
-			currentTimeSec--;
+			// current time is last completed second plus whatever is leftover in t
+			int time = currentTimeSec*1000 + t;
 
-		// save current time as last update time
-		spkMonObj->setLastUpdated( (int64_t)getSimTime() );
+			for(unsigned int i=0; i<numFired; i++) {
+				// retrieve the neuron id
+				int nid   = fireTablePtr[i];
+				if (simMode_ == GPU_MODE)
+					nid = GET_FIRING_TABLE_NID(nid);
+				assert(nid < numN);
+
+				// find the monitor of the neuron's group, if any, and make sure the spike is new to it
+				int this_grpId = grpIds[nid];
+				int monitorId = grp_Info[this_grpId].SpikeMonitorId;
+				if (monitorId<0 || updateFrom[monitorId]<0 || time<updateFrom[monitorId])
+					continue;
 
-		// prepare fast access
-		FILE* spkFileId = spikeMonCoreList[monitorId]->getSpikeFileId();
-		bool writeSpikesToFile = spkFileId!=NULL;
-		bool writeSpikesToArray = spkMonObj->getMode()==AER && spkMonObj->isRecording();
-
-		// Read one spike at a time from the buffer and put the spikes to an appopriate monitor buffer. Later the user
-		// may need need to dump these spikes to an output file
-		for (int k=0; k < 2; k++) {
-			unsigned int* timeTablePtr = (k==0)?timeTableD2:timeTableD1;
-			unsigned int* fireTablePtr = (k==0)?firingTableD2:firingTableD1;
-			for(int t=numMsMin; t<numMsMax; t++) {
-				for(unsigned int i=timeTablePtr[t+maxDelay_]; i<timeTablePtr[t+maxDelay_+1];i++) {
-					// retrieve the neuron id
-					int nid   = fireTablePtr[i];
-					if (simMode_ == GPU_MODE)
-						nid = GET_FIRING_TABLE_NID(nid);
-					assert(nid < numN);
-
-					// make sure neuron belongs to currently relevant group
-					int this_grpId = grpIds[nid];
-					if (this_grpId != grpId)
-						continue;
-
-					// adjust nid to be 0-indexed for each group
-					// this way, if a group has 10 neurons, their IDs in the spike file and spike monitor will be
-					// indexed from 0..9, no matter what their real nid is
-					nid -= grp_Info[grpId].StartN;
-					assert(nid>=0);
-
-					// current time is last completed second plus whatever is leftover in t
-					int time = currentTimeSec*1000 + t;
-
-					if (writeSpikesToFile) {
-						int cnt;
-						cnt = fwrite(&time, sizeof(int), 1, spkFileId); assert(cnt==1);
-						cnt = fwrite(&nid,  sizeof(int), 1, spkFileId); assert(cnt==1);
-					}
+				// adjust nid to be 0-indexed for each group
+				// this way, if a group has 10 neurons, their IDs in the spike file and spike monitor will be
+				// indexed from 0..9, no matter what their real nid is
+				nid -= grp_Info[this_grpId].StartN;
+				assert(nid>=0);
 
-					if (writeSpikesToArray) {
-						spkMonObj->pushAER(time,nid);
-					}
+				if (spkFileWriter[monitorId]!=NULL) {
+					spkFileWriter[monitorId]->pushSpike(time, nid);
+				}
+
+				if (writeSpikesToArray[monitorId]) {
+					spikeMonCoreList[monitorId]->pushAER(time,nid);
 				}
 			}
 		}
-
-		if (spkFileId!=NULL) // flush spike file
-			fflush(spkFileId);
 	}
 }
 
@@ -5533,99 +6395,145 @@ void CpuSNN::updateWeights() {
 	assert(sim_in_testing==false);
 	assert(sim_with_fixedwts==false);
 
+	for(int g = 0; g < numGrp; g++) {
+		if (grpWeightKernel[g] != NULL) {
+			int i = grp_Info[g].StartN;
+			float diff_firing = grp_Info[g].WithHomeostasis ? 1-avgFiring[i]/baseFiring[i] : 0.0f;
+			KERNEL_DEBUG("Weights, Change at %lu (diff_firing: %f)", simTimeSec, diff_firing);
+		}
+	}
+
 	// update synaptic weights here for all the neurons..
+	// every synapse belongs to exactly one post-synaptic neuron, so threads can work on separate ranges of neurons
+	if (cpuWorkers_ != NULL) {
+		cpuWorkers_->run(&CpuSNN::updateWeightsWorker, this);
+	} else {
+		updateWeightsNeurons(0, numNReg);
+	}
+
+	synPlasticWtDirty_ = true;
+}
+
+void CpuSNN::updateWeightsWorker(void* snn, int threadId, int numThreads) {
+	CpuSNN* self = (CpuSNN*)snn;
+	int firstNId, lastNId;
+	CpuWorkerPool::getPartition(self->numNReg, threadId, numThreads, firstNId, lastNId);
+	self->updateWeightsNeurons(firstNId, lastNId);
+}
+
+void CpuSNN::updateWeightsNeurons(int firstNId, int lastNId) {
 	for(int g = 0; g < numGrp; g++) {
 		// no changable weights so continue without changing..
-		if(grp_Info[g].FixedInputWts || !(grp_Info[g].WithSTDP))
+		if (grpWeightKernel[g] == NULL)
 			continue;
 
-		for(int i = grp_Info[g].StartN; i <= grp_Info[g].EndN; i++) {
-			assert(i < numNReg);
-			unsigned int offset = cumulativePre[i];
-			float diff_firing = 0.0;
-			float homeostasisScale = 1.0;
+		(this->*grpWeightKernel[g])(g, firstNId, lastNId);
+	}
+}
+
+// The synapse loop is free of branches (the STDP types and homeostasis are template arguments, and the weights are
+// clamped with min/max), so that the compiler can vectorize it.
+template<stdpType_t ESTDP_TYPE, stdpType_t ISTDP_TYPE, bool HOMEO>
+void CpuSNN::updateWeightsGroup(int grpId, int firstNId, int lastNId) {
+	// only look at the neurons of this group that fall into [firstNId,lastNId)
+	int startN = std::max(grp_Info[grpId].StartN, firstNId);
+	int endN = std::min(grp_Info[grpId].EndN, lastNId-1);
+
+	const float stdpScaleFactor = stdpScaleFactor_;
+	const float wtChangeDecay = wtChangeDecay_;
+	const float grpDA = cpuNetPtrs.grpDA[grpId];
+	const float homeostasisScale = HOMEO ? grp_Info[grpId].homeostasisScale : 1.0f;
+	const float avgTimeScale = grp_Info[grpId].avgTimeScale;
+
+	for(int i = startN; i <= endN; i++) {
+		assert(i < numNReg);
+		unsigned int offset = cumulativePre[i];
+		float* wt_i = &wt[offset];
+		float* wtChange_i = &wtChange[offset];
+		const float* maxSynWt_i = &maxSynWt[offset];
+		int numPlastic = Npre_plastic[i];
+
+		float diff_firing = 0.0f;
+		float homeoFactor = 0.0f;
+		if (HOMEO) {
+			assert(baseFiring[i]>0);
+			diff_firing = 1-avgFiring[i]/baseFiring[i];
+			homeoFactor = baseFiring[i]/avgTimeScale/(1+fabs(diff_firing)*50);
+		}
 
-			if(grp_Info[g].WithHomeostasis) {
-				assert(baseFiring[i]>0);
-				diff_firing = 1-avgFiring[i]/baseFiring[i];
-				homeostasisScale = grp_Info[g].homeostasisScale;
-			}
+		for(int j = 0; j < numPlastic; j++) {
+			float w = wt_i[j];
+			float effectiveWtChange = stdpScaleFactor * wtChange_i[j];
 
-			if (i==grp_Info[g].StartN)
-				KERNEL_DEBUG("Weights, Change at %lu (diff_firing: %f)", simTimeSec, diff_firing);
-
-			for(int j = 0; j < Npre_plastic[i]; j++) {
-				//	if (i==grp_Info[g].StartN)
-				//		KERNEL_DEBUG("%1.2f %1.2f \t", wt[offset+j]*10, wtChange[offset+j]*10);
-				float effectiveWtChange = stdpScaleFactor_ * wtChange[offset + j];
-//				if (wtChange[offset+j])
-//					printf("connId=%d, wtChange[%d]=%f\n",cumConnIdPre[offset+j],offset+j,wtChange[offset+j]);
-
-				// homeostatic weight update
-				// FIXME: check WithESTDPtype and WithISTDPtype first and then do weight change update
-				switch (grp_Info[g].WithESTDPtype) {
-				case STANDARD:
-					if (grp_Info[g].WithHomeostasis) {
-						wt[offset+j] += (diff_firing*wt[offset+j]*homeostasisScale + wtChange[offset+j])*baseFiring[i]/grp_Info[g].avgTimeScale/(1+fabs(diff_firing)*50);
-					} else {
-						// just STDP weight update
-						wt[offset+j] += effectiveWtChange;
-					}
-					break;
-				case DA_MOD:
-					if (grp_Info[g].WithHomeostasis) {
-						effectiveWtChange = cpuNetPtrs.grpDA[g] * effectiveWtChange;
-						wt[offset+j] += (diff_firing*wt[offset+j]*homeostasisScale + effectiveWtChange)*baseFiring[i]/grp_Info[g].avgTimeScale/(1+fabs(diff_firing)*50);
-					} else {
-						wt[offset+j] += cpuNetPtrs.grpDA[g] * effectiveWtChange;
-					}
-					break;
-				case UNKNOWN_STDP:
-				default:
-					// we shouldn't even be in here if !WithSTDP
-					break;
+			// homeostatic weight update
+			// FIXME: check WithESTDPtype and WithISTDPtype first and then do weight change update
+			if (ESTDP_TYPE == STANDARD) {
+				if (HOMEO) {
+					w += (diff_firing*w*homeostasisScale + wtChange_i[j])*homeoFactor;
+				} else {
+					// just STDP weight update
+					w += effectiveWtChange;
 				}
-
-				switch (grp_Info[g].WithISTDPtype) {
-				case STANDARD:
-					if (grp_Info[g].WithHomeostasis) {
-						wt[offset+j] += (diff_firing*wt[offset+j]*homeostasisScale + wtChange[offset+j])*baseFiring[i]/grp_Info[g].avgTimeScale/(1+fabs(diff_firing)*50);
-					} else {
-						// just STDP weight update
-						wt[offset+j] += effectiveWtChange;
-					}
-					break;
-				case DA_MOD:
-					if (grp_Info[g].WithHomeostasis) {
-						effectiveWtChange = cpuNetPtrs.grpDA[g] * effectiveWtChange;
-						wt[offset+j] += (diff_firing*wt[offset+j]*homeostasisScale + effectiveWtChange)*baseFiring[i]/grp_Info[g].avgTimeScale/(1+fabs(diff_firing)*50);
-					} else {
-						wt[offset+j] += cpuNetPtrs.grpDA[g] * effectiveWtChange;
-					}
-					break;
-				case UNKNOWN_STDP:
-				default:
-					// we shouldn't even be in here if !WithSTDP
-					break;
+			} else if (ESTDP_TYPE == DA_MOD) {
+				if (HOMEO) {
+					effectiveWtChange = grpDA * effectiveWtChange;
+					w += (diff_firing*w*homeostasisScale + effectiveWtChange)*homeoFactor;
+				} else {
+					w += grpDA * effectiveWtChange;
 				}
+			}
 
-				// It is users' choice to decay weight change or not
-				// see setWeightAndWeightChangeUpdate()
-				wtChange[offset+j] *= wtChangeDecay_;
-
-				// if this is an excitatory or inhibitory synapse
-				if (maxSynWt[offset + j] >= 0) {
-					if (wt[offset + j] >= maxSynWt[offset + j])
-						wt[offset + j] = maxSynWt[offset + j];
-					if (wt[offset + j] < 0)
-						wt[offset + j] = 0.0;
+			if (ISTDP_TYPE == STANDARD) {
+				if (HOMEO) {
+					w += (diff_firing*w*homeostasisScale + wtChange_i[j])*homeoFactor;
+				} else {
+					// just STDP weight update
+					w += effectiveWtChange;
+				}
+			} else if (ISTDP_TYPE == DA_MOD) {
+				if (HOMEO) {
+					effectiveWtChange = grpDA * effectiveWtChange;
+					w += (diff_firing*w*homeostasisScale + effectiveWtChange)*homeoFactor;
 				} else {
-					if (wt[offset + j] <= maxSynWt[offset + j])
-						wt[offset + j] = maxSynWt[offset + j];
-					if (wt[offset+j] > 0)
-						wt[offset+j] = 0.0;
+					w += grpDA * effectiveWtChange;
 				}
 			}
+
+			// It is users' choice to decay weight change or not
+			// see setWeightAndWeightChangeUpdate()
+			wtChange_i[j] *= wtChangeDecay;
+
+			// excitatory synapses stay within [0,maxSynWt], inhibitory synapses within [maxSynWt,0]
+			float maxWt = maxSynWt_i[j];
+			wt_i[j] = (maxWt >= 0.0f) ? std::max(std::min(w, maxWt), 0.0f) : std::min(std::max(w, maxWt), 0.0f);
 		}
 	}
 }
+
+CpuSNN::groupKernel_t CpuSNN::getWeightUpdateKernel(stdpType_t estdpType, stdpType_t istdpType, bool withHomeostasis)
+{
+	// anything but STANDARD and DA_MOD does not change the weights
+	if (estdpType != STANDARD && estdpType != DA_MOD)
+		estdpType = UNKNOWN_STDP;
+	if (istdpType != STANDARD && istdpType != DA_MOD)
+		istdpType = UNKNOWN_STDP;
+
+	#define WEIGHT_KERNEL(ESTDP_TYPE, ISTDP_TYPE) \
+		(withHomeostasis ? &CpuSNN::updateWeightsGroup<ESTDP_TYPE,ISTDP_TYPE,true> \
+			: &CpuSNN::updateWeightsGroup<ESTDP_TYPE,ISTDP_TYPE,false>)
+	#define WEIGHT_KERNEL_I(ESTDP_TYPE) \
+		(istdpType == STANDARD ? WEIGHT_KERNEL(ESTDP_TYPE, STANDARD) \
+			: (istdpType == DA_MOD ? WEIGHT_KERNEL(ESTDP_TYPE, DA_MOD) : WEIGHT_KERNEL(ESTDP_TYPE, UNKNOWN_STDP)))
+
+	groupKernel_t kernel;
+	if (estdpType == STANDARD)
+		kernel = WEIGHT_KERNEL_I(STANDARD);
+	else if (estdpType == DA_MOD)
+		kernel = WEIGHT_KERNEL_I(DA_MOD);
+	else
+		kernel = WEIGHT_KERNEL_I(UNKNOWN_STDP);
+
+	#undef WEIGHT_KERNEL_I
+	#undef WEIGHT_KERNEL
+	return kernel;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#include <spike_file_writer.h>
+
+#include <assert.h>
+
+
+SpikeFileWriter::SpikeFileWriter(FILE* fileId, spikeFileFormat_t format, int blockSize) {
+	assert(fileId!=NULL);
+	assert(blockSize >= BLOCK_HEADER_SIZE + MAX_BYTES_PER_SPIKE);
+	fileId_ = fileId;
+	format_ = format;
+	blockSize_ = blockSize;
+	writeError_ = false;
+
+	// one block to fill, the others are free
+	block_ = new char[blockSize_];
+	for (int i=1; i<NUM_BLOCKS; i++)
+		freeBlocks_.push_back(new char[blockSize_]);
+	resetBlock();
+
+#if !defined(WIN32) && !defined(WIN64)
+	busy_ = false;
+	shutdown_ = false;
+	pthread_mutex_init(&mutex_, NULL);
+	pthread_cond_init(&workCond_, NULL);
+	pthread_cond_init(&doneCond_, NULL);
+	if (pthread_create(&thread_, NULL, &SpikeFileWriter::writerLoop, this)) {
+		// could not spawn thread: write on the calling thread instead
+		shutdown_ = true;
+	}
+#endif
+}
+
+SpikeFileWriter::~SpikeFileWriter() {
+	flush();
+
+#if !defined(WIN32) && !defined(WIN64)
+	if (!shutdown_) {
+		pthread_mutex_lock(&mutex_);
+		shutdown_ = true;
+		pthread_cond_signal(&workCond_);
+		pthread_mutex_unlock(&mutex_);
+		pthread_join(thread_, NULL);
+	}
+
+	pthread_cond_destroy(&doneCond_);
+	pthread_cond_destroy(&workCond_);
+	pthread_mutex_destroy(&mutex_);
+#endif
+
+	delete[] block_;
+	for (unsigned int i=0; i<freeBlocks_.size(); i++)
+		delete[] freeBlocks_[i];
+}
+
+void SpikeFileWriter::flush() {
+	submitBlock();
+
+#if !defined(WIN32) && !defined(WIN64)
+	// wait until the background thread has written everything
+	pthread_mutex_lock(&mutex_);
+	while (!fullBlocks_.empty() || busy_)
+		pthread_cond_wait(&doneCond_, &mutex_);
+	pthread_mutex_unlock(&mutex_);
+#endif
+
+	if (fflush(fileId_))
+		writeError_ = true;
+}
+
+bool SpikeFileWriter::hasError() {
+#if !defined(WIN32) && !defined(WIN64)
+	pthread_mutex_lock(&mutex_);
+	bool err = writeError_;
+	pthread_mutex_unlock(&mutex_);
+	return err;
+#else
+	return writeError_;
+#endif
+}
+
+void SpikeFileWriter::submitBlock() {
+	if (blockNumSpikes_ == 0)
+		return;
+
+	fullBlock_t full;
+	full.data = block_;
+	full.numBytes = blockPos_;
+	if (format_ == SPK_FILE_COMPACT) {
+		int header[2] = {blockNumSpikes_, blockPos_ - BLOCK_HEADER_SIZE};
+		memcpy(block_, header, sizeof(header));
+	}
+
+#if !defined(WIN32) && !defined(WIN64)
+	if (!shutdown_) {
+		pthread_mutex_lock(&mutex_);
+		fullBlocks_.push_back(full);
+		pthread_cond_signal(&workCond_);
+
+		// continue with the next free block, wait for one if the disk is lagging behind
+		while (freeBlocks_.empty())
+			pthread_cond_wait(&doneCond_, &mutex_);
+		block_ = freeBlocks_.back();
+		freeBlocks_.pop_back();
+		pthread_mutex_unlock(&mutex_);
+
+		resetBlock();
+		return;
+	}
+#endif
+
+	// no background thread: write right away and reuse the block
+	writeBlock(full);
+	resetBlock();
+}
+
+void SpikeFileWriter::resetBlock() {
+	blockPos_ = (format_ == SPK_FILE_COMPACT) ? BLOCK_HEADER_SIZE : 0;
+	blockNumSpikes_ = 0;
+	lastTime_ = 0;
+}
+
+void SpikeFileWriter::writeBlock(const fullBlock_t& block) {
+	if (fwrite(block.data, 1, block.numBytes, fileId_) != block.numBytes)
+		writeError_ = true;
+}
+
+void* SpikeFileWriter::writerLoop(void* arg) {
+#if !defined(WIN32) && !defined(WIN64)
+	SpikeFileWriter* writer = (SpikeFileWriter*)arg;
+
+	pthread_mutex_lock(&writer->mutex_);
+	while (true) {
+		while (writer->fullBlocks_.empty() && !writer->shutdown_)
+			pthread_cond_wait(&writer->workCond_, &writer->mutex_);
+		if (writer->fullBlocks_.empty())
+			break; // shut down, and nothing left to write
+
+		fullBlock_t block = writer->fullBlocks_.front();
+		writer->fullBlocks_.pop_front();
+		writer->busy_ = true;
+		pthread_mutex_unlock(&writer->mutex_);
+
+		bool ok = fwrite(block.data, 1, block.numBytes, writer->fileId_) == block.numBytes;
+
+		pthread_mutex_lock(&writer->mutex_);
+		if (!ok)
+			writer->writeError_ = true;
+		writer->freeBlocks_.push_back(block.data);
+		writer->busy_ = false;
+		pthread_cond_broadcast(&writer->doneCond_);
+	}
+	pthread_mutex_unlock(&writer->mutex_);
+#endif
+	return NULL;
+}
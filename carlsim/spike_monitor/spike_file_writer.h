@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _SPIKE_FILE_WRITER_H_
+#define _SPIKE_FILE_WRITER_H_
+
+#include <carlsim_datastructures.h>	// spikeFileFormat_t
+#include <varint.h>					// encodeVarint, zigZagEncode
+#include <stdio.h>					// FILE
+#include <stdint.h>					// uint32_t
+#include <string.h>					// memcpy
+#include <deque>					// std::deque
+#include <vector>					// std::vector
+
+#if !defined(WIN32) && !defined(WIN64)
+	#include <pthread.h>
+#endif
+
+/*!
+ * \brief Buffered writer for the body of a spike file
+ *
+ * Spikes are encoded into blocks of a fixed size in memory. Every full block is handed to a background thread, which
+ * writes it to disk while the simulation continues to fill the next block, so that runNetwork does not have to wait
+ * for the disk. Only a fixed number of blocks exists; if the disk cannot keep up, pushSpike waits for the next free
+ * block.
+ *
+ * The body is written in one of two formats (see spikeFileFormat_t):
+ * - SPK_FILE_AER: every spike is a pair of int32 (time, neuron ID), as in spike file version 0.2.
+ * - SPK_FILE_COMPACT: the body is a sequence of blocks, each starting with two int32 (number of spikes, number of
+ *   bytes that follow). For every spike, the block holds the difference to the time of the previous spike in the
+ *   block (zig-zag encoded) followed by the neuron ID, both as variable-length integers (7 bits per byte, least
+ *   significant group first, high bit set on all but the last byte). The first spike in a block is relative to 0.
+ *
+ * The header section of the file is not written by this class (see SpikeMonitorCore::writeSpikeFileHeader).
+ * On Windows, blocks are currently written by the calling thread.
+ */
+class SpikeFileWriter {
+public:
+	//! creates a writer for an open file, blockSize (in bytes) must hold at least one spike
+	SpikeFileWriter(FILE* fileId, spikeFileFormat_t format, int blockSize);
+
+	//! writes all remaining spikes to disk and stops the background thread (the file is not closed)
+	~SpikeFileWriter();
+
+	//! appends a spike to the current block, hands the block to the background thread if it is full
+	void pushSpike(int time, int neurId) {
+		if (blockSize_ - blockPos_ < MAX_BYTES_PER_SPIKE)
+			submitBlock();
+
+		if (format_ == SPK_FILE_AER) {
+			int aer[2] = {time, neurId};
+			memcpy(block_ + blockPos_, aer, sizeof(aer));
+			blockPos_ += sizeof(aer);
+		} else {
+			int delta = time - lastTime_;
+			blockPos_ += encodeVarint((unsigned char*)block_ + blockPos_, zigZagEncode(delta)); // negative deltas stay short
+			blockPos_ += encodeVarint((unsigned char*)block_ + blockPos_, (uint32_t)neurId);
+			lastTime_ = time;
+		}
+		blockNumSpikes_++;
+	}
+
+	//! writes all spikes pushed so far to disk and flushes the file
+	void flush();
+
+	//! returns true if any write to the file has failed
+	bool hasError();
+
+private:
+	static const int MAX_BYTES_PER_SPIKE = 2*MAX_VARINT_BYTES;	//!< two int32 in AER, or two varints
+	static const int BLOCK_HEADER_SIZE = 8;		//!< number of spikes and number of bytes (SPK_FILE_COMPACT only)
+	static const int NUM_BLOCKS = 4;			//!< number of blocks that can be filled or in flight at a time
+
+	struct fullBlock_t {
+		char* data;
+		size_t numBytes;
+	};
+
+	//! hands the current block to the background thread and starts a new one
+	void submitBlock();
+
+	//! starts a new block in block_
+	void resetBlock();
+
+	//! writes a block to file, records any error
+	void writeBlock(const fullBlock_t& block);
+
+	//! main loop of the background thread: writes full blocks until shut down
+	static void* writerLoop(void* arg);
+
+	FILE* fileId_;
+	spikeFileFormat_t format_;
+	int blockSize_;
+
+	char* block_;			//!< block that is currently being filled
+	int blockPos_;			//!< number of bytes used in block_
+	int blockNumSpikes_;	//!< number of spikes in block_
+	int lastTime_;			//!< time of the last spike in block_ (SPK_FILE_COMPACT only)
+
+	std::vector<char*> freeBlocks_;		//!< blocks that can be filled next
+	std::deque<fullBlock_t> fullBlocks_;	//!< blocks waiting to be written, oldest first
+	bool writeError_;
+
+#if !defined(WIN32) && !defined(WIN64)
+	pthread_t thread_;
+	pthread_mutex_t mutex_;
+	pthread_cond_t workCond_;		//!< signaled when a full block is available (or on shutdown)
+	pthread_cond_t doneCond_;		//!< signaled when the background thread has written a block
+	bool busy_;						//!< whether the background thread is currently writing a block
+	bool shutdown_;
+#endif
+};
+
+#endif
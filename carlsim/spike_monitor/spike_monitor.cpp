@@ -2,6 +2,7 @@
 
 #include <spike_monitor_core.h>	// SpikeMonitor private implementation
 #include <user_errors.h>		// fancy user error messages
+#include <snn_definitions.h>	// SPIKE_FILE_BLOCK_SIZE
 
 #include <sstream>				// std::stringstream
 #include <algorithm>			// std::transform
@@ -44,11 +45,7 @@ int SpikeMonitor::getPopNumSpikes() {
 	std::string funcName = "getPopNumSpikes()";
 	UserErrors::assertTrue(!isRecording(), UserErrors::CANNOT_BE_ON, funcName, "Recording");
 
-	// \TODO
-	UserErrors::assertTrue(getMode()==AER, UserErrors::UNKNOWN, funcName, "",
-		"This function is not yet supported in this mode.");
-
-	return spikeMonitorCorePtr_->getPopNumSpikes();	
+	return spikeMonitorCorePtr_->getPopNumSpikes();
 }
 
 float SpikeMonitor::getMaxFiringRate(){
@@ -84,10 +81,6 @@ int SpikeMonitor::getNeuronNumSpikes(int neurId) {
 	std::string funcName = "getNeuronNumSpikes()";
 	UserErrors::assertTrue(!isRecording(), UserErrors::CANNOT_BE_ON, funcName, "Recording");
 
-	// \TODO
-	UserErrors::assertTrue(getMode()==AER, UserErrors::UNKNOWN, funcName, "",
-		"This function is not yet supported in this mode.");
-
 	return spikeMonitorCorePtr_->getNeuronNumSpikes(neurId);
 }
 
@@ -205,9 +198,8 @@ spikeMonMode_t SpikeMonitor::getMode() {
 }
 
 void SpikeMonitor::setMode(spikeMonMode_t mode) {
-	// \TODO
-	UserErrors::assertTrue(false, UserErrors::UNKNOWN, "setMode()", "",
-		"This function call is not yet supported.");
+	std::string funcName = "setMode()";
+	UserErrors::assertTrue(!isRecording(), UserErrors::CANNOT_BE_ON, funcName, "Recording");
 
 	spikeMonitorCorePtr_->setMode(mode);
 }
@@ -233,4 +225,58 @@ void SpikeMonitor::setLogFile(const std::string& fileName) {
 
 	// tell new file id to core object
 	spikeMonitorCorePtr_->setSpikeFileId(fid);
+}
+
+void SpikeMonitor::setFileFormat(spikeFileFormat_t format, int blockSize) {
+	std::string funcName = "setFileFormat()";
+	UserErrors::assertTrue(!spikeMonitorCorePtr_->isFileFormatFixed(), UserErrors::CANNOT_BE_CALLED_IN_STATE,
+		funcName, funcName, "\"spikes written to file\" (call setLogFile first)");
+	UserErrors::assertTrue(blockSize==-1 || blockSize>=64, UserErrors::MUST_BE_SET_TO, funcName, "blockSize",
+		"-1 or a value >= 64");
+
+	if (blockSize==-1)
+		blockSize = SPIKE_FILE_BLOCK_SIZE;
+
+	spikeMonitorCorePtr_->setFileFormat(format, blockSize);
+}
+
+spikeFileFormat_t SpikeMonitor::getFileFormat() {
+	return spikeMonitorCorePtr_->getFileFormat();
+}
+
+void SpikeMonitor::setWindow(int numBins, int binSizeMs) {
+	std::string funcName = "setWindow()";
+	UserErrors::assertTrue(numBins>0, UserErrors::MUST_BE_POSITIVE, funcName, "numBins");
+	UserErrors::assertTrue(binSizeMs>0, UserErrors::MUST_BE_POSITIVE, funcName, "binSizeMs");
+	UserErrors::assertTrue(getMode()==WINDOW || !isRecording(), UserErrors::CANNOT_BE_ON, funcName, "Recording");
+
+	spikeMonitorCorePtr_->setWindow(numBins, binSizeMs);
+}
+
+std::vector<float> SpikeMonitor::getWindowFiringRates() {
+	std::string funcName = "getWindowFiringRates()";
+	UserErrors::assertTrue(getMode()==WINDOW, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName, "WINDOW");
+
+	return spikeMonitorCorePtr_->getWindowFiringRates();
+}
+
+float SpikeMonitor::getWindowPopMeanFiringRate() {
+	std::string funcName = "getWindowPopMeanFiringRate()";
+	UserErrors::assertTrue(getMode()==WINDOW, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName, "WINDOW");
+
+	return spikeMonitorCorePtr_->getWindowPopMeanFiringRate();
+}
+
+std::vector<float> SpikeMonitor::getWindowPSTH() {
+	std::string funcName = "getWindowPSTH()";
+	UserErrors::assertTrue(getMode()==WINDOW, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName, "WINDOW");
+
+	return spikeMonitorCorePtr_->getWindowPSTH();
+}
+
+float SpikeMonitor::getWindowSynchrony() {
+	std::string funcName = "getWindowSynchrony()";
+	UserErrors::assertTrue(getMode()==WINDOW, UserErrors::CAN_ONLY_BE_CALLED_IN_MODE, funcName, funcName, "WINDOW");
+
+	return spikeMonitorCorePtr_->getWindowSynchrony();
 }
\ No newline at end of file
@@ -58,7 +58,7 @@ class SpikeMonitorCore; // forward declaration of implementation
  * the method CARLsim::setSpikeMonitor must be called with the group ID of the desired group as an
  * argument. The setSpikeMonitor call returns a pointer to a SpikeMonitor object which can be queried for spike data.
  *
- * There are two different modes that define what information is collected exactly.
+ * There are three different modes that define what information is collected exactly.
  * - AER:   AER mode will collect the exact spike times of all neurons in the group and store them in a 2D spike
  *          spike vector. The first dimension of the vector is neuron id, the second dimension is spike times. Each
  *          element spkVector[i] is thus a vector of all spike times for the i-th neuron in the group.
@@ -68,6 +68,10 @@ class SpikeMonitorCore; // forward declaration of implementation
  * - COUNT:	SpikeCount mode will only collect spike count information, such as the number of spikes per neuron. This
  *          mode cannot retrieve exact spike times. Thus it is not possible to calculate some of the more elaborate
  *          metrics, such as spike-time correlations.
+ * - WINDOW: SpikeWindow mode collects the same information as COUNT mode. In addition, it keeps the spike count of
+ *          every neuron in a rolling window of the last few time bins (see setWindow), independent of
+ *          startRecording / stopRecording. The window needs a fixed amount of memory, and can be queried at any time
+ *          for firing rates, a population PSTH, and a synchrony measure (see getWindowFiringRates etc.).
  *
  * Spike data will not be recorded until the SpikeMonitor member function startRecording() is called.
  * Before any metrics can be computed, the user must call stopRecording(). In general, a new recording period
@@ -432,18 +436,25 @@ class SpikeMonitor {
 	 *          neuron, and is thus not capable of computing spike train correlation etc.
 	 * AER:     Will collect spike information in AER format (will collect both neuron IDs and
 	 *          spike times).
+	 * WINDOW:  Will collect spike count information, and keep spike counts in a rolling window of
+	 *          time bins (see setWindow).
 	 */
 	spikeMonMode_t getMode();
 
 	/*!
 	 * \brief Sets the current SpikeMonitor mode
 	 *
-	 * This function returns the current SpikeMonitor mode.
+	 * This function sets the current SpikeMonitor mode.
 	 * COUNT:	Will collect only spike count information (such as number of spikes per neuron),
 	 *          not the explicit spike times. COUNT mode cannot retrieve exact spike times per
 	 *          neuron, and is thus not capable of computing spike train correlation etc.
+	 *          All firing rate metrics are available, and no memory is needed per spike.
 	 * AER:     Will collect spike information in AER format (will collect both neuron IDs and
 	 *          spike times).
+	 * WINDOW:  Will collect spike count information like COUNT, and keep spike counts in a rolling window of
+	 *          time bins (10 bins of 100 ms by default, see setWindow).
+	 * The function must be called outside of startRecording / stopRecording periods. Changing the mode discards all
+	 * data recorded so far (as if SpikeMonitor::clear was called). The spike file is not affected by the mode.
 	 */
 	void setMode(spikeMonMode_t mode=AER);
 
@@ -465,6 +476,93 @@ class SpikeMonitor {
 	 */
 	void setLogFile(const std::string& logFileName);
 
+	/*!
+	 * \brief Sets the format of the spike file binary
+	 *
+	 * This function sets the format in which spikes are written to the spike file (see spikeFileFormat_t).
+	 * SPK_FILE_AER (default) writes every spike as two int32 (spike file version 0.2), SPK_FILE_COMPACT writes
+	 * delta-encoded spike times and neuron IDs as variable-length integers (spike file version 0.3), which is
+	 * typically 2-4x smaller. Both formats can be read by SpikeReader and SpikeGeneratorFromFile.
+	 * Spikes are collected in blocks of blockSize bytes, which are written to disk by a background thread.
+	 * The function must be called before the first spike is written to the current spike file, that is, right after
+	 * CARLsim::setSpikeMonitor or SpikeMonitor::setLogFile and before the next call to CARLsim::runNetwork.
+	 * The format is kept for all subsequent files set with setLogFile.
+	 *
+	 * \param[in] format    the spike file format
+	 * \param[in] blockSize the size of the blocks in which spikes are written to disk (bytes). Set to -1 to use
+	 *                      the default size (1 MB).
+	 * \since v3.1
+	 */
+	void setFileFormat(spikeFileFormat_t format, int blockSize=-1);
+
+	/*!
+	 * \brief Returns the format of the spike file binary
+	 *
+	 * This function returns the format in which spikes are written to the spike file (see setFileFormat).
+	 * \since v3.1
+	 */
+	spikeFileFormat_t getFileFormat();
+
+	/*!
+	 * \brief Sets the rolling window and switches to WINDOW mode
+	 *
+	 * This function sets up a rolling window of numBins time bins of binSizeMs ms each, and switches the
+	 * SpikeMonitor to WINDOW mode (see setMode). From now on, the spike count of every neuron is kept for the last
+	 * numBins completed bins. The bin that is currently in progress is not part of the window. Older bins are
+	 * discarded, so that the memory needed is constant (numBins+1 counts per neuron) no matter how long the
+	 * simulation runs. Bins are aligned to the time at which the window was set.
+	 * The window is independent of startRecording / stopRecording and can be queried at any time with
+	 * getWindowFiringRates, getWindowPopMeanFiringRate, getWindowPSTH, and getWindowSynchrony.
+	 * If the SpikeMonitor is already in WINDOW mode, the window is restarted with the new size, which is allowed
+	 * during recording. Otherwise, the function must be called outside of startRecording / stopRecording periods.
+	 *
+	 * \param[in] numBins   number of bins in the window
+	 * \param[in] binSizeMs size of a bin (ms)
+	 * \since v3.1
+	 */
+	void setWindow(int numBins, int binSizeMs);
+
+	/*!
+	 * \brief Returns the firing rate of every neuron over the rolling window
+	 *
+	 * This function returns the firing rate (Hz) of every neuron in the group over the completed bins of the rolling
+	 * window (see setWindow). It can be called at any time in WINDOW mode, also during recording.
+	 * If no bin has been completed yet, all rates are zero.
+	 * \since v3.1
+	 */
+	std::vector<float> getWindowFiringRates();
+
+	/*!
+	 * \brief Returns the mean firing rate of the group over the rolling window
+	 *
+	 * This function returns the mean firing rate (Hz) of all neurons in the group over the completed bins of the
+	 * rolling window (see setWindow). It can be called at any time in WINDOW mode, also during recording.
+	 * \since v3.1
+	 */
+	float getWindowPopMeanFiringRate();
+
+	/*!
+	 * \brief Returns the population PSTH of the rolling window
+	 *
+	 * This function returns the mean firing rate (Hz) of all neurons in the group in each bin of the rolling window
+	 * (see setWindow), oldest bin first. The vector always has numBins elements; bins that have not been completed
+	 * yet are zero. It can be called at any time in WINDOW mode, also during recording.
+	 * \since v3.1
+	 */
+	std::vector<float> getWindowPSTH();
+
+	/*!
+	 * \brief Returns the synchrony of the group over the rolling window
+	 *
+	 * This function returns the synchrony measure chi (Golomb & Hansel, 2000) over the bins of the rolling window
+	 * (see setWindow): the variance of the population PSTH divided by the mean variance of the spike counts of
+	 * single neurons, square-rooted. Chi is close to 0 for asynchronous firing, and 1 for fully synchronous firing.
+	 * At least two bins must be completed, otherwise zero is returned. It can be called at any time in WINDOW mode,
+	 * also during recording.
+	 * \since v3.1
+	 */
+	float getWindowSynchrony();
+
  private:
   //! This is a pointer to the actual implementation of the class. The user should never directly instantiate it.
   SpikeMonitorCore* spikeMonitorCorePtr_;
@@ -1,9 +1,12 @@
 #include <spike_monitor_core.h>
+#include <spike_file_writer.h>
+#include <spike_store.h>
+#include <spike_rate_window.h>
 
 #include <snn.h>				// CARLsim private implementation
 #include <snn_definitions.h>	// KERNEL_ERROR, KERNEL_INFO, ...
 
-#include <algorithm>			// std::sort
+#include <algorithm>			// std::sort, std::lower_bound, std::upper_bound
 #include <string.h> 			// string, strcpy
 
 
@@ -13,6 +16,11 @@ SpikeMonitorCore::SpikeMonitorCore(CpuSNN* snn, int monitorId, int grpId) {
 	grpId_= grpId;
 	monitorId_ = monitorId;
 	nNeurons_ = -1;
+	spkStore_ = NULL;
+	popNumSpikes_ = 0;
+	spkWindow_ = NULL;
+	windowNumBins_ = 10;
+	windowBinSizeMs_ = 100;
 	spikeFileId_ = NULL;
 	recordSet_ = false;
 	spkMonLastUpdated_ = 0;
@@ -23,6 +31,9 @@ SpikeMonitorCore::SpikeMonitorCore(CpuSNN* snn, int monitorId, int grpId) {
 	needToWriteFileHeader_ = true;
 	spikeFileSignature_ = 206661989;
 	spikeFileVersion_ = 0.2f;
+	spikeFileFormat_ = SPK_FILE_AER;
+	spikeFileBlockSize_ = SPIKE_FILE_BLOCK_SIZE;
+	spikeFileWriter_ = NULL;
 
 	// defer all unsafe operations to init function
 	init();
@@ -32,10 +43,9 @@ void SpikeMonitorCore::init() {
 	nNeurons_ = snn_->getGroupNumNeurons(grpId_);
 	assert(nNeurons_>0);
 
-	// spike vector will be a 2D structure that holds a list of spike times for each neuron in the group
-	// so the first dimension is neuron ID, and each spkVector_[i] holds the list of spike times of that neuron
-	// fix the first dimension of spike vector
-	spkVector_.resize(nNeurons_);
+	// all spikes go to a single append-only store, which can be turned into a 2D structure (first dimension is neuron
+	// ID, second dimension is the list of spike times of that neuron) whenever this is queried
+	spkStore_ = new SpikeStore(nNeurons_);
 
 	clear();
 
@@ -47,10 +57,13 @@ void SpikeMonitorCore::init() {
 }
 
 SpikeMonitorCore::~SpikeMonitorCore() {
-	if (spikeFileId_!=NULL) {
-		fclose(spikeFileId_);
-		spikeFileId_ = NULL;
-	}
+	closeSpikeFile();
+
+	delete spkStore_;
+	spkStore_ = NULL;
+
+	delete spkWindow_;
+	spkWindow_ = NULL;
 }
 
 // +++++ PUBLIC METHODS: +++++++++++++++++++++++++++++++++++++++++++++++//
@@ -65,8 +78,9 @@ void SpikeMonitorCore::clear() {
 	accumTime_ = 0;
 	totalTime_ = -1;
 
-	for (int i=0; i<nNeurons_; i++)
-		spkVector_[i].clear();
+	spkStore_->clear();
+	spkCount_.assign(nNeurons_,0);
+	popNumSpikes_ = 0;
 
 	needToCalculateFiringRates_ = true;
 	needToSortFiringRates_ = true;
@@ -91,26 +105,16 @@ float SpikeMonitorCore::getPopStdFiringRate() {
 	if (totalTime_==0)
 		return 0.0f;
 
-	float meanRate = getPopMeanFiringRate();
-	std::vector<float> rates = getAllFiringRates();
-	float std = 0.0f;
-	if (nNeurons_>1) {
-		for (int i=0; i<nNeurons_; i++)
-			std += (rates[i]-meanRate)*(rates[i]-meanRate);
-		std = sqrt(std/(nNeurons_-1));
-	}
+	// if necessary, get data structures up-to-date
+	calculateFiringRates();
 
-	return std;
+	return popStdFiringRate_;
 }
 
 int SpikeMonitorCore::getPopNumSpikes() {
 	assert(!isRecording());
 
-	int nSpk = 0;
-	for (int i=0; i<nNeurons_; i++)
-		nSpk += getNeuronNumSpikes(i);
-
-	return nSpk;
+	return (int)popNumSpikes_;
 }
 
 std::vector<float> SpikeMonitorCore::getAllFiringRates() {
@@ -125,17 +129,19 @@ std::vector<float> SpikeMonitorCore::getAllFiringRates() {
 float SpikeMonitorCore::getMaxFiringRate() {
 	assert(!isRecording());
 
-	std::vector<float> rates = getAllFiringRatesSorted();
+	// if necessary, get data structures up-to-date
+	calculateFiringRates();
 
-	return rates.back();
+	return maxFiringRate_;
 }
 
 float SpikeMonitorCore::getMinFiringRate(){
 	assert(!isRecording());
 
-	std::vector<float> rates = getAllFiringRatesSorted();
+	// if necessary, get data structures up-to-date
+	calculateFiringRates();
 
-	return rates.front();
+	return minFiringRate_;
 }
 
 float SpikeMonitorCore::getNeuronMeanFiringRate(int neurId) {
@@ -148,9 +154,8 @@ float SpikeMonitorCore::getNeuronMeanFiringRate(int neurId) {
 int SpikeMonitorCore::getNeuronNumSpikes(int neurId) {
 	assert(!isRecording());
 	assert(neurId>=0 && neurId<nNeurons_);
-	assert(getMode()==AER);
 
-	return spkVector_[neurId].size();
+	return spkCount_[neurId];
 }
 
 std::vector<float> SpikeMonitorCore::getAllFiringRatesSorted() {
@@ -170,15 +175,11 @@ int SpikeMonitorCore::getNumNeuronsWithFiringRate(float min, float max){
 	// if necessary, get data structures up-to-date
 	sortFiringRates();
 
-	int counter = 0;
-	std::vector<float>::const_iterator it_begin = firingRatesSorted_.begin();
-	std::vector<float>::const_iterator it_end = firingRatesSorted_.end();
-	for(std::vector<float>::const_iterator it=it_begin; it!=it_end; it++){
-		if((*it) >= min && (*it) <= max)
-			counter++;
-	}
+	// the rates in [min,max] form a contiguous range of the sorted rates
+	std::vector<float>::iterator itMin = std::lower_bound(firingRatesSorted_.begin(), firingRatesSorted_.end(), min);
+	std::vector<float>::iterator itMax = std::upper_bound(itMin, firingRatesSorted_.end(), max);
 
-	return counter;
+	return (int)(itMax - itMin);
 }
 
 int SpikeMonitorCore::getNumSilentNeurons() {
@@ -204,7 +205,7 @@ std::vector<std::vector<int> > SpikeMonitorCore::getSpikeVector2D(){
 	assert(!isRecording());
 	assert(mode_==AER);
 
-	return spkVector_;
+	return spkStore_->getSpikeVector2D();
 }
 
 void SpikeMonitorCore::print(bool printSpikeTimes) {
@@ -234,13 +235,14 @@ void SpikeMonitorCore::print(bool printSpikeTimes) {
 #else
 			snprintf(buffer, 200, "| %7d | % 9.2f | ", i, getNeuronMeanFiringRate(i));
 #endif
-			int nSpk = spkVector_[i].size();
+			int nSpk;
+			const int* spkTimes = spkStore_->getNeuronSpikeTimes(i, nSpk);
 			for (int j=0; j<nSpk; j++) {
 				char times[10];
 #if defined(WIN32) || defined(WIN64)
-				_snprintf(times, 10, "%8d", spkVector_[i][j]);
+				_snprintf(times, 10, "%8d", spkTimes[j]);
 #else
-				snprintf(times, 10, "%8d", spkVector_[i][j]);
+				snprintf(times, 10, "%8d", spkTimes[j]);
 #endif
 				strcat(buffer, times);
 				if (j%dispSpkTimPerRow == dispSpkTimPerRow-1 && j<nSpk-1) {
@@ -254,10 +256,79 @@ void SpikeMonitorCore::print(bool printSpikeTimes) {
 }
 
 void SpikeMonitorCore::pushAER(int time, int neurId) {
-	assert(isRecording());
-	assert(getMode()==AER);
+	assert(needsSpikes());
+
+	if (spkWindow_!=NULL)
+		spkWindow_->push(time, neurId);
+
+	// spike counts are kept in all modes, spike times only in AER mode
+	if (recordSet_) {
+		spkCount_[neurId]++;
+		popNumSpikes_++;
+		if (mode_==AER)
+			spkStore_->push(time, neurId);
+	}
+}
+
+void SpikeMonitorCore::setMode(spikeMonMode_t mode) {
+	assert(!isRecording());
+	if (mode==mode_)
+		return;
+
+	// spike counts and spike times would no longer match
+	mode_ = mode;
+	clear();
+	resetWindow();
+}
+
+void SpikeMonitorCore::setWindow(int numBins, int binSizeMs) {
+	assert(numBins>0 && binSizeMs>0);
+	windowNumBins_ = numBins;
+	windowBinSizeMs_ = binSizeMs;
+
+	// changing the window only affects the window, so this is allowed while recording
+	if (mode_==WINDOW)
+		resetWindow();
+	else
+		setMode(WINDOW);
+}
+
+std::vector<float> SpikeMonitorCore::getWindowFiringRates() {
+	updateWindow();
+	return spkWindow_->getFiringRates();
+}
+
+float SpikeMonitorCore::getWindowPopMeanFiringRate() {
+	updateWindow();
+	return spkWindow_->getPopMeanFiringRate();
+}
+
+std::vector<float> SpikeMonitorCore::getWindowPSTH() {
+	updateWindow();
+	return spkWindow_->getPSTH();
+}
 
-	spkVector_[neurId].push_back(time);
+float SpikeMonitorCore::getWindowSynchrony() {
+	updateWindow();
+	return spkWindow_->getSynchrony();
+}
+
+void SpikeMonitorCore::resetWindow() {
+	// spikes up to now go to the old window (if any); the new window starts now
+	snn_->updateSpikeMonitor(grpId_);
+	delete spkWindow_;
+	spkWindow_ = NULL;
+
+	if (mode_==WINDOW)
+		spkWindow_ = new SpikeRateWindow(nNeurons_, windowNumBins_, windowBinSizeMs_, snn_->getSimTime());
+}
+
+void SpikeMonitorCore::updateWindow() {
+	assert(mode_==WINDOW && spkWindow_!=NULL);
+
+	// make sure all spikes up to now are in the window, and complete all bins that are over
+	snn_->updateSpikeMonitor(grpId_);
+	spkWindow_->advanceTo(snn_->getSimTime());
 }
 
 void SpikeMonitorCore::startRecording() {
@@ -313,21 +384,55 @@ void SpikeMonitorCore::setSpikeFileId(FILE* spikeFileId) {
 	assert(!isRecording());
 
 	// close previous file pointer if exists
-	if (spikeFileId_!=NULL) {
-		fclose(spikeFileId_);
-		spikeFileId_ = NULL;
-	}
+	closeSpikeFile();
 
 	// set it to new file id
 	spikeFileId_=spikeFileId;
 
-	if (spikeFileId_==NULL)
-		needToWriteFileHeader_ = false;
-	else {
-		// file pointer has changed, so we need to write header (again)
-		needToWriteFileHeader_ = true;
+	// file pointer has changed, so we need to write header (again)
+	// the header is written together with the first spike, so that the file format can still be changed until then
+	needToWriteFileHeader_ = spikeFileId_!=NULL;
+}
+
+SpikeFileWriter* SpikeMonitorCore::getSpikeFileWriter() {
+	if (spikeFileWriter_==NULL && spikeFileId_!=NULL) {
 		writeSpikeFileHeader();
+		spikeFileWriter_ = new SpikeFileWriter(spikeFileId_, spikeFileFormat_, spikeFileBlockSize_);
 	}
+
+	return spikeFileWriter_;
+}
+
+void SpikeMonitorCore::flushSpikeFile() {
+	SpikeFileWriter* writer = getSpikeFileWriter();
+	if (writer==NULL)
+		return;
+
+	writer->flush();
+	if (writer->hasError())
+		KERNEL_ERROR("SpikeMonitorCore: flushSpikeFile has fwrite error");
+}
+
+void SpikeMonitorCore::setFileFormat(spikeFileFormat_t format, int blockSize) {
+	assert(!isFileFormatFixed());
+	assert(blockSize>0);
+
+	spikeFileFormat_ = format;
+	spikeFileBlockSize_ = blockSize;
+}
+
+// write all remaining spikes (and the header, in case there were no spikes at all), then close the file
+void SpikeMonitorCore::closeSpikeFile() {
+	if (spikeFileId_==NULL)
+		return;
+
+	flushSpikeFile();
+	delete spikeFileWriter_;
+	spikeFileWriter_ = NULL;
+
+	fclose(spikeFileId_);
+	spikeFileId_ = NULL;
+	needToWriteFileHeader_ = false;
 }
 
 // calculate average firing rate for every neuron if we haven't done so already
@@ -336,11 +441,11 @@ void SpikeMonitorCore::calculateFiringRates() {
 	if (!needToCalculateFiringRates_)
 		return;
 
-	assert(getMode()==AER);
-
 	// clear, so we get the same answer every time.
 	firingRates_.assign(nNeurons_,0);
-	firingRatesSorted_.assign(nNeurons_,0);
+	popStdFiringRate_ = 0.0f;
+	maxFiringRate_ = 0.0f;
+	minFiringRate_ = 0.0f;
 
 	// this really shouldn't happen at this stage, but if recording time is zero, return all zeros
 	if (totalTime_==0) {
@@ -348,11 +453,19 @@ void SpikeMonitorCore::calculateFiringRates() {
 		return;
 	}
 
-	// compute firing rate
+	// compute firing rate from the spike counts, along with the summary statistics
 	assert(totalTime_>0); // avoid division by zero
+	float meanRate = popNumSpikes_*1000.0/(totalTime_*nNeurons_);
+	double sqDev = 0.0;
+	maxFiringRate_ = minFiringRate_ = spkCount_[0]*1000.0f/totalTime_;
 	for(int i=0;i<nNeurons_;i++) {
-		firingRates_[i]=spkVector_[i].size()*1000.0f/totalTime_;
+		firingRates_[i]=spkCount_[i]*1000.0f/totalTime_;
+		sqDev += (firingRates_[i]-meanRate)*(firingRates_[i]-meanRate);
+		maxFiringRate_ = (std::max)(maxFiringRate_, firingRates_[i]);
+		minFiringRate_ = (std::min)(minFiringRate_, firingRates_[i]);
 	}
+	if (nNeurons_>1)
+		popStdFiringRate_ = sqrt(sqDev/(nNeurons_-1));
 
 	needToCalculateFiringRates_ = false;
 }
@@ -366,7 +479,8 @@ void SpikeMonitorCore::sortFiringRates() {
 	// first make sure firing rate vector is up-to-date
 	calculateFiringRates();
 
-	firingRatesSorted_=firingRates_;
+	// copy into the existing buffer, so that repeated queries do not allocate
+	firingRatesSorted_.assign(firingRates_.begin(),firingRates_.end());
 	std::sort(firingRatesSorted_.begin(),firingRatesSorted_.end());
 
 	needToSortFiringRates_ = false;
@@ -382,8 +496,9 @@ void SpikeMonitorCore::writeSpikeFileHeader() {
 	if (!fwrite(&spikeFileSignature_,sizeof(int),1,spikeFileId_))
 		KERNEL_ERROR("SpikeMonitorCore: writeSpikeFileHeader has fwrite error");
 
-	// write version number
-	if (!fwrite(&spikeFileVersion_,sizeof(float),1,spikeFileId_))
+	// write version number: the compact format was introduced with version 0.3
+	float version = (spikeFileFormat_==SPK_FILE_COMPACT) ? 0.3f : spikeFileVersion_;
+	if (!fwrite(&version,sizeof(float),1,spikeFileId_))
 		KERNEL_ERROR("SpikeMonitorCore: writeSpikeFileHeader has fwrite error");
 
 	// write grid dimensions
@@ -404,15 +519,10 @@ void SpikeMonitorCore::writeSpikeFileHeader() {
 	needToWriteFileHeader_ = false;
 }
 
-// Iterate through 2D spike vector and approximate size in memory.
-// This is not exact, we are not counting the buffer overhead, only
-// the size each subvector is memory.
+// Size of the spike store in memory (allocated chunks, 4 bytes per spike).
+// Per-neuron views that are built on demand are not counted.
 int64_t SpikeMonitorCore::getBufferSize(){
-    int64_t bufferSize=0; // in bytes
-    for(int i=0; i<spkVector_.size();i++){
-        bufferSize+=spkVector_[i].size()*sizeof(int);
-    }
-    return bufferSize;
+    return spkStore_->getMemoryUsage();
 }
 
 // check if the spike vector is getting large. If it is, return true once until
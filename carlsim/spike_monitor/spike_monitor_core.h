@@ -48,6 +48,9 @@
 #include <vector>					// std::vector
 
 class CpuSNN; // forward declaration of CpuSNN class
+class SpikeFileWriter; // forward declaration of SpikeFileWriter class
+class SpikeStore; // forward declaration of SpikeStore class
+class SpikeRateWindow; // forward declaration of SpikeRateWindow class
 
 
 /*
@@ -147,11 +150,29 @@ public:
 	//! prints the AER vector in human-readable format
 	void print(bool printSpikeTimes);
 
-	//! inserts a (time,neurId) tupel into the 2D spike vector
+	//! inserts a (time,neurId) tupel into the 2D spike vector (if recording) and the rolling window (in WINDOW mode)
 	void pushAER(int time, int neurId);
 
-	//! sets recording mode
-	void setMode(spikeMonMode_t mode) { mode_ = mode; }
+	//! returns true if pushAER has to be called for every spike (while recording, or in WINDOW mode)
+	bool needsSpikes() { return recordSet_ || mode_==WINDOW; }
+
+	//! sets recording mode (discards all recorded data if the mode changes)
+	void setMode(spikeMonMode_t mode);
+
+	//! sets the rolling window (numBins bins of binSizeMs ms) and switches to WINDOW mode
+	void setWindow(int numBins, int binSizeMs);
+
+	//! returns the firing rate (Hz) of every neuron over the rolling window
+	std::vector<float> getWindowFiringRates();
+
+	//! returns the mean firing rate (Hz) of the group over the rolling window
+	float getWindowPopMeanFiringRate();
+
+	//! returns the mean firing rate (Hz) of the group per bin of the rolling window, oldest bin first
+	std::vector<float> getWindowPSTH();
+
+	//! returns the synchrony measure chi of the group over the bins of the rolling window
+	float getWindowSynchrony();
 
 	//! sets status of PersistentData mode
 	void setPersistentData(bool persistentData) { persistentData_ = persistentData; }
@@ -174,6 +195,21 @@ public:
 	//! sets pointer to spike file
 	void setSpikeFileId(FILE* spikeFileId);
 
+	//! returns the writer for the spike file (writes the file header first if necessary), or NULL if there is no file
+	SpikeFileWriter* getSpikeFileWriter();
+
+	//! writes all buffered spikes to the spike file
+	void flushSpikeFile();
+
+	//! returns the format of the spike file
+	spikeFileFormat_t getFileFormat() { return spikeFileFormat_; }
+
+	//! sets the format and block size of the spike file (only before spikes have been written to the current file)
+	void setFileFormat(spikeFileFormat_t format, int blockSize);
+
+	//! returns true if the current spike file has already been written to, so that its format can no longer change
+	bool isFileFormatFixed() { return spikeFileWriter_!=NULL; }
+
 	//! returns timestamp of last SpikeMonitor update
 	int64_t getLastUpdated() { return spkMonLastUpdated_; }
 
@@ -183,7 +219,7 @@ public:
     //! returns true if spike buffer is close to maxAllowedBufferSize
     bool isBufferBig();
 
-    //! returns the approximate size of the spike vector in bytes
+    //! returns the size of the spike store in bytes
     int64_t getBufferSize();
 
     //! returns the total accumulated time
@@ -193,12 +229,21 @@ private:
 	//! initialization method
 	void init();
 
-	//! reads AER vector and updates firing rate member var
+	//! reads spike counts and updates firing rate member vars (including summary statistics)
 	void calculateFiringRates();
 
 	//! reads AER vector and updates sorted firing rate member var
 	void sortFiringRates();
 
+	//! writes all buffered spikes to the spike file and closes it
+	void closeSpikeFile();
+
+	//! discards the rolling window and, in WINDOW mode, starts a new one at the current time
+	void resetWindow();
+
+	//! fetches all spikes up to the current time and moves the rolling window forward
+	void updateWindow();
+
 	//! writes the header section (file signature, version number) of a spike file
 	void writeSpikeFileHeader();
 
@@ -219,12 +264,26 @@ private:
 	FILE* spikeFileId_;	//!< file pointer to the spike file or NULL
 	int spikeFileSignature_; //!< int signature of spike file
 	float spikeFileVersion_; //!< version number of spike file
+	spikeFileFormat_t spikeFileFormat_; //!< format of the body of the spike file
+	int spikeFileBlockSize_; //!< size of the blocks in which the spike file is written (bytes)
+	SpikeFileWriter* spikeFileWriter_; //!< buffered writer for the spike file, created with the first spike
+
+	//! Used to analyzed the spike information: all recorded spikes in AER order, per-neuron views are built on demand
+	SpikeStore* spkStore_;
+
+	//! number of recorded spikes per neuron (maintained in all modes)
+	std::vector<int> spkCount_;
+	int64_t popNumSpikes_; //!< total number of recorded spikes
 
-	//! Used to analyzed the spike information
-	std::vector<std::vector<int> > spkVector_;
+	SpikeRateWindow* spkWindow_; //!< rolling window of spike counts (WINDOW mode only)
+	int windowNumBins_;          //!< number of bins in the rolling window
+	int windowBinSizeMs_;        //!< size of a bin of the rolling window (ms)
 
 	std::vector<float> firingRates_;
 	std::vector<float> firingRatesSorted_;
+	float popStdFiringRate_; //!< standard deviation of firingRates_, computed along with firingRates_
+	float maxFiringRate_;    //!< largest entry of firingRates_
+	float minFiringRate_;    //!< smallest entry of firingRates_
 
 	bool recordSet_;			//!< flag that indicates whether we're currently recording
 	int64_t startTime_;	 	//!< time (ms) of first call to startRecording
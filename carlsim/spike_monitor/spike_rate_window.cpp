@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#include <spike_rate_window.h>
+
+#include <assert.h>				// assert
+#include <math.h>				// sqrt
+#include <algorithm>			// std::fill, std::min
+
+
+SpikeRateWindow::SpikeRateWindow(int numNeurons, int numBins, int binSizeMs, int64_t startTime) {
+	assert(numNeurons>0);
+	assert(numBins>0);
+	assert(binSizeMs>0);
+	assert(startTime>=0);
+
+	numNeurons_ = numNeurons;
+	numBins_ = numBins;
+	binSizeMs_ = binSizeMs;
+	startTime_ = startTime;
+	currBin_ = 0;
+
+	counts_.assign((numBins_+1)*numNeurons_, 0);
+	popCounts_.assign(numBins_+1, 0);
+	windowCounts_.assign(numNeurons_, 0);
+}
+
+int SpikeRateWindow::getNumBinsCompleted() {
+	return (int)(std::min)((int64_t)numBins_, currBin_);
+}
+
+std::vector<float> SpikeRateWindow::getFiringRates() {
+	std::vector<float> rates(numNeurons_, 0.0f);
+	int numBins = getNumBinsCompleted();
+	if (numBins==0)
+		return rates;
+
+	float scale = 1000.0f/(numBins*binSizeMs_);
+	for (int i=0; i<numNeurons_; i++)
+		rates[i] = windowCounts_[i]*scale;
+
+	return rates;
+}
+
+float SpikeRateWindow::getPopMeanFiringRate() {
+	int numBins = getNumBinsCompleted();
+	if (numBins==0)
+		return 0.0f;
+
+	int64_t numSpikes = 0;
+	for (int b=0; b<numBins; b++)
+		numSpikes += popCounts_[slot(currBin_-numBins+b)];
+
+	return numSpikes*1000.0f/((float)numBins*binSizeMs_*numNeurons_);
+}
+
+std::vector<float> SpikeRateWindow::getPSTH() {
+	// bins that were not observed yet are reported as zero
+	std::vector<float> psth(numBins_, 0.0f);
+	int numBins = getNumBinsCompleted();
+
+	float scale = 1000.0f/((float)binSizeMs_*numNeurons_);
+	for (int b=0; b<numBins; b++)
+		psth[numBins_-numBins+b] = popCounts_[slot(currBin_-numBins+b)]*scale;
+
+	return psth;
+}
+
+// chi^2 = Var_t(population mean count) / mean_i Var_t(count_i), where the variances are taken over the bins of the
+// window; chi is 1 for fully synchronized and close to 0 for asynchronous activity
+float SpikeRateWindow::getSynchrony() {
+	int numBins = getNumBinsCompleted();
+	if (numBins<2)
+		return 0.0f;
+
+	// variance of the population mean count
+	double popSum = 0.0, popSqSum = 0.0;
+	for (int b=0; b<numBins; b++) {
+		double popMean = popCounts_[slot(currBin_-numBins+b)]/(double)numNeurons_;
+		popSum += popMean;
+		popSqSum += popMean*popMean;
+	}
+	double popVar = popSqSum/numBins - (popSum/numBins)*(popSum/numBins);
+
+	// mean of the single-neuron variances
+	double neurVarSum = 0.0;
+	for (int i=0; i<numNeurons_; i++) {
+		double sqSum = 0.0;
+		for (int b=0; b<numBins; b++) {
+			double cnt = counts_[slot(currBin_-numBins+b)*numNeurons_ + i];
+			sqSum += cnt*cnt;
+		}
+		double mean = windowCounts_[i]/(double)numBins;
+		neurVarSum += sqSum/numBins - mean*mean;
+	}
+	if (neurVarSum<=0.0)
+		return 0.0f;
+
+	return (float)sqrt((std::max)(0.0, popVar/(neurVarSum/numNeurons_)));
+}
+
+void SpikeRateWindow::advance(int64_t bin) {
+	assert(bin>currBin_);
+
+	if (bin-currBin_ > numBins_) {
+		// all bins in the ring have expired
+		std::fill(counts_.begin(), counts_.end(), 0);
+		std::fill(popCounts_.begin(), popCounts_.end(), 0);
+		std::fill(windowCounts_.begin(), windowCounts_.end(), 0);
+		currBin_ = bin;
+		return;
+	}
+
+	while (currBin_ < bin) {
+		// the bin in progress is complete and enters the window
+		int* cntIn = &counts_[slot(currBin_)*numNeurons_];
+		for (int i=0; i<numNeurons_; i++)
+			windowCounts_[i] += cntIn[i];
+
+		// the oldest bin leaves the window, its slot is reused for the new bin in progress
+		currBin_++;
+		int* cntOut = &counts_[slot(currBin_)*numNeurons_];
+		if (currBin_-numBins_-1 >= 0) {
+			for (int i=0; i<numNeurons_; i++)
+				windowCounts_[i] -= cntOut[i];
+		}
+		std::fill(cntOut, cntOut+numNeurons_, 0);
+		popCounts_[slot(currBin_)] = 0;
+	}
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _SPIKE_RATE_WINDOW_H_
+#define _SPIKE_RATE_WINDOW_H_
+
+#include <stdint.h>					// int64_t
+#include <vector>					// std::vector
+
+/*!
+ * \brief Rolling window of per-neuron spike counts in time bins
+ *
+ * The window consists of the last numBins completed bins of binSizeMs ms each. The bin that is currently in progress
+ * is kept in the ring as well, but is not part of the window until it is completed. Bins are aligned to the start
+ * time of the window, and spikes before the start time are ignored. Memory is constant:
+ * (numBins+1) spike counts per neuron.
+ *
+ * Spikes may arrive out of order (e.g., the firing tables of different delays are read one after the other): a spike
+ * is added to its bin as long as the bin is still in the ring, and dropped otherwise.
+ */
+class SpikeRateWindow {
+public:
+	//! creates an empty window of numBins bins of binSizeMs ms each, starting at time startTime (ms)
+	SpikeRateWindow(int numNeurons, int numBins, int binSizeMs, int64_t startTime);
+
+	//! adds a spike (time in ms)
+	void push(int64_t time, int neurId) {
+		if (time < startTime_)
+			return; // before the window was started
+
+		int64_t bin = (time-startTime_)/binSizeMs_;
+		if (bin > currBin_)
+			advance(bin);
+		else if (bin <= currBin_-numBins_ - 1)
+			return; // too old
+
+		counts_[slot(bin)*numNeurons_ + neurId]++;
+		popCounts_[slot(bin)]++;
+		if (bin < currBin_)
+			windowCounts_[neurId]++; // bin is already part of the window
+	}
+
+	//! moves the window forward to time (ms): all bins before the bin of time are complete
+	void advanceTo(int64_t time) {
+		if (time >= startTime_ && (time-startTime_)/binSizeMs_ > currBin_)
+			advance((time-startTime_)/binSizeMs_);
+	}
+
+	//! returns the number of bins in the window
+	int getNumBins() { return numBins_; }
+
+	//! returns the size of a bin (ms)
+	int getBinSize() { return binSizeMs_; }
+
+	//! returns the number of completed bins currently in the window (at most numBins)
+	int getNumBinsCompleted();
+
+	//! returns the firing rate (Hz) of every neuron over the window
+	std::vector<float> getFiringRates();
+
+	//! returns the mean firing rate (Hz) of the population over the window
+	float getPopMeanFiringRate();
+
+	//! returns the mean firing rate (Hz) of the population per bin, oldest bin first
+	std::vector<float> getPSTH();
+
+	//! returns the synchrony measure chi (Golomb & Hansel) of the spike counts over the bins of the window
+	float getSynchrony();
+
+private:
+	//! completes all bins before bin, and starts bin
+	void advance(int64_t bin);
+
+	//! returns the ring slot of a bin
+	int slot(int64_t bin) { return (int)(bin % (numBins_+1)); }
+
+	int numNeurons_;
+	int numBins_;
+	int binSizeMs_;
+	int64_t startTime_;	//!< start time of bin 0 (ms)
+	int64_t currBin_;	//!< bin in progress (counted from startTime)
+
+	std::vector<int> counts_;		//!< spike counts per bin (numBins+1 slots) and neuron, slot-major
+	std::vector<int> popCounts_;	//!< spike counts of the population per slot
+	std::vector<int> windowCounts_;	//!< spike counts per neuron, summed over the completed bins of the window
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#include <spike_store.h>
+
+
+SpikeStore::SpikeStore(int numNeurons) {
+	assert(numNeurons>0 && numNeurons<=(int)ID_MASK+1);
+	numNeurons_ = numNeurons;
+	numSpikes_ = 0;
+	numChunksUsed_ = 0;
+	needToBuildIndex_ = true;
+}
+
+SpikeStore::~SpikeStore() {
+	for (unsigned int i=0; i<chunks_.size(); i++)
+		delete[] chunks_[i];
+}
+
+void SpikeStore::clear() {
+	numSpikes_ = 0;
+	numChunksUsed_ = 0;
+	blocks_.clear();
+
+	needToBuildIndex_ = true;
+	indexOffset_.clear();
+	indexTimes_.clear();
+}
+
+int SpikeStore::getNeuronNumSpikes(int neurId) {
+	assert(neurId>=0 && neurId<numNeurons_);
+	buildIndex();
+
+	return (int)(indexOffset_[neurId+1] - indexOffset_[neurId]);
+}
+
+const int* SpikeStore::getNeuronSpikeTimes(int neurId, int& numSpikes) {
+	numSpikes = getNeuronNumSpikes(neurId);
+	return numSpikes ? &indexTimes_[indexOffset_[neurId]] : NULL;
+}
+
+std::vector<std::vector<int> > SpikeStore::getSpikeVector2D() {
+	buildIndex();
+
+	std::vector<std::vector<int> > spkVector(numNeurons_);
+	for (int i=0; i<numNeurons_; i++)
+		spkVector[i].assign(indexTimes_.begin() + indexOffset_[i], indexTimes_.begin() + indexOffset_[i+1]);
+
+	return spkVector;
+}
+
+int64_t SpikeStore::getMemoryUsage() {
+	return (int64_t)chunks_.size()*CHUNK_SIZE*sizeof(uint32_t) + (int64_t)blocks_.capacity()*sizeof(block_t);
+}
+
+void SpikeStore::addChunk() {
+	if (numChunksUsed_==(int)chunks_.size())
+		chunks_.push_back(new uint32_t[CHUNK_SIZE]);
+	numChunksUsed_++;
+}
+
+// sorts all spikes by neuron ID (counting sort, stable), so that the spikes of every neuron can be accessed directly
+void SpikeStore::buildIndex() {
+	if (!needToBuildIndex_)
+		return;
+
+	// count the spikes per neuron
+	indexOffset_.assign(numNeurons_+1, 0);
+	for (int64_t s=0; s<numSpikes_; s++)
+		indexOffset_[(chunks_[s/CHUNK_SIZE][s%CHUNK_SIZE] & ID_MASK) + 1]++;
+	for (int i=0; i<numNeurons_; i++)
+		indexOffset_[i+1] += indexOffset_[i];
+
+	// scatter the spike times, block by block
+	indexTimes_.resize(numSpikes_);
+	std::vector<int64_t> pos(indexOffset_.begin(), indexOffset_.end()-1);
+	for (unsigned int b=0; b<blocks_.size(); b++) {
+		int64_t last = (b+1<blocks_.size()) ? blocks_[b+1].first : numSpikes_;
+		int baseTime = blocks_[b].timeSec*1000;
+		for (int64_t s=blocks_[b].first; s<last; s++) {
+			uint32_t spk = chunks_[s/CHUNK_SIZE][s%CHUNK_SIZE];
+			indexTimes_[pos[spk & ID_MASK]++] = baseTime + (int)(spk >> ID_BITS);
+		}
+	}
+
+	needToBuildIndex_ = false;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2014 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * *********************************************************************************************** *
+ * CARLsim
+ * created by: 		(MDR) Micah Richert, (JN) Jayram M. Nageswaran
+ * maintained by:	(MA) Mike Avery <averym@uci.edu>, (MB) Michael Beyeler <mbeyeler@uci.edu>,
+ *					(KDC) Kristofor Carlson <kdcarlso@uci.edu>
+ *					(TSC) Ting-Shuo Chou <tingshuc@uci.edu>
+ *
+ * CARLsim available from http://socsci.uci.edu/~jkrichma/CARLsim/
+ */
+
+#ifndef _SPIKE_STORE_H_
+#define _SPIKE_STORE_H_
+
+#include <stddef.h>					// NULL
+#include <stdint.h>					// uint32_t, int64_t
+#include <assert.h>					// assert
+#include <vector>					// std::vector
+
+/*!
+ * \brief Append-only store for the spikes recorded by a SpikeMonitor
+ *
+ * Spikes are appended in AER order to a single arena, which consists of fixed-size chunks that are kept (and reused)
+ * when the store is cleared, so that recording does not allocate memory in steady state.
+ * Spikes are organized in blocks of one second. Every spike is stored as a single 32-bit word, which holds its time
+ * relative to the start of its block (10 bits, 0-999 ms) and its neuron ID (22 bits), so a spike takes 4 bytes.
+ *
+ * Per-neuron views (number of spikes and spike times per neuron) are only built when they are queried, and are kept
+ * until the next spike is appended.
+ */
+class SpikeStore {
+public:
+	//! creates an empty store for neuron IDs in [0,numNeurons)
+	SpikeStore(int numNeurons);
+
+	//! deallocates all chunks
+	~SpikeStore();
+
+	//! appends a spike (time in ms)
+	void push(int time, int neurId) {
+		assert(time>=0);
+		assert(neurId>=0 && neurId<numNeurons_);
+
+		// start a new block at every new second
+		int timeSec = time/1000;
+		if (blocks_.empty() || blocks_.back().timeSec!=timeSec) {
+			block_t block = {timeSec, numSpikes_};
+			blocks_.push_back(block);
+		}
+
+		int chunk = (int)(numSpikes_/CHUNK_SIZE);
+		if (chunk==numChunksUsed_)
+			addChunk();
+		chunks_[chunk][numSpikes_%CHUNK_SIZE] = ((uint32_t)(time - timeSec*1000) << ID_BITS) | (uint32_t)neurId;
+		numSpikes_++;
+		needToBuildIndex_ = true;
+	}
+
+	//! removes all spikes (allocated chunks are kept for reuse)
+	void clear();
+
+	//! returns the total number of spikes
+	int64_t getNumSpikes() { return numSpikes_; }
+
+	//! returns the number of spikes of a specific neuron
+	int getNeuronNumSpikes(int neurId);
+
+	//! returns the spike times of all neurons (first dim=neuron ID, second dim=spike times in order of recording)
+	std::vector<std::vector<int> > getSpikeVector2D();
+
+	//! returns a pointer to the spike times of a specific neuron, stores their number in numSpikes
+	const int* getNeuronSpikeTimes(int neurId, int& numSpikes);
+
+	//! returns the number of bytes allocated to store spikes (excluding per-neuron views)
+	int64_t getMemoryUsage();
+
+private:
+	static const int CHUNK_SIZE = 16384;	//!< number of spikes per chunk
+	static const int ID_BITS = 22;			//!< number of bits for the neuron ID (see MAX_SPIKE_MON_GROUP_SIZE)
+	static const uint32_t ID_MASK = (1u << ID_BITS) - 1;
+
+	//! a block holds all spikes of one second, from entry first up to the first entry of the next block
+	struct block_t {
+		int timeSec;		//!< start of the block (in seconds)
+		int64_t first;		//!< index of the first spike of the block
+	};
+
+	//! makes a new chunk available (reuses or allocates one)
+	void addChunk();
+
+	//! builds per-neuron views (spike counts and spike times) if necessary
+	void buildIndex();
+
+	int numNeurons_;
+	int64_t numSpikes_;
+
+	std::vector<uint32_t*> chunks_;	//!< all allocated chunks, in use or not
+	int numChunksUsed_;				//!< number of chunks that currently hold spikes
+	std::vector<block_t> blocks_;
+
+	bool needToBuildIndex_;
+	std::vector<int64_t> indexOffset_;	//!< spikes of neuron i are in indexTimes_[indexOffset_[i], indexOffset_[i+1])
+	std::vector<int> indexTimes_;		//!< spike times sorted by neuron ID (and in order of recording per neuron)
+};
+
+#endif
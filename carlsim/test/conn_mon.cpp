@@ -418,3 +418,221 @@ TEST(ConnMon, weightChange) {
 		delete sim;
 	}
 }
+
+/*!
+ * \brief testing sparse connections
+ * This test makes sure that for a sparse connection the ConnectionMonitor reports NAN for non-existent synapses, that
+ * fan-in and fan-out add up to the number of synapses, and that the connect file contains (only) the weights of the
+ * existing synapses, in CSR layout.
+ */
+TEST(ConnMon, sparseSnapshot) {
+	const int GRP_SIZE_PRE = 100;
+	const int GRP_SIZE_POST = 50;
+
+	CARLsim* sim = new CARLsim("ConnMon.sparseSnapshot",CPU_MODE,SILENT,0,42);
+	int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE_PRE, EXCITATORY_NEURON);
+	int g1 = sim->createGroup("g1", GRP_SIZE_POST, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->connect(g0, g1, "random", RangeWeight(0.0f, 0.05f, 0.1f), 0.1f, RangeDelay(1), RadiusRF(-1), SYN_PLASTIC);
+	sim->setConductances(true);
+	sim->setupNetwork();
+
+	ConnectionMonitor* CM = sim->setConnectionMonitor(g0, g1, "results/weights.dat");
+	CM->setUpdateTimeIntervalSec(-1);
+	sim->scaleWeights(0, 0.5f);
+	sim->runNetwork(0,100);
+	std::vector< std::vector<float> > wt = CM->takeSnapshot();
+	int nSyn = CM->getNumSynapses();
+	EXPECT_GT(nSyn, 0);
+	EXPECT_LT(nSyn, GRP_SIZE_PRE*GRP_SIZE_POST);
+
+	int nExist = 0, nFanIn = 0, nFanOut = 0;
+	for (int i=0; i<GRP_SIZE_PRE; i++) {
+		nFanOut += CM->getFanOut(i);
+		for (int j=0; j<GRP_SIZE_POST; j++)
+			nExist += !isnan(wt[i][j]);
+	}
+	for (int j=0; j<GRP_SIZE_POST; j++)
+		nFanIn += CM->getFanIn(j);
+	EXPECT_EQ(nExist, nSyn);
+	EXPECT_EQ(nFanIn, nSyn);
+	EXPECT_EQ(nFanOut, nSyn);
+	EXPECT_EQ(CM->getNumWeightsWithValue(0.025f), nSyn);
+	delete sim;
+
+	// read the file: header, CSR structure, and a single snapshot
+	FILE* fp = fopen("results/weights.dat", "rb");
+	ASSERT_TRUE(fp!=NULL);
+	int sign, nSynFile, grpInfo[8];
+	float version, minMaxWt[2];
+	short int connId;
+	bool isPlastic;
+	EXPECT_EQ(fread(&sign, sizeof(int), 1, fp), 1);
+	EXPECT_EQ(fread(&version, sizeof(float), 1, fp), 1);
+	EXPECT_FLOAT_EQ(version, 0.4f);
+	EXPECT_EQ(fread(&connId, sizeof(short int), 1, fp), 1);
+	EXPECT_EQ(fread(grpInfo, sizeof(int), 8, fp), 8);
+	EXPECT_EQ(fread(&nSynFile, sizeof(int), 1, fp), 1);
+	EXPECT_EQ(nSynFile, nSyn);
+	EXPECT_EQ(fread(&isPlastic, sizeof(bool), 1, fp), 1);
+	EXPECT_EQ(fread(minMaxWt, sizeof(float), 2, fp), 2);
+
+	std::vector<int> synPtr(GRP_SIZE_POST+1), preIds(nSyn);
+	std::vector<float> wts(nSyn);
+	int64_t timeMs;
+	EXPECT_EQ(fread(&synPtr[0], sizeof(int), GRP_SIZE_POST+1, fp), GRP_SIZE_POST+1);
+	EXPECT_EQ(fread(&preIds[0], sizeof(int), nSyn, fp), nSyn);
+	EXPECT_EQ(fread(&timeMs, sizeof(int64_t), 1, fp), 1);
+	EXPECT_EQ(timeMs, 100);
+	EXPECT_EQ(fread(&wts[0], sizeof(float), nSyn, fp), nSyn);
+	EXPECT_EQ(fread(&timeMs, sizeof(int64_t), 1, fp), 0); // end of file
+	fclose(fp);
+
+	EXPECT_EQ(synPtr[0], 0);
+	EXPECT_EQ(synPtr[GRP_SIZE_POST], nSyn);
+	for (int j=0; j<GRP_SIZE_POST; j++) {
+		for (int s=synPtr[j]; s<synPtr[j+1]; s++) {
+			EXPECT_FLOAT_EQ(wts[s], wt[preIds[s]][j]);
+		}
+	}
+}
+
+/*!
+ * \brief testing the delta-encoded connect file format
+ * This test changes some weights between snapshots, and makes sure that decoding the delta-encoded connect file
+ * reproduces every snapshot (up to the weight resolution), that keyframes are written at the right interval, and that
+ * snapshots without keyframe only contain the synapses that changed.
+ */
+TEST(ConnMon, deltaFileFormat) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	const int GRP_SIZE_PRE = 100;
+	const int GRP_SIZE_POST = 50;
+	const int NUM_SNAPSHOTS = 8;
+	const int KEYFRAME_INTERVAL = 3;
+	const float WT_RES = 1e-4f;
+
+	CARLsim* sim = new CARLsim("ConnMon.deltaFileFormat",CPU_MODE,SILENT,0,42);
+	int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE_PRE, EXCITATORY_NEURON);
+	int g1 = sim->createGroup("g1", GRP_SIZE_POST, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	short int c0 = sim->connect(g0, g1, "random", RangeWeight(0.0f, 0.05f, 0.1f), 0.1f, RangeDelay(1), RadiusRF(-1),
+		SYN_PLASTIC);
+	sim->setConductances(true);
+	sim->setupNetwork();
+
+	ConnectionMonitor* CM = sim->setConnectionMonitor(g0, g1, "results/weights.dat");
+	EXPECT_EQ(CM->getFileFormat(), CONN_FILE_FULL);
+	EXPECT_DEATH(CM->setFileFormat(CONN_FILE_DELTA, 0),"");
+	EXPECT_DEATH(CM->setFileFormat(CONN_FILE_DELTA, 1, 0.0),"");
+	CM->setFileFormat(CONN_FILE_DELTA, KEYFRAME_INTERVAL, WT_RES);
+	EXPECT_EQ(CM->getFileFormat(), CONN_FILE_DELTA);
+	CM->setUpdateTimeIntervalSec(-1);
+	int nSyn = CM->getNumSynapses();
+
+	// the first snapshot is a keyframe, then every snapshot is compared to the one before
+	std::vector< std::vector< std::vector<float> > > wtSnapshots(1, CM->takeSnapshot());
+	std::vector<int> numChanged(1, nSyn);
+	for (int t=1; t<NUM_SNAPSHOTS; t++) {
+		if (t%2) {
+			// change all weights
+			sim->scaleWeights(c0, 0.9f);
+			numChanged.push_back(CM->getNumSynapses());
+		} else {
+			// change a few weights, one of them by less than the resolution
+			int nChanged = 0;
+			std::vector< std::vector<float> >& wt = wtSnapshots.back();
+			for (int i=0; i<GRP_SIZE_PRE && nChanged<5; i++) {
+				for (int j=0; j<GRP_SIZE_POST && nChanged<5; j++) {
+					if (!isnan(wt[i][j])) {
+						sim->setWeight(c0, i, j, wt[i][j] + (nChanged ? 0.001f*(t+1) : 0.1f*WT_RES));
+						nChanged++;
+					}
+				}
+			}
+			numChanged.push_back(nChanged-1);
+		}
+		sim->runNetwork(0,10);
+		wtSnapshots.push_back(CM->takeSnapshot());
+		EXPECT_TRUE(CM->getFileFormat()==CONN_FILE_DELTA);
+	}
+	EXPECT_DEATH(CM->setFileFormat(CONN_FILE_FULL),"");
+	delete sim;
+
+	// read the header
+	FILE* fp = fopen("results/weights.dat", "rb");
+	ASSERT_TRUE(fp!=NULL);
+	int sign, nSynFile, grpInfo[8], keyframeInterval;
+	float version, minMaxWt[2], wtRes;
+	short int connId;
+	bool isPlastic;
+	EXPECT_EQ(fread(&sign, sizeof(int), 1, fp), 1);
+	EXPECT_EQ(fread(&version, sizeof(float), 1, fp), 1);
+	EXPECT_FLOAT_EQ(version, 0.5f);
+	EXPECT_EQ(fread(&connId, sizeof(short int), 1, fp), 1);
+	EXPECT_EQ(fread(grpInfo, sizeof(int), 8, fp), 8);
+	EXPECT_EQ(fread(&nSynFile, sizeof(int), 1, fp), 1);
+	ASSERT_EQ(nSynFile, nSyn);
+	EXPECT_EQ(fread(&isPlastic, sizeof(bool), 1, fp), 1);
+	EXPECT_EQ(fread(minMaxWt, sizeof(float), 2, fp), 2);
+	std::vector<int> synPtr(GRP_SIZE_POST+1), preIds(nSyn);
+	EXPECT_EQ(fread(&synPtr[0], sizeof(int), GRP_SIZE_POST+1, fp), GRP_SIZE_POST+1);
+	EXPECT_EQ(fread(&preIds[0], sizeof(int), nSyn, fp), nSyn);
+	EXPECT_EQ(fread(&keyframeInterval, sizeof(int), 1, fp), 1);
+	EXPECT_EQ(fread(&wtRes, sizeof(float), 1, fp), 1);
+	EXPECT_EQ(keyframeInterval, KEYFRAME_INTERVAL);
+	EXPECT_FLOAT_EQ(wtRes, WT_RES);
+
+	// decode all frames
+	std::vector<float> wts(nSyn, NAN);
+	for (int f=0; f<NUM_SNAPSHOTS; f++) {
+		int64_t timeMs;
+		unsigned char frameType;
+		int payloadSize;
+		ASSERT_EQ(fread(&timeMs, sizeof(int64_t), 1, fp), 1);
+		ASSERT_EQ(fread(&frameType, sizeof(unsigned char), 1, fp), 1);
+		ASSERT_EQ(fread(&payloadSize, sizeof(int), 1, fp), 1);
+		EXPECT_EQ(timeMs, f*10);
+		EXPECT_EQ(frameType, (f%KEYFRAME_INTERVAL) ? 1 : 0);
+		std::vector<unsigned char> payload(payloadSize);
+		if (payloadSize>0)
+			ASSERT_EQ(fread(&payload[0], 1, payloadSize, fp), payloadSize);
+
+		if (frameType==0) {
+			ASSERT_EQ(payloadSize, nSyn*sizeof(float));
+			memcpy(&wts[0], &payload[0], payloadSize);
+		} else {
+			// pairs of varints: index gap, zig-zag encoded weight change
+			std::vector<uint32_t> vals;
+			uint32_t val = 0;
+			int shift = 0;
+			for (int b=0; b<payloadSize; b++) {
+				val |= (uint32_t)(payload[b] & 0x7f) << shift;
+				shift += 7;
+				if (!(payload[b] & 0x80)) {
+					vals.push_back(val);
+					val = 0;
+					shift = 0;
+				}
+			}
+			ASSERT_EQ(vals.size()%2, 0);
+			EXPECT_EQ(vals.size()/2, numChanged[f]);
+			int idx = -1;
+			for (unsigned int v=0; v<vals.size(); v+=2) {
+				idx += vals[v];
+				ASSERT_LT(idx, nSyn);
+				int32_t q = (int32_t)(vals[v+1] >> 1) ^ -(int32_t)(vals[v+1] & 1);
+				wts[idx] += q*wtRes;
+			}
+		}
+
+		for (int j=0; j<GRP_SIZE_POST; j++) {
+			for (int s=synPtr[j]; s<synPtr[j+1]; s++) {
+				EXPECT_NEAR(wts[s], wtSnapshots[f][preIds[s]][j], WT_RES);
+			}
+		}
+	}
+	int64_t timeMs;
+	EXPECT_EQ(fread(&timeMs, sizeof(int64_t), 1, fp), 0); // end of file
+	fclose(fp);
+}
@@ -208,6 +208,181 @@ TEST(CONNECT, connectRandom) {
 }
 
 
+// random connections skip from synapse to synapse (geometric distribution) and only look at the pre-neurons close to
+// the RF, but every pair in the RF must still be connected with probability p
+TEST(CONNECT, connectRandomStatistics) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("CONNECT.connectRandomStatistics",CPU_MODE,SILENT,0,42);
+	int g0=sim->createSpikeGeneratorGroup("input", 2000, EXCITATORY_NEURON);
+	int g1=sim->createGroup("excit", 2000, EXCITATORY_NEURON);
+	Grid3D grid(30,30,1);
+	int g2=sim->createGroup("excitGrid", grid, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->setNeuronParameters(g2, 0.02f, 0.2f, -65.0f, 8.0f);
+
+	double prob = 0.01, probRF = 0.4;
+	RadiusRF radius(4.5, 3, 0);
+	int c0=sim->connect(g0, g1, "random", RangeWeight(0.1), prob, RangeDelay(1));
+	int c1=sim->connect(g2, g2, "random", RangeWeight(0.1), probRF, RangeDelay(1), radius);
+	sim->setupNetwork();
+
+	// sparse connection: number of synapses and in-degree are binomially distributed
+	ConnectionMonitor* CM0 = sim->setConnectionMonitor(g0, g1, "NULL");
+	std::vector< std::vector<float> > wt0 = CM0->takeSnapshot();
+	double numPairs = 2000.0*2000.0;
+	EXPECT_NEAR(sim->getNumSynapticConnections(c0), prob*numPairs, 6.5*sqrt(numPairs*prob*(1-prob)));
+
+	int nSynLowerHalf = 0;
+	double sumDeg = 0.0, sumDeg2 = 0.0;
+	for (int j=0; j<2000; j++) {
+		int deg = 0;
+		for (int i=0; i<2000; i++) {
+			#if defined(WIN32) || defined(WIN64)
+				bool isSyn = !_isnan(wt0[i][j]);
+			#else
+				bool isSyn = !isnan(wt0[i][j]);
+			#endif
+			if (isSyn) {
+				deg++;
+				nSynLowerHalf += (i<1000);
+			}
+		}
+		sumDeg += deg;
+		sumDeg2 += deg*deg;
+	}
+	double meanDeg = sumDeg/2000, varDeg = sumDeg2/2000 - meanDeg*meanDeg;
+	EXPECT_NEAR(meanDeg, 2000*prob, 0.5);
+	EXPECT_NEAR(varDeg, 2000*prob*(1-prob), 0.2*2000*prob*(1-prob));
+	EXPECT_NEAR(nSynLowerHalf, sumDeg/2, 6.5*sqrt(sumDeg/4));
+
+	// RF-limited connection: no synapse outside the RF, and the right number inside
+	ConnectionMonitor* CM1 = sim->setConnectionMonitor(g2, g2, "NULL");
+	std::vector< std::vector<float> > wt1 = CM1->takeSnapshot();
+	int numPairsRF = 0;
+	bool allInRF = true;
+	for (int i=0; i<grid.N; i++) {
+		Point3D pre = sim->getNeuronLocation3D(g2, i);
+		for (int j=0; j<grid.N; j++) {
+			Point3D post = sim->getNeuronLocation3D(g2, j);
+			bool inRF = pow(pre.x-post.x,2)/pow(radius.radX,2) + pow(pre.y-post.y,2)/pow(radius.radY,2) <= 1.0;
+			numPairsRF += inRF;
+			#if defined(WIN32) || defined(WIN64)
+				allInRF &= (inRF || _isnan(wt1[i][j]));
+			#else
+				allInRF &= (inRF || isnan(wt1[i][j]));
+			#endif
+		}
+	}
+	EXPECT_TRUE(allInRF);
+	EXPECT_NEAR(sim->getNumSynapticConnections(c1), probRF*numPairsRF, 6.5*sqrt(numPairsRF*probRF*(1-probRF)));
+
+	delete sim;
+}
+
+// connections are drawn from random streams that only depend on the random seed of CARLsim (not on the global state
+// of rand), so the same seed must give the same synapses and delays, and a different seed a different network
+TEST(CONNECT, connectRandomReproducible) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	int runSeed[3] = {42, 42, 43};
+	std::vector< std::vector<float> > wtRef;
+	std::vector<uint8_t> delayRef;
+	for (int run=0; run<3; run++) {
+		srand(run); // must not matter
+
+		CARLsim* sim = new CARLsim("CONNECT.connectRandomReproducible",CPU_MODE,SILENT,0,runSeed[run]);
+		int g0=sim->createSpikeGeneratorGroup("input", 50, EXCITATORY_NEURON);
+		int g1=sim->createGroup("excit", 60, EXCITATORY_NEURON);
+		sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim->connect(g0, g1, "random", RangeWeight(0.1), 0.2, RangeDelay(1,20));
+		sim->connect(g1, g1, "full", RangeWeight(0.1), 1.0, RangeDelay(1,20));
+		sim->setupNetwork();
+
+		ConnectionMonitor* CM = sim->setConnectionMonitor(g0, g1, "NULL");
+		std::vector< std::vector<float> > wt = CM->takeSnapshot();
+		int nPre, nPost;
+		uint8_t* delays = sim->getDelays(g1, g1, nPre, nPost);
+		std::vector<uint8_t> delayVec(delays, delays + nPre*nPost);
+		delete[] delays;
+
+		if (run==0) {
+			wtRef = wt;
+			delayRef = delayVec;
+		} else {
+			// NaN marks a missing synapse, so compare the connectivity patterns
+			bool sameSynapses = true;
+			for (int i=0; i<wt.size(); i++)
+				for (int j=0; j<wt[i].size(); j++)
+					#if defined(WIN32) || defined(WIN64)
+						sameSynapses &= (_isnan(wt[i][j]) == _isnan(wtRef[i][j]));
+					#else
+						sameSynapses &= (isnan(wt[i][j]) == isnan(wtRef[i][j]));
+					#endif
+
+			EXPECT_EQ(sameSynapses, runSeed[run]==runSeed[0]);
+			EXPECT_EQ(delayVec==delayRef, runSeed[run]==runSeed[0]);
+		}
+
+		delete sim;
+	}
+}
+
+// CPU_MODE_MT splits the post-neurons of every connection among the threads when building the network, which must
+// result in the exact same synapses (and synapse order) as CPU_MODE
+TEST(CONNECT, connectCPUvsCPUMT) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	std::vector< std::vector<float> > wtRef[3];
+	std::vector<uint8_t> delayRef[3];
+	for (int run=0; run<2; run++) {
+		CARLsim* sim = new CARLsim("CONNECT.connectCPUvsCPUMT", run==0?CPU_MODE:CPU_MODE_MT, SILENT, 0, 42);
+		if (run==1)
+			sim->setNumThreads(3);
+		int g0=sim->createSpikeGeneratorGroup("input", Grid3D(10,10,1), EXCITATORY_NEURON);
+		int g1=sim->createGroup("excit", Grid3D(10,10,1), EXCITATORY_NEURON);
+		int g2=sim->createGroup("inhib", 37, INHIBITORY_NEURON);
+		sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim->setNeuronParameters(g2, 0.1f, 0.2f, -65.0f, 2.0f);
+		sim->connect(g0, g1, "gaussian", RangeWeight(0.2), 0.8, RangeDelay(1,10), RadiusRF(3,3,0));
+		sim->connect(g1, g2, "random", RangeWeight(0.0,0.1,0.2), 0.3, RangeDelay(1,20), RadiusRF(-1), SYN_PLASTIC);
+		sim->connect(g2, g1, "full-no-direct", RangeWeight(0.1), 1.0, RangeDelay(1,5));
+		sim->connect(g1, g1, "one-to-one", RangeWeight(0.1), 1.0, RangeDelay(1,20));
+		sim->setupNetwork();
+
+		int grpPre[3] = {g0, g1, g2};
+		int grpPost[3] = {g1, g2, g1};
+		for (int c=0; c<3; c++) {
+			ConnectionMonitor* CM = sim->setConnectionMonitor(grpPre[c], grpPost[c], "NULL");
+			std::vector< std::vector<float> > wt = CM->takeSnapshot();
+			int nPre, nPost;
+			uint8_t* delays = sim->getDelays(grpPre[c], grpPost[c], nPre, nPost);
+			std::vector<uint8_t> delayVec(delays, delays + nPre*nPost);
+			delete[] delays;
+
+			if (run==0) {
+				wtRef[c] = wt;
+				delayRef[c] = delayVec;
+			} else {
+				// NaN marks a missing synapse
+				bool sameSynapses = true;
+				for (int i=0; i<wt.size(); i++)
+					for (int j=0; j<wt[i].size(); j++)
+						#if defined(WIN32) || defined(WIN64)
+							sameSynapses &= (_isnan(wt[i][j]) ? _isnan(wtRef[c][i][j]) : wt[i][j]==wtRef[c][i][j]);
+						#else
+							sameSynapses &= (isnan(wt[i][j]) ? isnan(wtRef[c][i][j]) : wt[i][j]==wtRef[c][i][j]);
+						#endif
+
+				EXPECT_TRUE(sameSynapses);
+				EXPECT_TRUE(delayVec==delayRef[c]);
+			}
+		}
+
+		delete sim;
+	}
+}
+
 TEST(CONNECT, connectGaussian) {
 	CARLsim* sim = NULL;
 
@@ -405,3 +580,56 @@ TEST(CONNECT, connectGaussian) {
 		}
 	}
 }
+
+// connections between groups with different Grid3D sizes: the pre-neuron locations are scaled to the grid of the
+// post-group, and only the pre-neurons in that (scaled) RF may be connected
+TEST(CONNECT, connectGaussianScaledGrid) {
+	CARLsim* sim = new CARLsim("CONNECT.connectGaussianScaledGrid",CPU_MODE,SILENT,0,42);
+	Grid3D gridFine(20,20,1), gridCoarse(10,10,1);
+	int g0=sim->createGroup("fine", gridFine, EXCITATORY_NEURON);
+	int g1=sim->createGroup("coarse", gridCoarse, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g0, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+
+	double wt = 0.1;
+	RadiusRF radius(2.0, 1.5, -1);
+	int c0=sim->connect(g0, g1, "gaussian", RangeWeight(wt), 1.0, RangeDelay(1), radius);
+	int c1=sim->connect(g1, g0, "gaussian", RangeWeight(wt), 1.0, RangeDelay(1), radius);
+	sim->setupNetwork();
+
+	int grpPre[2] = {g0, g1};
+	int grpPost[2] = {g1, g0};
+	int connId[2] = {c0, c1};
+	for (int c=0; c<2; c++) {
+		Grid3D gridPre = sim->getGroupGrid3D(grpPre[c]);
+		Grid3D gridPost = sim->getGroupGrid3D(grpPost[c]);
+		double scaleX = 1.0*gridPost.x/gridPre.x, scaleY = 1.0*gridPost.y/gridPre.y;
+
+		ConnectionMonitor* CM = sim->setConnectionMonitor(grpPre[c], grpPost[c], "NULL");
+		std::vector< std::vector<float> > wt0 = CM->takeSnapshot();
+		int nSyn = 0;
+		for (int i=0; i<gridPre.N; i++) {
+			Point3D pre = sim->getNeuronLocation3D(grpPre[c], i);
+			for (int j=0; j<gridPost.N; j++) {
+				Point3D post = sim->getNeuronLocation3D(grpPost[c], j);
+				double rfDist = pow(pre.x*scaleX-post.x,2)/pow(radius.radX,2)
+					+ pow(pre.y*scaleY-post.y,2)/pow(radius.radY,2);
+				double gaussWt = exp(-2.3026*rfDist);
+				if (rfDist > 1.0 || gaussWt < 0.1) {
+#if defined(WIN32) || defined(WIN64)
+					EXPECT_TRUE(_isnan(wt0[i][j]));
+#else
+					EXPECT_TRUE(isnan(wt0[i][j]));
+#endif
+				} else {
+					nSyn++;
+					EXPECT_FLOAT_EQ(wt0[i][j], gaussWt*wt);
+				}
+			}
+		}
+		EXPECT_GT(nSyn, 0);
+		EXPECT_EQ(sim->getNumSynapticConnections(connId[c]), nSyn);
+	}
+
+	delete sim;
+}
@@ -797,3 +797,477 @@ TEST(CORE, setNeuronParameters) {
 		}
 	}
 }
+
+// CPU_MODE_MT integrates every neuron with the exact same code as CPU_MODE, just on a different thread, and delivers
+// spikes to every post-synaptic neuron in the same order, so spike times must match exactly (for any number of
+// threads, including partitions that cut through groups, and no matter whether spike delivery runs in parallel)
+TEST(CORE, spikeTimesCPUvsCPUMT) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	int nInput = 100, nExc = 80, nInh = 21, nDA = 10;
+	int runTimeMs = 1000;
+
+	// run 0: CPU_MODE reference, runs 1-2: serial/parallel spike delivery, run 3: switch delivery mode at runtime
+	int numRuns = 4;
+	int runNumThreads[] = {1, 2, 3, 3};
+
+	for (int isCOBA=0; isCOBA<=1; isCOBA++) {
+		for (int isRK4=0; isRK4<=1; isRK4++) {
+			std::vector<std::vector<int> > spkTimesExcCPU, spkTimesInhCPU;
+
+			for (int run=0; run<numRuns; run++) {
+				CARLsim* sim = new CARLsim("CORE.spikeTimesCPUvsCPUMT", run==0?CPU_MODE:CPU_MODE_MT, SILENT, 0, 42);
+				if (run>0) {
+					sim->setNumThreads(runNumThreads[run]);
+					sim->setParallelSpikeDelivery(run!=1);
+				}
+
+				int gIn = sim->createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+				int gDA = sim->createSpikeGeneratorGroup("DA", nDA, DOPAMINERGIC_NEURON);
+				int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+				int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+				sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+				sim->setNeuronParameters(gInh, 20.0f, 1.0f, -55.0f, -40.0f, 0.15f, 8.0f, 25.0f, -55.0f, 200.0f); // FS
+
+				float wtScale = isCOBA ? 1.0f : 200.0f;
+				sim->connect(gIn, gExc, "random", RangeWeight(0.0f, 0.05f*wtScale, 0.1f*wtScale), 0.2f,
+					RangeDelay(1,10), RadiusRF(-1), SYN_PLASTIC);
+				sim->connect(gDA, gExc, "full", RangeWeight(0.0f), 1.0f, RangeDelay(1,5));
+				sim->connect(gExc, gExc, "random", RangeWeight(0.02f*wtScale), 0.1f, RangeDelay(1,20));
+				sim->connect(gExc, gInh, "random", RangeWeight(0.05f*wtScale), 0.2f, RangeDelay(1));
+				sim->connect(gInh, gExc, "random", RangeWeight(0.05f*wtScale), 0.2f, RangeDelay(1));
+				sim->setConductances(isCOBA>0);
+				sim->setESTDP(gExc, true, DA_MOD, ExpCurve(0.01f*wtScale, 20.0f, -0.012f*wtScale, 20.0f));
+				if (isRK4) {
+					sim->setIntegrationMethod(RUNGE_KUTTA4, 10);
+				} else {
+					sim->setIntegrationMethod(FORWARD_EULER, 2);
+				}
+
+				sim->setupNetwork();
+				EXPECT_EQ(sim->getNumThreads(), runNumThreads[run]);
+
+				PoissonRate in(nInput);
+				in.setRates(30.0f);
+				sim->setSpikeRate(gIn, &in);
+				PoissonRate inDA(nDA);
+				inDA.setRates(5.0f);
+				sim->setSpikeRate(gDA, &inDA);
+
+				SpikeMonitor* spkMonExc = sim->setSpikeMonitor(gExc, "NULL");
+				SpikeMonitor* spkMonInh = sim->setSpikeMonitor(gInh, "NULL");
+				spkMonExc->startRecording();
+				spkMonInh->startRecording();
+				// split the run in two in all runs (spike generation depends on how runNetwork calls are split up)
+				sim->runNetwork(0, runTimeMs/2);
+				if (run==3) {
+					sim->setParallelSpikeDelivery(false);
+				}
+				sim->runNetwork(0, runTimeMs - runTimeMs/2);
+				spkMonExc->stopRecording();
+				spkMonInh->stopRecording();
+
+				if (run==0) {
+					spkTimesExcCPU = spkMonExc->getSpikeVector2D();
+					spkTimesInhCPU = spkMonInh->getSpikeVector2D();
+					EXPECT_GT(spkMonExc->getPopNumSpikes(), 0);
+				} else {
+					std::vector<std::vector<int> > spkTimesExc = spkMonExc->getSpikeVector2D();
+					std::vector<std::vector<int> > spkTimesInh = spkMonInh->getSpikeVector2D();
+					for (int i=0; i<nExc; i++) {
+						EXPECT_EQ(spkTimesExc[i], spkTimesExcCPU[i]);
+					}
+					for (int i=0; i<nInh; i++) {
+						EXPECT_EQ(spkTimesInh[i], spkTimesInhCPU[i]);
+					}
+				}
+
+				delete sim;
+			}
+		}
+	}
+}
+
+// The pull engine sums up the synaptic inputs of every post-synaptic neuron in a different order than the push engine,
+// so spike times are not identical, but the firing rates must match. The multi-threaded pull engine partitions the
+// post-synaptic neurons, and must thus give exactly the same results as the serial one.
+TEST(CORE, firingRatePushVsPull) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	int nInput = 100, nExc = 100, nInh = 25;
+	int runTimeMs = 2000;
+
+	// run 0: push (reference), run 1: pull, run 2: pull in CPU_MODE_MT
+	int numRuns = 3;
+	spikePropagation_t runEngine[] = {PUSH_PROPAGATION, PULL_PROPAGATION, PULL_PROPAGATION};
+
+	// config 0: CUBA, config 1: COBA, config 2: COBA with STP (which requires all delays to be 1 ms)
+	for (int config=0; config<3; config++) {
+		bool isCOBA = config > 0;
+		bool withSTP = config == 2;
+		float rateExcPush = 0.0f, rateInhPush = 0.0f;
+		std::vector<std::vector<int> > spkTimesExcPull;
+
+		for (int run=0; run<numRuns; run++) {
+			CARLsim* sim = new CARLsim("CORE.firingRatePushVsPull", run==2?CPU_MODE_MT:CPU_MODE, SILENT, 0, 42);
+			if (run==2) {
+				sim->setNumThreads(3);
+			}
+			sim->setSpikePropagation(runEngine[run]);
+
+			int gIn = sim->createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+			int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			// CUBA weights are scaled up, and input to the inhibitory group is weaker in COBA mode
+			float wtScale = isCOBA ? 1.0f : 100.0f;
+			float wtInInh = isCOBA ? 0.001f : 0.02f*wtScale;
+			int maxDelay = withSTP ? 1 : 10;
+			sim->connect(gIn, gExc, "full", RangeWeight(0.0f, 0.03f*wtScale, 0.06f*wtScale), 1.0f,
+				RangeDelay(1,maxDelay), RadiusRF(-1), SYN_PLASTIC);
+			sim->connect(gIn, gInh, "random", RangeWeight(wtInInh), 0.8f, RangeDelay(1,maxDelay/2+1));
+			sim->connect(gExc, gInh, "random", RangeWeight(0.01f*wtScale), 0.5f, RangeDelay(1));
+			sim->connect(gInh, gExc, "full", RangeWeight(0.01f*wtScale), 1.0f, RangeDelay(1,maxDelay/3+1));
+			sim->setConductances(isCOBA);
+			if (withSTP) {
+				sim->setSTP(gIn, true, 0.45f, 50.0f, 750.0f);
+			}
+			sim->setESTDP(gExc, true, STANDARD, ExpCurve(0.001f*wtScale, 20.0f, -0.0012f*wtScale, 20.0f));
+
+			sim->setupNetwork();
+			EXPECT_EQ(sim->getSpikePropagation(), runEngine[run]);
+
+			PoissonRate in(nInput);
+			in.setRates(20.0f);
+			sim->setSpikeRate(gIn, &in);
+
+			SpikeMonitor* spkMonExc = sim->setSpikeMonitor(gExc, "NULL");
+			SpikeMonitor* spkMonInh = sim->setSpikeMonitor(gInh, "NULL");
+			spkMonExc->startRecording();
+			spkMonInh->startRecording();
+			sim->runNetwork(runTimeMs/1000, runTimeMs%1000);
+			spkMonExc->stopRecording();
+			spkMonInh->stopRecording();
+
+			if (run==0) {
+				rateExcPush = spkMonExc->getPopMeanFiringRate();
+				rateInhPush = spkMonInh->getPopMeanFiringRate();
+				EXPECT_GT(rateExcPush, 1.0f);
+				EXPECT_GT(rateInhPush, 1.0f);
+			} else {
+				EXPECT_NEAR(spkMonExc->getPopMeanFiringRate(), rateExcPush, rateExcPush*0.05f);
+				EXPECT_NEAR(spkMonInh->getPopMeanFiringRate(), rateInhPush, rateInhPush*0.05f);
+				if (run==1) {
+					spkTimesExcPull = spkMonExc->getSpikeVector2D();
+				} else {
+					std::vector<std::vector<int> > spkTimesExc = spkMonExc->getSpikeVector2D();
+					for (int i=0; i<nExc; i++) {
+						EXPECT_EQ(spkTimesExc[i], spkTimesExcPull[i]);
+					}
+				}
+			}
+
+			delete sim;
+		}
+	}
+}
+
+// Push delivery reads the weights from a copy (synWt), which has to be refreshed after setWeight and after every STDP
+// weight update. With one-to-one connections, every post-synaptic neuron receives at most one spike per time step, so
+// push and pull have to produce exactly the same spikes and weights.
+TEST(CORE, pushDeliveryWeightUpdates) {
+	int nNeur = 100;
+	std::vector<std::vector<int> > spkTimesPush[2];
+	std::vector<std::vector<float> > wtPush;
+
+	// run 0: push, run 1: pull (reference)
+	for (int run=0; run<2; run++) {
+		CARLsim* sim = new CARLsim("CORE.pushDeliveryWeightUpdates", CPU_MODE, SILENT, 0, 42);
+		sim->setSpikePropagation(run==0 ? PUSH_PROPAGATION : PULL_PROPAGATION);
+
+		// gPlastic receives plastic synapses (STDP), gFixed receives fixed synapses (only changed by setWeight)
+		int gIn = sim->createSpikeGeneratorGroup("input", nNeur, EXCITATORY_NEURON);
+		int gPlastic = sim->createGroup("plastic", nNeur, EXCITATORY_NEURON);
+		int gFixed = sim->createGroup("fixed", nNeur, EXCITATORY_NEURON);
+		sim->setNeuronParameters(gPlastic, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+		sim->setNeuronParameters(gFixed, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+		int cPlastic = sim->connect(gIn, gPlastic, "one-to-one", RangeWeight(0.0f, 1.0f, 50.0f), 1.0f,
+			RangeDelay(1,5), RadiusRF(-1), SYN_PLASTIC);
+		int cFixed = sim->connect(gIn, gFixed, "one-to-one", RangeWeight(1.0f), 1.0f, RangeDelay(1,5), RadiusRF(-1),
+			SYN_FIXED);
+		sim->setConductances(false);
+		sim->setESTDP(gPlastic, true, STANDARD, ExpCurve(2.0f, 20.0f, -3.0f, 20.0f));
+		sim->setWeightAndWeightChangeUpdate(INTERVAL_10MS, true, 0.9f);
+
+		sim->setupNetwork();
+		EXPECT_EQ(sim->getSpikePropagation(), run==0 ? PUSH_PROPAGATION : PULL_PROPAGATION);
+
+		PoissonRate in(nNeur);
+		in.setRates(20.0f);
+		sim->setSpikeRate(gIn, &in);
+
+		SpikeMonitor* spkMon[2];
+		spkMon[0] = sim->setSpikeMonitor(gPlastic, "NULL");
+		spkMon[1] = sim->setSpikeMonitor(gFixed, "NULL");
+		ConnectionMonitor* connMon = sim->setConnectionMonitor(gIn, gPlastic, "NULL");
+		connMon->setUpdateTimeIntervalSec(-1);
+
+		// the initial weights are too weak to make the output neurons fire
+		sim->runNetwork(1,0);
+
+		// after setWeight, every other output neuron should fire, which in turn drives STDP in gPlastic
+		for (int i=0; i<nNeur; i+=2) {
+			sim->setWeight(cPlastic, i, i, 40.0f);
+			sim->setWeight(cFixed, i, i, 40.0f, true);
+		}
+		for (int m=0; m<2; m++) {
+			spkMon[m]->startRecording();
+		}
+		sim->runNetwork(2,0);
+		for (int m=0; m<2; m++) {
+			spkMon[m]->stopRecording();
+			EXPECT_GT(spkMon[m]->getPopNumSpikes(), 0);
+		}
+
+		std::vector<std::vector<float> > wt = connMon->takeSnapshot();
+		int numChanged = 0;
+		for (int i=0; i<nNeur; i+=2) {
+			numChanged += wt[i][i] != 40.0f;
+		}
+		EXPECT_GT(numChanged, 0);
+
+		if (run==0) {
+			for (int m=0; m<2; m++) {
+				spkTimesPush[m] = spkMon[m]->getSpikeVector2D();
+			}
+			wtPush = wt;
+		} else {
+			for (int m=0; m<2; m++) {
+				std::vector<std::vector<int> > spkTimes = spkMon[m]->getSpikeVector2D();
+				for (int i=0; i<nNeur; i++) {
+					EXPECT_EQ(spkTimesPush[m][i], spkTimes[i]);
+				}
+			}
+			for (int i=0; i<nNeur; i++) {
+				EXPECT_FLOAT_EQ(wtPush[i][i], wt[i][i]);
+			}
+		}
+
+		delete sim;
+	}
+}
+
+// The fused state update decays the conductances at the end of a time step instead of at the beginning of the next
+// one, which must not change the results.
+TEST(CORE, spikeTimesFusedStateUpdate) {
+	int nInput = 100, nExc = 300, nInh = 50;
+	int runTimeMs = 1000;
+
+	// config 0: CUBA, config 1: COBA, config 2: COBA with rise times and 2 RK4 steps per ms
+	for (int config=0; config<3; config++) {
+		bool isCOBA = config > 0;
+		std::vector<std::vector<int> > spkTimesRef;
+
+		// run 0: default (reference), run 1: fused, run 2: fused in CPU_MODE_MT
+		for (int run=0; run<3; run++) {
+			CARLsim* sim = new CARLsim("CORE.spikeTimesFusedStateUpdate", run==2?CPU_MODE_MT:CPU_MODE, SILENT, 0,
+				42);
+			if (run==2) {
+				sim->setNumThreads(3);
+			}
+			sim->setFusedStateUpdate(run>0);
+
+			int gIn = sim->createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+			int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			float wtScale = isCOBA ? 1.0f : 100.0f;
+			sim->connect(gIn, gExc, "random", RangeWeight(0.03f*wtScale), 0.5f, RangeDelay(1,10));
+			sim->connect(gIn, gInh, "random", RangeWeight(isCOBA ? 0.001f : 0.02f*wtScale), 0.5f, RangeDelay(1,5));
+			sim->connect(gExc, gInh, "random", RangeWeight(0.01f*wtScale), 0.2f, RangeDelay(1));
+			sim->connect(gInh, gExc, "random", RangeWeight(0.01f*wtScale), 0.5f, RangeDelay(1,3));
+			if (config==2) {
+				sim->setConductances(true, 5, 20, 150, 6, 100, 150);
+				sim->setIntegrationMethod(RUNGE_KUTTA4, 2);
+			} else {
+				sim->setConductances(isCOBA);
+			}
+
+			sim->setupNetwork();
+
+			PoissonRate in(nInput);
+			in.setRates(20.0f);
+			sim->setSpikeRate(gIn, &in);
+
+			SpikeMonitor* spkMon = sim->setSpikeMonitor(gExc, "NULL");
+			spkMon->startRecording();
+			sim->runNetwork(runTimeMs/1000, runTimeMs%1000);
+			spkMon->stopRecording();
+
+			if (run==0) {
+				spkTimesRef = spkMon->getSpikeVector2D();
+				EXPECT_GT(spkMon->getPopMeanFiringRate(), 1.0f);
+			} else {
+				std::vector<std::vector<int> > spkTimes = spkMon->getSpikeVector2D();
+				for (int i=0; i<nExc; i++) {
+					EXPECT_EQ(spkTimes[i], spkTimesRef[i]);
+				}
+			}
+
+			delete sim;
+		}
+	}
+}
+
+// The AVX2 and AVX-512 kernels integrate several neurons per instruction, but must compute exactly the same
+// voltages as the scalar kernel. On CPUs without AVX2, both runs use the scalar kernel.
+TEST(CORE, spikeTimesSIMDvsScalar) {
+	int nInput = 100, nExc = 301, nInh = 53; // not a multiple of the vector width, so the tail is covered as well
+	int runTimeMs = 1000, sampleMs = 100;
+
+	// config 0: CUBA with Forward-Euler, config 1: COBA with rise times and 2 RK4 steps per ms
+	for (int config=0; config<2; config++) {
+		bool isCOBA = config > 0;
+		std::vector<std::vector<int> > spkTimesRef;
+		std::vector<std::vector<float> > voltRef;
+
+		// run 0: scalar kernel (reference), run 1: SIMD kernels, run 2: SIMD kernels in CPU_MODE_MT
+		for (int run=0; run<3; run++) {
+			CARLsim* sim = new CARLsim("CORE.spikeTimesSIMDvsScalar", run==2?CPU_MODE_MT:CPU_MODE, SILENT, 0, 42);
+			if (run==2) {
+				sim->setNumThreads(3);
+			}
+			sim->setSIMDKernels(run>0);
+
+			int gIn = sim->createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+			int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			float wtScale = isCOBA ? 1.0f : 100.0f;
+			sim->connect(gIn, gExc, "random", RangeWeight(0.03f*wtScale), 0.5f, RangeDelay(1,10));
+			sim->connect(gIn, gInh, "random", RangeWeight(isCOBA ? 0.001f : 0.02f*wtScale), 0.5f, RangeDelay(1,5));
+			sim->connect(gExc, gInh, "random", RangeWeight(0.01f*wtScale), 0.2f, RangeDelay(1));
+			sim->connect(gInh, gExc, "random", RangeWeight(0.01f*wtScale), 0.5f, RangeDelay(1,3));
+			if (isCOBA) {
+				sim->setConductances(true, 5, 20, 150, 6, 100, 150);
+				sim->setIntegrationMethod(RUNGE_KUTTA4, 2);
+			} else {
+				sim->setConductances(false);
+			}
+
+			sim->setupNetwork();
+
+			PoissonRate in(nInput);
+			in.setRates(20.0f);
+			sim->setSpikeRate(gIn, &in);
+
+			SpikeMonitor* spkMon = sim->setSpikeMonitor(gExc, "NULL");
+			spkMon->startRecording();
+			std::vector<std::vector<float> > volt;
+			for (int t=0; t<runTimeMs; t+=sampleMs) {
+				sim->runNetwork(0, sampleMs);
+				volt.push_back(sim->getVoltage(gExc));
+			}
+			spkMon->stopRecording();
+
+			if (run==0) {
+				spkTimesRef = spkMon->getSpikeVector2D();
+				voltRef = volt;
+				EXPECT_GT(spkMon->getPopMeanFiringRate(), 1.0f);
+			} else {
+				std::vector<std::vector<int> > spkTimes = spkMon->getSpikeVector2D();
+				for (int i=0; i<nExc; i++) {
+					EXPECT_EQ(spkTimes[i], spkTimesRef[i]);
+				}
+				for (int s=0; s<(int)volt.size(); s++) {
+					for (int i=0; i<nExc; i++) {
+						EXPECT_FLOAT_EQ(volt[s][i], voltRef[s][i]);
+					}
+				}
+			}
+
+			delete sim;
+		}
+	}
+}
+
+// the spike buffers must hold every spike no matter how small their budget is, and the budget should only affect
+// how often the buffers overflow
+TEST(CORE, spikeBufferBudget) {
+	int nInput = 100, nExc = 300, nInh = 50;
+	std::vector<std::vector<int> > spkTimesRef;
+
+	// run 0: default budget (reference), run 1: no budget at all, run 2: budget of the maximum rate
+	for (int run=0; run<3; run++) {
+		CARLsim* sim = new CARLsim("CORE.spikeBufferBudget", CPU_MODE, SILENT, 0, 42);
+		int gIn = sim->createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+		int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+		int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+		sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f);
+		sim->connect(gIn, gExc, "random", RangeWeight(0.03f), 0.5f, RangeDelay(1,10));
+		sim->connect(gExc, gInh, "random", RangeWeight(0.01f), 0.2f, RangeDelay(1));
+		sim->connect(gInh, gExc, "random", RangeWeight(0.01f), 0.5f, RangeDelay(1,3));
+		sim->setConductances(true);
+		if (run==1) {
+			sim->setSpikeBufferBudget(ALL, 0.0f);
+		} else if (run==2) {
+			sim->setSpikeBufferBudget(ALL, 1000.0f);
+		}
+		sim->setupNetwork();
+
+		PoissonRate in(nInput);
+		in.setRates(20.0f);
+		sim->setSpikeRate(gIn, &in);
+
+		SpikeMonitor* spkMon = sim->setSpikeMonitor(gExc, "NULL");
+		spkMon->startRecording();
+		sim->runNetwork(2,0);
+		spkMon->stopRecording();
+
+		if (run==0) {
+			spkTimesRef = spkMon->getSpikeVector2D();
+			EXPECT_GT(spkMon->getPopMeanFiringRate(), 1.0f);
+		} else {
+			std::vector<std::vector<int> > spkTimes = spkMon->getSpikeVector2D();
+			for (int i=0; i<nExc; i++) {
+				EXPECT_EQ(spkTimes[i], spkTimesRef[i]);
+			}
+		}
+
+		if (run==1) {
+			// the budget doubles with every overflow
+			EXPECT_GT(sim->getNumSpikeBufferOverflows(), 0);
+			EXPECT_LT(sim->getNumSpikeBufferOverflows(), 40);
+		} else if (run==2) {
+			EXPECT_EQ(sim->getNumSpikeBufferOverflows(), 0);
+		}
+
+		delete sim;
+	}
+}
+
+TEST(CORE, setSpikePropagationAuto) {
+	for (int highRate=0; highRate<=1; highRate++) {
+		CARLsim* sim = new CARLsim("CORE.setSpikePropagationAuto", CPU_MODE, SILENT, 0, 42);
+		int gIn = sim->createSpikeGeneratorGroup("input", 100, EXCITATORY_NEURON);
+		int gExc = sim->createGroup("exc", 100, EXCITATORY_NEURON);
+		sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim->connect(gIn, gExc, "full", RangeWeight(0.01f), 1.0f, RangeDelay(1,5));
+		sim->setConductances(true);
+
+		// dense connectivity: at high firing rates most synapses see a spike every time step, so pulling is cheaper
+		sim->setSpikePropagation(AUTO_PROPAGATION, highRate ? 500.0f : 1.0f);
+		EXPECT_EQ(sim->getSpikePropagation(), AUTO_PROPAGATION);
+		sim->setupNetwork();
+		EXPECT_EQ(sim->getSpikePropagation(), highRate ? PULL_PROPAGATION : PUSH_PROPAGATION);
+
+		delete sim;
+	}
+}
@@ -763,3 +763,70 @@ TEST(Interface, setSTDPDeath) {
 
 	delete sim;
 }
+
+TEST(Interface, setNumThreadsDeath) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("Interface.setNumThreadsDeath",CPU_MODE,SILENT,0,42);
+	EXPECT_DEATH({sim->setNumThreads(2);},""); // only in CPU_MODE_MT
+	delete sim;
+
+	sim = new CARLsim("Interface.setNumThreadsDeath",CPU_MODE_MT,SILENT,0,42);
+	EXPECT_DEATH({sim->setNumThreads(0);},"");
+	EXPECT_DEATH({sim->setNumThreads(-1);},"");
+
+	int g0 = sim->createGroup("g0", 1, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g0, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->setupNetwork();
+	EXPECT_DEATH({sim->setNumThreads(2);},""); // only in CONFIG_STATE
+	delete sim;
+}
+
+TEST(Interface, setParallelSpikeDeliveryDeath) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("Interface.setParallelSpikeDeliveryDeath",CPU_MODE,SILENT,0,42);
+	EXPECT_DEATH({sim->setParallelSpikeDelivery(true);},""); // only in CPU_MODE_MT
+	delete sim;
+}
+
+TEST(Interface, setSpikePropagationDeath) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("Interface.setSpikePropagationDeath",CPU_MODE,SILENT,0,42);
+	int g1 = sim->createGroup("excit", 10, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->connect(g1, g1, "random", RangeWeight(0.01f), 0.1f);
+	EXPECT_DEATH({sim->setSpikePropagation(AUTO_PROPAGATION, -1.0f);},""); // negative firing rate
+	sim->setConductances(true);
+	sim->setupNetwork();
+	EXPECT_DEATH({sim->setSpikePropagation(PULL_PROPAGATION);},""); // only in CONFIG state
+	delete sim;
+}
+
+TEST(Interface, setSpikeBufferBudgetDeath) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("Interface.setSpikeBufferBudgetDeath",CPU_MODE,SILENT,0,42);
+	int g1 = sim->createGroup("excit", 10, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->connect(g1, g1, "random", RangeWeight(0.01f), 0.1f);
+	sim->setConductances(true);
+	EXPECT_DEATH({sim->setSpikeBufferBudget(g1, -1.0f);},""); // rate cannot be negative
+	sim->setupNetwork();
+	EXPECT_DEATH({sim->setSpikeBufferBudget(g1, 10.0f);},""); // only in CONFIG state
+	delete sim;
+}
+
+TEST(Interface, setFusedStateUpdateDeath) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	CARLsim* sim = new CARLsim("Interface.setFusedStateUpdateDeath",CPU_MODE,SILENT,0,42);
+	int g1 = sim->createGroup("excit", 10, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02f, 0.2f, -65.0f, 8.0f);
+	sim->connect(g1, g1, "random", RangeWeight(0.01f), 0.1f);
+	sim->setConductances(true);
+	sim->setupNetwork();
+	EXPECT_DEATH({sim->setFusedStateUpdate(true);},""); // only in CONFIG state
+	delete sim;
+}
@@ -179,11 +179,62 @@ TEST(PoissRate, setRateNeurId) {
 	}
 }
 
-//! \NOTE: There is no good way to further test PoissonRate and in a CARLsim environment. Running the network twice
-//! will not reproduce the same spike train (because of the random seed). Comparing CPU mode to GPU mode will not work
-//! because CPU and GPU use different random seeds. Comparing lambda in PoissonRate.setRate(lambda) to the one from
-//! SpikeMonitor.getNeuronMeanFiringRate() will not work because the Poisson process has standard deviation == lambda.
+//! \NOTE: Comparing CPU mode to GPU mode will not work because CPU and GPU use different random number generators.
+//! Comparing lambda in PoissonRate.setRate(lambda) to the one from SpikeMonitor.getNeuronMeanFiringRate() of a single
+//! neuron will not work because the Poisson process has standard deviation == lambda.
 TEST(PoissRate, runSim) {
-	// \TODO test CARLsim integration
 	// \TODO use cuRAND
+}
+
+// In CPU mode, Poisson spike trains are drawn from a counter-based RNG, so for a given random seed they must not
+// depend on the number of threads or on how the simulation is split into runNetwork calls. The mean rate of a large
+// group must be close to the requested rate, minus the refractory period: ISI = refPeriod + floor(exponential).
+TEST(PoissRate, spikeTrainCPUvsCPUMT) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	int nNeur = 2000; // large enough for the worker threads to split the group
+	int runTimeMs = 1000;
+	float rateHz = 20.0f;
+
+	// run 0: CPU_MODE, run 1: CPU_MODE_MT, run 2: CPU_MODE in short runNetwork calls
+	std::vector<std::vector<int> > spkTimesCPU;
+	for (int run=0; run<3; run++) {
+		CARLsim* sim = new CARLsim("PoissRate.spikeTrainCPUvsCPUMT", run==1?CPU_MODE_MT:CPU_MODE, SILENT, 0, 42);
+		if (run==1)
+			sim->setNumThreads(3);
+
+		int gIn = sim->createSpikeGeneratorGroup("input", nNeur, EXCITATORY_NEURON);
+		int gOut = sim->createGroup("output", 1, EXCITATORY_NEURON);
+		sim->setNeuronParameters(gOut, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim->connect(gIn, gOut, "full", RangeWeight(0.0f), 1.0f, RangeDelay(1));
+		sim->setConductances(true);
+		sim->setupNetwork();
+
+		PoissonRate in(nNeur);
+		in.setRates(rateHz);
+		sim->setSpikeRate(gIn, &in);
+
+		SpikeMonitor* spkMon = sim->setSpikeMonitor(gIn, "NULL");
+		spkMon->startRecording();
+		if (run==2) {
+			for (int i=0; i<runTimeMs/100; i++)
+				sim->runNetwork(0, 100);
+		} else {
+			sim->runNetwork(runTimeMs/1000, runTimeMs%1000);
+		}
+		spkMon->stopRecording();
+
+		if (run==0) {
+			spkTimesCPU = spkMon->getSpikeVector2D();
+			float expectedHz = 1000.0f / (1.0f + 1000.0f/rateHz - 0.5f);
+			EXPECT_NEAR(spkMon->getPopMeanFiringRate(), expectedHz, 0.5f);
+		} else {
+			std::vector<std::vector<int> > spkTimes = spkMon->getSpikeVector2D();
+			for (int i=0; i<nNeur; i++) {
+				EXPECT_EQ(spkTimes[i], spkTimesCPU[i]);
+			}
+		}
+
+		delete sim;
+	}
 }
\ No newline at end of file
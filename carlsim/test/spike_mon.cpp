@@ -3,6 +3,9 @@
 
 #include <carlsim.h>
 #include <snn_definitions.h> // MAX_GRP_PER_SNN
+#include <spikegen_from_file.h>
+
+#include <stdio.h>			// fopen, fseek, ftell
 
 #if defined(WIN32) || defined(WIN64)
 #include <periodic_spikegen.h>
@@ -48,6 +51,9 @@ TEST(setSpikeMon, grpId){
 		EXPECT_DEATH(sim->setSpikeMonitor(2,"Default"),""); // greater than number of groups
 		EXPECT_DEATH(sim->setSpikeMonitor(MAX_GRP_PER_SNN,"Default"),""); // greater than number of group & and greater than max groups
 
+		int g3 = sim->createGroup("g3", MAX_SPIKE_MON_GROUP_SIZE+1, EXCITATORY_NEURON);
+		EXPECT_DEATH(sim->setSpikeMonitor(g3,"NULL"),""); // too many neurons
+
 		delete sim;
 	}
 }
@@ -145,9 +151,10 @@ TEST(SpikeMon, interfaceDeath) {
 	// set up network and test all API calls that are not valid in certain modes
 	sim.setupNetwork();
 
-	// \TODO SpikeMonitor mode COUNT not yet implemented
-	EXPECT_DEATH(spkMon->setMode(COUNT),"");
-	// after mode is implemented, make sure you cannot call getSpikeVector2D in COUNT mode, etc.
+	// spike times are not available in COUNT mode
+	spkMon->setMode(COUNT);
+	EXPECT_DEATH(spkMon->getSpikeVector2D(),"");
+	spkMon->setMode(AER);
 
 	// test all APIs that cannot be called when recording is on
 	spkMon->startRecording();
@@ -168,6 +175,7 @@ TEST(SpikeMon, interfaceDeath) {
 	EXPECT_DEATH(spkMon->print(),"");
 	EXPECT_DEATH(spkMon->startRecording(),"");
 	EXPECT_DEATH(spkMon->setLogFile("meow.dat"),"");
+	EXPECT_DEATH(spkMon->setMode(COUNT),"");
 }
 
 
@@ -693,3 +701,291 @@ TEST(SpikeMon, setLogFile) {
 		delete sim;
 	}
 }
+
+/*!
+ * \brief testing the compact spike file format
+ *
+ * This test records Poisson spikes to a spike file in the compact format (using a small block size, so that the file
+ * consists of many blocks), then replays the file with SpikeGeneratorFromFile and makes sure the exact same spikes are
+ * generated. The compact file should be much smaller than the AER format (8 bytes per spike).
+ */
+TEST(SpikeMon, compactFileFormat) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	const int GRP_SIZE = 100;
+	std::string fileName = "results/spk_compact.dat";
+	std::vector<std::vector<int> > spkVec[2];
+
+	for (int run=0; run<=1; run++) {
+		CARLsim* sim = new CARLsim("SpikeMon.compactFileFormat",CPU_MODE,SILENT,0,42);
+		int g1 = sim->createGroup("g1", 1, EXCITATORY_NEURON);
+		sim->setNeuronParameters(g1, 0.02, 0.2, -65.0, 8.0);
+		int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE, EXCITATORY_NEURON);
+
+		SpikeGeneratorFromFile* sgf = NULL;
+		if (run==1) {
+			// second run: replay the compact file
+			sgf = new SpikeGeneratorFromFile(fileName);
+			sim->setSpikeGenerator(g0, sgf);
+		}
+		sim->connect(g0, g1, "random", RangeWeight(0.01f), 0.1f);
+		sim->setConductances(true);
+		sim->setupNetwork();
+
+		PoissonRate poiss(GRP_SIZE);
+		SpikeMonitor* SM;
+		if (run==0) {
+			poiss.setRates(30.0f);
+			sim->setSpikeRate(g0, &poiss);
+			SM = sim->setSpikeMonitor(g0, fileName);
+			SM->setFileFormat(SPK_FILE_COMPACT, 64);
+			EXPECT_EQ(SM->getFileFormat(), SPK_FILE_COMPACT);
+		} else {
+			SM = sim->setSpikeMonitor(g0, "NULL");
+		}
+
+		SM->startRecording();
+		sim->runNetwork(2,0,false);
+		SM->stopRecording();
+		spkVec[run] = SM->getSpikeVector2D();
+
+		if (run==0) {
+			// format can no longer be changed once spikes have been written
+			EXPECT_DEATH(SM->setFileFormat(SPK_FILE_AER),"");
+
+			// compact file must be smaller than AER body (8 bytes per spike) plus header
+			FILE* fp = fopen(fileName.c_str(), "rb");
+			ASSERT_TRUE(fp!=NULL);
+			fseek(fp, 0, SEEK_END);
+			long fileSize = ftell(fp);
+			fclose(fp);
+			EXPECT_GT(SM->getPopNumSpikes(), 0);
+			EXPECT_LT(fileSize, 20 + 4L*SM->getPopNumSpikes());
+		}
+
+		delete sim;
+		if (sgf!=NULL)
+			delete sgf;
+	}
+
+	// the replayed spikes must be identical
+	ASSERT_EQ(spkVec[0].size(), spkVec[1].size());
+	for (int i=0; i<GRP_SIZE; i++) {
+		ASSERT_EQ(spkVec[0][i].size(), spkVec[1][i].size());
+		for (unsigned int j=0; j<spkVec[0][i].size(); j++)
+			EXPECT_EQ(spkVec[0][i][j], spkVec[1][i][j]);
+	}
+}
+
+/*!
+ * \brief testing the spike vector over several persistent recording periods
+ *
+ * This test records Poisson spikes in several recording periods that span multiple seconds, with persistent data
+ * turned on, and queries the SpikeMonitor in between. The final spike vector must contain the exact same spikes as the
+ * spike file, which receives every spike.
+ */
+TEST(SpikeMon, spikeVectorPersistent) {
+	const int GRP_SIZE = 500;
+	std::string fileName = "results/spk_persistent.dat";
+
+	CARLsim* sim = new CARLsim("SpikeMon.spikeVectorPersistent",CPU_MODE,SILENT,0,42);
+	int g1 = sim->createGroup("g1", 1, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02, 0.2, -65.0, 8.0);
+	int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE, EXCITATORY_NEURON);
+	sim->connect(g0, g1, "random", RangeWeight(0.01f), 0.1f);
+	sim->setConductances(true);
+	sim->setupNetwork();
+
+	PoissonRate poiss(GRP_SIZE);
+	poiss.setRates(40.0f);
+	sim->setSpikeRate(g0, &poiss);
+
+	SpikeMonitor* SM = sim->setSpikeMonitor(g0, fileName);
+	SM->setPersistentData(true);
+
+	int numSpikes = 0;
+	for (int i=0; i<4; i++) {
+		SM->startRecording();
+		sim->runNetwork(0,700,false);
+		SM->stopRecording();
+
+		// query in between: the spike counts must keep growing
+		EXPECT_GT(SM->getPopNumSpikes(), numSpikes);
+		numSpikes = SM->getPopNumSpikes();
+		int sumNeurSpikes = 0;
+		for (int neurId=0; neurId<GRP_SIZE; neurId++)
+			sumNeurSpikes += SM->getNeuronNumSpikes(neurId);
+		EXPECT_EQ(sumNeurSpikes, numSpikes);
+	}
+	EXPECT_EQ(SM->getRecordingTotalTime(), 2800);
+	std::vector<std::vector<int> > spkVec = SM->getSpikeVector2D();
+
+	// arrange the spike file by neuron ID
+	int* inputArray = NULL;
+	int64_t inputSize;
+	readAndReturnSpikeFile(fileName, inputArray, inputSize);
+	std::vector<std::vector<int> > fileVec(GRP_SIZE);
+	for (int64_t i=0; i<inputSize; i+=2)
+		fileVec[inputArray[i+1]].push_back(inputArray[i]);
+
+	EXPECT_EQ(inputSize/2, numSpikes);
+	ASSERT_EQ(spkVec.size(), GRP_SIZE);
+	for (int neurId=0; neurId<GRP_SIZE; neurId++) {
+		ASSERT_EQ(spkVec[neurId].size(), fileVec[neurId].size());
+		for (unsigned int j=0; j<spkVec[neurId].size(); j++)
+			EXPECT_EQ(spkVec[neurId][j], fileVec[neurId][j]);
+	}
+
+	if (inputArray!=NULL) delete[] inputArray;
+	delete sim;
+}
+
+/*!
+ * \brief testing COUNT mode
+ *
+ * This test runs the same network twice, once with a SpikeMonitor in AER mode and once in COUNT mode, and queries the
+ * firing rate metrics after every short run. Both modes must report the exact same numbers.
+ */
+TEST(SpikeMon, countMode) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	const int GRP_SIZE = 200;
+	const int NUM_RUNS = 20;
+	std::vector<float> stats[2];
+
+	for (int isCount=0; isCount<=1; isCount++) {
+		CARLsim* sim = new CARLsim("SpikeMon.countMode",CPU_MODE,SILENT,0,42);
+		int g1 = sim->createGroup("g1", 1, EXCITATORY_NEURON);
+		sim->setNeuronParameters(g1, 0.02, 0.2, -65.0, 8.0);
+		int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE, EXCITATORY_NEURON);
+		sim->connect(g0, g1, "random", RangeWeight(0.01f), 0.1f);
+		sim->setConductances(true);
+		sim->setupNetwork();
+
+		PoissonRate poiss(GRP_SIZE);
+		for (int i=0; i<GRP_SIZE; i++)
+			poiss.setRate(i, 0.2f*i);
+		sim->setSpikeRate(g0, &poiss);
+
+		SpikeMonitor* SM = sim->setSpikeMonitor(g0, "NULL");
+		SM->setMode(isCount ? COUNT : AER);
+		EXPECT_EQ(SM->getMode(), isCount ? COUNT : AER);
+		SM->setPersistentData(true);
+
+		for (int run=0; run<NUM_RUNS; run++) {
+			SM->startRecording();
+			sim->runNetwork(0,50,false);
+			SM->stopRecording();
+
+			stats[isCount].push_back(SM->getPopNumSpikes());
+			stats[isCount].push_back(SM->getPopMeanFiringRate());
+			stats[isCount].push_back(SM->getPopStdFiringRate());
+			stats[isCount].push_back(SM->getMaxFiringRate());
+			stats[isCount].push_back(SM->getMinFiringRate());
+			stats[isCount].push_back(SM->getNumNeuronsWithFiringRate(5.0f, 20.0f));
+			stats[isCount].push_back(SM->getNumSilentNeurons());
+			stats[isCount].push_back(SM->getNeuronNumSpikes(GRP_SIZE-1));
+		}
+
+		// summary statistics must match the per-neuron rates
+		std::vector<float> rates = SM->getAllFiringRatesSorted();
+		EXPECT_FLOAT_EQ(SM->getMaxFiringRate(), rates.back());
+		EXPECT_FLOAT_EQ(SM->getMinFiringRate(), rates.front());
+		int numInRange = 0;
+		for (int i=0; i<GRP_SIZE; i++)
+			numInRange += (rates[i]>=5.0f && rates[i]<=20.0f);
+		EXPECT_EQ(SM->getNumNeuronsWithFiringRate(5.0f, 20.0f), numInRange);
+
+		if (isCount) {
+			EXPECT_DEATH(SM->getSpikeVector2D(),"");
+
+			// changing the mode discards all data
+			SM->setMode(AER);
+			EXPECT_EQ(SM->getPopNumSpikes(), 0);
+		}
+
+		delete sim;
+	}
+
+	ASSERT_EQ(stats[0].size(), stats[1].size());
+	for (unsigned int i=0; i<stats[0].size(); i++)
+		EXPECT_FLOAT_EQ(stats[0][i], stats[1][i]);
+}
+
+/*!
+ * \brief testing WINDOW mode
+ * This test makes sure that the rolling window of a SpikeMonitor reports the rates of periodic input, that it can be
+ * queried at any time (also during recording), and that it forgets spikes that are older than the window.
+ */
+TEST(SpikeMon, windowMode) {
+	::testing::FLAGS_gtest_death_test_style = "threadsafe";
+
+	const int GRP_SIZE = 10;
+	CARLsim* sim = new CARLsim("SpikeMon.windowMode",CPU_MODE,SILENT,0,42);
+	int g1 = sim->createGroup("g1", 1, EXCITATORY_NEURON);
+	sim->setNeuronParameters(g1, 0.02, 0.2, -65.0, 8.0);
+	int g0 = sim->createSpikeGeneratorGroup("g0", GRP_SIZE, EXCITATORY_NEURON);
+	int g2 = sim->createSpikeGeneratorGroup("g2", GRP_SIZE, EXCITATORY_NEURON);
+	sim->connect(g0, g1, "full", RangeWeight(0.001f), 1.0f);
+	sim->connect(g2, g1, "full", RangeWeight(0.001f), 1.0f);
+	sim->setConductances(true);
+
+	PeriodicSpikeGenerator spkGen(true);
+	spkGen.setRates(20.0f);
+	sim->setSpikeGenerator(g0, &spkGen);
+	sim->setupNetwork();
+
+	PoissonRate poiss(GRP_SIZE);
+	poiss.setRates(50.0f);
+	sim->setSpikeRate(g2, &poiss);
+
+	SpikeMonitor* SM0 = sim->setSpikeMonitor(g0, "NULL");
+	SpikeMonitor* SM2 = sim->setSpikeMonitor(g2, "NULL");
+	EXPECT_DEATH(SM0->getWindowFiringRates(),"");
+	EXPECT_DEATH(SM0->setWindow(0, 100),"");
+	EXPECT_DEATH(SM0->setWindow(10, 0),"");
+
+	SM0->setWindow(10, 100);
+	SM2->setWindow(10, 100);
+	EXPECT_EQ(SM0->getMode(), WINDOW);
+
+	// empty window
+	EXPECT_EQ(SM0->getWindowPSTH().size(), 10);
+	EXPECT_FLOAT_EQ(SM0->getWindowPopMeanFiringRate(), 0.0f);
+	EXPECT_FLOAT_EQ(SM0->getWindowSynchrony(), 0.0f);
+
+	// the window can be queried during recording, and is independent of it
+	SM0->startRecording();
+	for (int t=0; t<20; t++) {
+		sim->runNetwork(0,50,false);
+		std::vector<float> psth = SM0->getWindowPSTH();
+		EXPECT_EQ(psth.size(), 10);
+		EXPECT_FLOAT_EQ(psth.back(), (t>0) ? 20.0f : 0.0f);
+	}
+	EXPECT_DEATH(SM0->setMode(COUNT),"");
+	std::vector<float> rates = SM0->getWindowFiringRates();
+	ASSERT_EQ(rates.size(), GRP_SIZE);
+	for (int i=0; i<GRP_SIZE; i++)
+		EXPECT_FLOAT_EQ(rates[i], 20.0f);
+	EXPECT_FLOAT_EQ(SM0->getWindowPopMeanFiringRate(), 20.0f);
+	SM0->stopRecording();
+	EXPECT_FLOAT_EQ(SM0->getPopMeanFiringRate(), 20.0f);
+	EXPECT_NEAR(SM2->getWindowPopMeanFiringRate(), 50.0f, 10.0f);
+
+	// periodic input is fully synchronous when the bins don't match the period
+	SM0->setWindow(20, 30);
+	sim->runNetwork(1,0,false);
+	EXPECT_FLOAT_EQ(SM0->getWindowSynchrony(), 1.0f);
+	EXPECT_LT(SM2->getWindowSynchrony(), 0.5f);
+
+	// old spikes are forgotten
+	for (int t=0; t<5; t++) {
+		poiss.setRates(0.0f);
+		sim->setSpikeRate(g2, &poiss);
+		sim->runNetwork(1,0,false);
+		EXPECT_FLOAT_EQ(SM2->getWindowPopMeanFiringRate(), 0.0f);
+		EXPECT_EQ(SM2->getWindowPSTH().size(), 10);
+	}
+
+	delete sim;
+}
@@ -603,6 +603,156 @@ TEST(STDP, ISTDPPulseCurve) {
 	}
 }
 
+/*!
+ * \brief testing the STDP lookup tables
+ * This function runs a network with E-STDP (exponential and timing-based curve) and I-STDP (exponential and pulse
+ * curve) once with and once without lookup tables. Since the tables hold the same values that would otherwise be
+ * computed on the fly, weights and spike times are expected to be identical.
+ */
+TEST(STDP, lookupTableVsExp) {
+	int nIn = 50, nExc = 50, nInh = 10;
+	float maxWt = 0.1f;
+
+	for (int curve=0; curve<2; curve++) {
+		std::vector<std::vector<float> > wtExc, wtInh;
+		std::vector<std::vector<int> > spkTimes;
+
+		for (int withLUT=1; withLUT>=0; withLUT--) {
+			CARLsim* sim = new CARLsim("STDP.lookupTableVsExp", CPU_MODE, SILENT, 0, 42);
+			sim->setSTDPLookupTable(withLUT);
+
+			int gIn = sim->createSpikeGeneratorGroup("input", nIn, EXCITATORY_NEURON);
+			int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			sim->connect(gIn, gExc, "full", RangeWeight(0.0f, 0.06f, maxWt), 1.0f, RangeDelay(1), RadiusRF(-1),
+				SYN_PLASTIC);
+			sim->connect(gIn, gInh, "full", RangeWeight(0.01f), 1.0f, RangeDelay(1));
+			sim->connect(gInh, gExc, "full", RangeWeight(0.0f, 0.02f, maxWt), 1.0f, RangeDelay(1), RadiusRF(-1),
+				SYN_PLASTIC);
+			sim->setConductances(true);
+
+			if (curve==0) {
+				sim->setESTDP(gExc, true, STANDARD, ExpCurve(2e-3f, 20.0f, -2.2e-3f, 40.0f));
+				sim->setISTDP(gExc, true, STANDARD, ExpCurve(-1e-3f, 10.0f, 1.2e-3f, 30.0f));
+			} else {
+				sim->setESTDP(gExc, true, STANDARD, TimingBasedCurve(2e-3f, 20.0f, -2.2e-3f, 40.0f, 10.0f));
+				sim->setISTDP(gExc, true, STANDARD, PulseCurve(1e-3f, -1.2e-3f, 10.0f, 20.0f));
+			}
+
+			sim->setupNetwork();
+
+			PoissonRate in(nIn);
+			in.setRates(30.0f);
+			sim->setSpikeRate(gIn, &in);
+
+			ConnectionMonitor* cmExc = sim->setConnectionMonitor(gIn, gExc, "NULL");
+			ConnectionMonitor* cmInh = sim->setConnectionMonitor(gInh, gExc, "NULL");
+			SpikeMonitor* spkMon = sim->setSpikeMonitor(gExc, "NULL");
+			spkMon->startRecording();
+			sim->runNetwork(2, 0);
+			spkMon->stopRecording();
+
+			if (withLUT) {
+				wtExc = cmExc->takeSnapshot();
+				wtInh = cmInh->takeSnapshot();
+				spkTimes = spkMon->getSpikeVector2D();
+				EXPECT_GT(spkMon->getPopMeanFiringRate(), 1.0f);
+			} else {
+				std::vector<std::vector<float> > wtExcNoLUT = cmExc->takeSnapshot();
+				std::vector<std::vector<float> > wtInhNoLUT = cmInh->takeSnapshot();
+				for (int i=0; i<nIn; i++) {
+					for (int j=0; j<nExc; j++) {
+						EXPECT_EQ(wtExcNoLUT[i][j], wtExc[i][j]);
+					}
+				}
+				for (int i=0; i<nInh; i++) {
+					for (int j=0; j<nExc; j++) {
+						EXPECT_EQ(wtInhNoLUT[i][j], wtInh[i][j]);
+					}
+				}
+				std::vector<std::vector<int> > spkTimesNoLUT = spkMon->getSpikeVector2D();
+				for (int i=0; i<nExc; i++) {
+					EXPECT_EQ(spkTimesNoLUT[i], spkTimes[i]);
+				}
+			}
+
+			delete sim;
+		}
+	}
+}
+
+/*!
+ * \brief testing the weight update in CPU_MODE_MT
+ * Every thread updates the weights of its own range of post-synaptic neurons with the same kernel as CPU_MODE, so
+ * weights (E-STDP with and without homeostasis, and I-STDP) and spike times are expected to be identical.
+ */
+TEST(STDP, updateWeightsCPUvsMT) {
+	int nIn = 50, nExc = 60, nInh = 20;
+
+	for (int withHomeo=0; withHomeo<=1; withHomeo++) {
+		std::vector<std::vector<float> > wtExc, wtInh;
+		std::vector<std::vector<int> > spkTimes;
+
+		for (int run=0; run<2; run++) {
+			CARLsim* sim = new CARLsim("STDP.updateWeightsCPUvsMT", run ? CPU_MODE_MT : CPU_MODE, SILENT, 0, 42);
+			if (run) {
+				sim->setNumThreads(3);
+			}
+
+			int gIn = sim->createSpikeGeneratorGroup("input", nIn, EXCITATORY_NEURON);
+			int gExc = sim->createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim->createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim->setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim->setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			sim->connect(gIn, gExc, "full", RangeWeight(0.0f, 0.06f, 0.1f), 1.0f, RangeDelay(1), RadiusRF(-1),
+				SYN_PLASTIC);
+			sim->connect(gIn, gInh, "full", RangeWeight(0.01f), 1.0f, RangeDelay(1));
+			sim->connect(gInh, gExc, "full", RangeWeight(0.0f, 0.02f, 0.1f), 1.0f, RangeDelay(1), RadiusRF(-1),
+				SYN_PLASTIC);
+			sim->setConductances(true);
+
+			sim->setESTDP(gExc, true, STANDARD, ExpCurve(2e-3f, 20.0f, -2.2e-3f, 40.0f));
+			sim->setISTDP(gExc, true, STANDARD, ExpCurve(-1e-3f, 10.0f, 1.2e-3f, 30.0f));
+			if (withHomeo) {
+				sim->setHomeostasis(gExc, true, 1.0f, 10.0f);
+				sim->setHomeoBaseFiringRate(gExc, 10.0f, 0.0f);
+			}
+			sim->setWeightAndWeightChangeUpdate(INTERVAL_10MS, true, 0.9f);
+
+			sim->setupNetwork();
+
+			PoissonRate in(nIn);
+			in.setRates(30.0f);
+			sim->setSpikeRate(gIn, &in);
+
+			ConnectionMonitor* cmExc = sim->setConnectionMonitor(gIn, gExc, "NULL");
+			ConnectionMonitor* cmInh = sim->setConnectionMonitor(gInh, gExc, "NULL");
+			SpikeMonitor* spkMon = sim->setSpikeMonitor(gExc, "NULL");
+			spkMon->startRecording();
+			sim->runNetwork(2, 0);
+			spkMon->stopRecording();
+
+			if (run==0) {
+				EXPECT_GT(cmExc->getTotalAbsWeightChange(), 0.0);
+				wtExc = cmExc->takeSnapshot();
+				wtInh = cmInh->takeSnapshot();
+				spkTimes = spkMon->getSpikeVector2D();
+				EXPECT_GT(spkMon->getPopMeanFiringRate(), 1.0f);
+			} else {
+				EXPECT_EQ(cmExc->takeSnapshot(), wtExc);
+				EXPECT_EQ(cmInh->takeSnapshot(), wtInh);
+				EXPECT_EQ(spkMon->getSpikeVector2D(), spkTimes);
+			}
+
+			delete sim;
+		}
+	}
+}
+
 TEST(STDP, setHomeoBaseFiringRate) {
 	::testing::FLAGS_gtest_death_test_style = "threadsafe";
 
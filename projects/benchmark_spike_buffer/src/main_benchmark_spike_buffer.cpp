@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2016 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Microbenchmark for PropagatedSpikeBuffer, the buffer that holds the spikes of the spike generator groups until they
+// are due.
+//
+// The workload mimics CpuSNN::generateSpikesFromRate: every timeSlice ms, the Poisson spike times of all neurons in the
+// next timeSlice ms are scheduled (in order of neuron ID, so consecutive spikes go to different slots), and every ms
+// the spikes that are due are read back, as in CpuSNN::generateSpikes. The same workload is run once with
+// PropagatedSpikeBuffer (one contiguous array per time step) and once with a copy of its previous implementation
+// (LinkedListSpikeBuffer, one linked list of pooled nodes per time step).
+//
+// Usage: ./benchmark_spike_buffer [numNeurons] [rateHz] [runTimeMs] [timeSlice]
+
+#include <propagated_spike_buffer.h>
+#include <stopwatch.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+// length of the ring buffer, same as PROPAGATED_BUFFER_SIZE in CpuSNN
+#define BENCHMARK_BUFFER_SIZE 1023
+
+// The previous implementation of PropagatedSpikeBuffer (imported from PCSIM), stripped down to what the benchmark needs
+class LinkedListSpikeBuffer {
+public:
+	struct StgNode {
+		spikegroupid_t stg;
+		delaystep_t delay;
+		StgNode *next;
+	};
+
+	LinkedListSpikeBuffer(int maxDelay, int chunkSize) : currIdx(0), ringBufferFront(maxDelay+1, NULL),
+		ringBufferBack(maxDelay+1, NULL), nextFreeSrgNodeIdx(0), nextFreeChunkIdx(1), recycledNodes(NULL),
+		chunkSize(chunkSize)
+	{
+		chunkBuffer.push_back(new StgNode[chunkSize]);
+		currentFreeChunk = chunkBuffer[0];
+	}
+
+	~LinkedListSpikeBuffer() {
+		for (size_t i=0; i<chunkBuffer.size(); i++)
+			delete[] chunkBuffer[i];
+	}
+
+	void scheduleSpikeTargetGroup(spikegroupid_t stg, delaystep_t delay) {
+		StgNode *n = getFreeNode();
+		int writeIdx = (currIdx + delay) % ringBufferFront.size();
+		n->stg = stg;
+		n->delay = delay;
+		n->next = NULL;
+		if (ringBufferFront[writeIdx] == NULL) {
+			ringBufferBack[writeIdx] = ringBufferFront[writeIdx] = n;
+		} else {
+			ringBufferBack[writeIdx]->next = n;
+			ringBufferBack[writeIdx] = n;
+		}
+	}
+
+	StgNode* front() { return ringBufferFront[currIdx]; }
+
+	void nextTimeStep() {
+		if (ringBufferFront[currIdx] != NULL) {
+			ringBufferBack[currIdx]->next = recycledNodes;
+			recycledNodes = ringBufferFront[currIdx];
+		}
+		ringBufferBack[currIdx] = ringBufferFront[currIdx] = NULL;
+		currIdx = (currIdx + 1) % ringBufferFront.size();
+	}
+
+private:
+	StgNode* getFreeNode() {
+		StgNode *n;
+		if (recycledNodes != NULL) {
+			n = recycledNodes;
+			recycledNodes = recycledNodes->next;
+		} else if (nextFreeSrgNodeIdx < chunkSize) {
+			n = &(currentFreeChunk[nextFreeSrgNodeIdx++]);
+		} else if (nextFreeChunkIdx < chunkBuffer.size()) {
+			currentFreeChunk = chunkBuffer[nextFreeChunkIdx++];
+			n = &(currentFreeChunk[0]);
+			nextFreeSrgNodeIdx = 1;
+		} else {
+			currentFreeChunk = new StgNode[chunkSize];
+			chunkBuffer.push_back(currentFreeChunk);
+			nextFreeChunkIdx++;
+			n = &(currentFreeChunk[0]);
+			nextFreeSrgNodeIdx = 1;
+		}
+		return n;
+	}
+
+	int currIdx;
+	std::vector<StgNode*> ringBufferFront;
+	std::vector<StgNode*> ringBufferBack;
+	std::vector<StgNode*> chunkBuffer;
+	StgNode *currentFreeChunk;
+	int nextFreeSrgNodeIdx;
+	size_t nextFreeChunkIdx;
+	StgNode* recycledNodes;
+	int chunkSize;
+};
+
+// schedules the Poisson spikes of all neurons in [currTime, currTime+timeSlice), the same way as
+// CpuSNN::generateSpikesFromRate does (without the refractory period)
+template<typename Buffer>
+int scheduleSpikes(Buffer& buf, int numNeurons, float rateHz, int currTime, int timeSlice,
+	std::vector<unsigned int>& nextSpikeTime, unsigned int& randState)
+{
+	int numScheduled = 0;
+	for (int i=0; i<numNeurons; i++) {
+		while ((int)nextSpikeTime[i] < currTime+timeSlice) {
+			buf.scheduleSpikeTargetGroup(i, nextSpikeTime[i]-currTime);
+			numScheduled++;
+
+			// exponentially distributed inter-spike interval of at least 1 ms
+			randState = randState*1664525u + 1013904223u;
+			float u = (randState>>8) * (1.0f/16777216.0f);
+			nextSpikeTime[i] += 1 + (unsigned int)(-logf(1.0f-u) * 1000.0f / rateHz);
+		}
+	}
+	return numScheduled;
+}
+
+// reads back the spikes that are due now, the same way as CpuSNN::generateSpikes does
+long long readSpikes(PropagatedSpikeBuffer& buf) {
+	long long sum = 0;
+	PropagatedSpikeBuffer::const_iterator it_end = buf.endSpikeTargetGroups();
+	for (PropagatedSpikeBuffer::const_iterator it = buf.beginSpikeTargetGroups(); it != it_end; ++it)
+		sum += it->stg;
+	buf.nextTimeStep();
+	return sum;
+}
+
+long long readSpikes(LinkedListSpikeBuffer& buf) {
+	long long sum = 0;
+	for (LinkedListSpikeBuffer::StgNode* n = buf.front(); n != NULL; n = n->next)
+		sum += n->stg;
+	buf.nextTimeStep();
+	return sum;
+}
+
+// runs the workload, returns the time in ms and the checksum of all spikes read back
+template<typename Buffer>
+uint64_t runBenchmark(Buffer& buf, int numNeurons, float rateHz, int runTimeMs, int timeSlice, long long& checksum,
+	long long& numSpikes)
+{
+	std::vector<unsigned int> nextSpikeTime(numNeurons, 0);
+	unsigned int randState = 42;
+	checksum = 0;
+	numSpikes = 0;
+
+	Stopwatch watch(false);
+	watch.start();
+	for (int t=0; t<runTimeMs; t++) {
+		if (t % timeSlice == 0)
+			numSpikes += scheduleSpikes(buf, numNeurons, rateHz, t, timeSlice, nextSpikeTime, randState);
+		checksum += readSpikes(buf);
+	}
+	return watch.stop(false);
+}
+
+int main(int argc, char* argv[]) {
+	int numNeurons = (argc > 1) ? atoi(argv[1]) : 100000;
+	float rateHz = (argc > 2) ? atof(argv[2]) : 20.0f;
+	int runTimeMs = (argc > 3) ? atoi(argv[3]) : 10000;
+	int timeSlice = (argc > 4) ? atoi(argv[4]) : 1000;
+	if (timeSlice < 1 || timeSlice >= BENCHMARK_BUFFER_SIZE) {
+		printf("timeSlice must be in [1,%d)\n", BENCHMARK_BUFFER_SIZE);
+		return 1;
+	}
+
+	printf("%d neurons, %.1f Hz, %d ms, time slice %d ms\n", numNeurons, rateHz, runTimeMs, timeSlice);
+	printf("%-12s %12s %14s %16s\n", "buffer", "time (ms)", "ns/spike", "checksum");
+
+	for (int isLinkedList=0; isLinkedList<=1; isLinkedList++) {
+		long long checksum, numSpikes;
+		uint64_t timeMs;
+		if (isLinkedList) {
+			LinkedListSpikeBuffer buf(BENCHMARK_BUFFER_SIZE, PROPAGATED_SPIKE_BUFFER_CHUNK_SIZE);
+			timeMs = runBenchmark(buf, numNeurons, rateHz, runTimeMs, timeSlice, checksum, numSpikes);
+		} else {
+			PropagatedSpikeBuffer buf(0, BENCHMARK_BUFFER_SIZE);
+			timeMs = runBenchmark(buf, numNeurons, rateHz, runTimeMs, timeSlice, checksum, numSpikes);
+		}
+
+		double nsPerSpike = (numSpikes > 0) ? timeMs * 1.0e6 / numSpikes : 0.0;
+		printf("%-12s %12llu %14.2f %16lld\n", isLinkedList ? "linked list" : "contiguous", (unsigned long long)timeMs,
+			nsPerSpike, checksum);
+	}
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Benchmark for spike delivery in CPU_MODE.
+//
+// An input group drives a network of excitatory and inhibitory neurons through random connections with
+// delays of 1-20 ms, so that most of the simulation time goes into delivering spikes to their post-synaptic targets.
+// The network is run with the push engine (which delivers from a delay-sorted copy of the synapses, see
+// CpuSNN::reorganizeDelivery) and the pull engine, both with fixed synapses and with STDP on the input connections.
+// With STDP, the weights are updated every 10 ms, after which the push engine has to refresh its copy of the plastic
+// weights.
+//
+// Usage: ./benchmark_spike_delivery [connProb] [runTimeMs]
+
+// include CARLsim user interface
+#include <carlsim.h>
+#include <stopwatch.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+int main(int argc, char* argv[]) {
+	float connProb = (argc > 1) ? atof(argv[1]) : 0.1f;
+	int runTimeMs = (argc > 2) ? atoi(argv[2]) : 5000;
+	int nInput = 1000, nExc = 800, nInh = 200;
+
+	printf("%d input, %d exc, %d inh neurons, p=%.2f, %d ms, COBA\n", nInput, nExc, nInh, connProb, runTimeMs);
+	printf("%-8s %-8s %12s %14s\n", "engine", "synapses", "time (ms)", "spikes (exc)");
+
+	for (int isPlastic=0; isPlastic<=1; isPlastic++) {
+		for (int isPull=0; isPull<=1; isPull++) {
+			CARLsim sim("benchmark_spike_delivery", CPU_MODE, SILENT, 0, 42);
+			sim.setSpikePropagation(isPull ? PULL_PROPAGATION : PUSH_PROPAGATION);
+
+			int gIn = sim.createSpikeGeneratorGroup("input", nInput, EXCITATORY_NEURON);
+			int gExc = sim.createGroup("exc", nExc, EXCITATORY_NEURON);
+			int gInh = sim.createGroup("inh", nInh, INHIBITORY_NEURON);
+			sim.setNeuronParameters(gExc, 0.02f, 0.2f, -65.0f, 8.0f); // RS
+			sim.setNeuronParameters(gInh, 0.1f, 0.2f, -65.0f, 2.0f); // FS
+
+			// scale the weights with the number of synapses, so that the firing rates stay about the same
+			float wtScale = 0.1f / connProb;
+			if (isPlastic) {
+				sim.connect(gIn, gExc, "random", RangeWeight(0.0f, 0.14f*wtScale, 0.28f*wtScale), connProb,
+					RangeDelay(1,20), RadiusRF(-1), SYN_PLASTIC);
+				sim.setESTDP(gExc, true, STANDARD, ExpCurve(0.001f*wtScale, 20.0f, -0.0012f*wtScale, 20.0f));
+				sim.setWeightAndWeightChangeUpdate(INTERVAL_10MS, true, 0.9f);
+			} else {
+				sim.connect(gIn, gExc, "random", RangeWeight(0.14f*wtScale), connProb, RangeDelay(1,20));
+			}
+			sim.connect(gIn, gInh, "random", RangeWeight(0.01f*wtScale), connProb, RangeDelay(1,20));
+			sim.connect(gExc, gInh, "random", RangeWeight(0.02f*wtScale), connProb, RangeDelay(1,20));
+			sim.connect(gInh, gExc, "random", RangeWeight(0.05f*wtScale), connProb, RangeDelay(1));
+			sim.setConductances(true);
+			sim.setupNetwork();
+
+			PoissonRate in(nInput);
+			in.setRates(10.0f);
+			sim.setSpikeRate(gIn, &in);
+
+			SpikeMonitor* spkMon = sim.setSpikeMonitor(gExc, "NULL");
+			spkMon->startRecording();
+
+			Stopwatch watch;
+			sim.runNetwork(runTimeMs/1000, runTimeMs%1000);
+			uint64_t timeMs = watch.stop(false);
+
+			spkMon->stopRecording();
+			printf("%-8s %-8s %12llu %14d\n", isPull ? "pull" : "push", isPlastic ? "plastic" : "fixed",
+				(unsigned long long)timeMs, spkMon->getPopNumSpikes());
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Benchmark for CpuSNN::updateSpikeMonitor with many SpikeMonitors.
+//
+// The network consists of numGroups Poisson groups, which all project sparsely to a small output group. The same
+// network is run with SpikeMonitors on 0, 1, 10, ..., numGroups of the input groups (recording spike times, no spike
+// file). Since updateSpikeMonitor serves all monitors with a single pass through the firing table, the extra time
+// spent per recorded spike should not grow with the number of monitors.
+//
+// Usage: ./benchmark_spike_monitor [numGroups] [neurPerGroup] [rateHz] [runTimeMs]
+// (numGroups must be smaller than MAX_GRP_PER_SNN)
+
+// include CARLsim user interface
+#include <carlsim.h>
+#include <stopwatch.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+int main(int argc, char* argv[]) {
+	int numGroups = (argc > 1) ? atoi(argv[1]) : 50;
+	int neurPerGroup = (argc > 2) ? atoi(argv[2]) : 1000;
+	float rateHz = (argc > 3) ? atof(argv[3]) : 20.0f;
+	int runTimeMs = (argc > 4) ? atoi(argv[4]) : 10000;
+
+	// number of monitored groups per run
+	std::vector<int> numMonitors;
+	for (int m=0; m<numGroups; m = (m==0) ? 1 : m*10)
+		numMonitors.push_back(m);
+	numMonitors.push_back(numGroups);
+
+	printf("%d groups x %d neurons, %.1f Hz, %d ms\n", numGroups, neurPerGroup, rateHz, runTimeMs);
+	printf("%-10s %12s %14s %18s\n", "monitors", "time (ms)", "spikes", "overhead ns/spike");
+
+	uint64_t baseTimeMs = 0;
+	for (unsigned int i=0; i<numMonitors.size(); i++) {
+		CARLsim sim("benchmark_spike_monitor", CPU_MODE, SILENT, 0, 42);
+
+		std::vector<int> gIn(numGroups);
+		int gOut = sim.createGroup("output", 100, EXCITATORY_NEURON);
+		sim.setNeuronParameters(gOut, 0.02f, 0.2f, -65.0f, 8.0f);
+		for (int g=0; g<numGroups; g++) {
+			gIn[g] = sim.createSpikeGeneratorGroup("input", neurPerGroup, EXCITATORY_NEURON);
+			sim.connect(gIn[g], gOut, "random", RangeWeight(0.001f), 0.05f);
+		}
+		sim.setConductances(true);
+		sim.setupNetwork();
+
+		std::vector<PoissonRate*> in(numGroups);
+		std::vector<SpikeMonitor*> SM(numMonitors[i]);
+		for (int g=0; g<numGroups; g++) {
+			in[g] = new PoissonRate(neurPerGroup);
+			in[g]->setRates(rateHz);
+			sim.setSpikeRate(gIn[g], in[g]);
+			if (g < numMonitors[i]) {
+				SM[g] = sim.setSpikeMonitor(gIn[g], "NULL");
+				SM[g]->startRecording();
+			}
+		}
+
+		Stopwatch watch;
+		sim.runNetwork(runTimeMs/1000, runTimeMs%1000);
+		uint64_t timeMs = watch.stop(false);
+
+		long long numSpikes = 0;
+		for (int g=0; g<numMonitors[i]; g++) {
+			SM[g]->stopRecording();
+			numSpikes += SM[g]->getPopNumSpikes();
+		}
+
+		// extra time compared to the run without monitors, per recorded spike
+		if (numMonitors[i]==0)
+			baseTimeMs = timeMs;
+		double nsPerSpike = (numSpikes > 0) ? ((double)timeMs - baseTimeMs) * 1.0e6 / numSpikes : 0.0;
+		printf("%-10d %12llu %14lld %18.2f\n", numMonitors[i], (unsigned long long)timeMs, numSpikes, nsPerSpike);
+
+		for (int g=0; g<numGroups; g++)
+			delete in[g];
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2016 Regents of the University of California. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. The names of its contributors may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Benchmark for the fused state update (CARLsim::setFusedStateUpdate).
+//
+// A large group of neurons receives sparse Poisson input, so that the time spent on spike delivery is small compared
+// to the per-neuron work of globalStateDecay and globalStateUpdate. The network is run once with the default state
+// update and once with the fused state update.
+//
+// For both versions, the program prints the number of bytes that the decay and update sweeps move per neuron per ms,
+// counting every read and every write of a per-neuron float array once (writes to a block that was just read are
+// assumed to hit the cache in the fused version), and the resulting effective memory bandwidth. Since the measured
+// time includes everything else that runNetwork does (e.g., generating the Poisson spikes), the bandwidth is a lower
+// bound.
+//
+// Usage: ./benchmark_state_update [numNeurons] [runTimeMs] [isCOBA]
+
+// include CARLsim user interface
+#include <carlsim.h>
+#include <stopwatch.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+// number of bytes moved per neuron per ms by globalStateDecay and globalStateUpdate
+int bytesPerNeuronPerMs(bool isCOBA, bool isFused) {
+	int numCond = isCOBA ? 4 : 1; // gAMPA, gNMDA, gGABAa, gGABAb or current
+	int numStateRead = 1 + 4 + 2; // extCurrent, Izhikevich a-d, voltage and recovery
+	int numStateWrite = 2; // nextVoltage and recovery
+
+	// decay: COBA reads and writes every conductance, CUBA zeroes the current
+	int decay;
+	if (isFused) {
+		decay = numCond; // the conductances are still in the cache from the update
+	} else {
+		decay = isCOBA ? 2*numCond : numCond;
+	}
+	int update = numCond + numStateRead + numStateWrite;
+
+	return (decay + update) * sizeof(float);
+}
+
+int main(int argc, char* argv[]) {
+	int numNeurons = (argc > 1) ? atoi(argv[1]) : 500000;
+	int runTimeMs = (argc > 2) ? atoi(argv[2]) : 1000;
+	bool isCOBA = (argc > 3) ? atoi(argv[3]) != 0 : true;
+
+	printf("%d neurons, %d ms, %s\n", numNeurons, runTimeMs, isCOBA ? "COBA" : "CUBA");
+	printf("%-8s %12s %14s %16s\n", "update", "time (ms)", "bytes/neur/ms", "bandwidth (GB/s)");
+
+	for (int isFused=0; isFused<=1; isFused++) {
+		CARLsim sim("benchmark_state_update", CPU_MODE, SILENT, 0, 42);
+		sim.setFusedStateUpdate(isFused);
+
+		int gIn = sim.createSpikeGeneratorGroup("input", numNeurons, EXCITATORY_NEURON);
+		int gOut = sim.createGroup("output", numNeurons, EXCITATORY_NEURON);
+		sim.setNeuronParameters(gOut, 0.02f, 0.2f, -65.0f, 8.0f);
+		sim.connect(gIn, gOut, "one-to-one", RangeWeight(isCOBA ? 0.5f : 50.0f), 1.0f, RangeDelay(1));
+		sim.setConductances(isCOBA);
+		sim.setupNetwork();
+
+		PoissonRate in(numNeurons);
+		in.setRates(1.0f);
+		sim.setSpikeRate(gIn, &in);
+
+		Stopwatch watch;
+		sim.runNetwork(runTimeMs/1000, runTimeMs%1000);
+		uint64_t timeMs = watch.stop(false);
+
+		int bytes = bytesPerNeuronPerMs(isCOBA, isFused);
+		double bandwidth = (timeMs > 0) ? (double)bytes * numNeurons * runTimeMs / (timeMs * 1.0e6) : 0.0;
+		printf("%-8s %12llu %14d %16.2f\n", isFused ? "fused" : "default", (unsigned long long)timeMs, bytes,
+			bandwidth);
+	}
+
+	return 0;
+}
@@ -49,6 +49,19 @@ classdef ConnectionReader < handle
         nNeurPost;
         nSynapses;
         isPlastic;
+
+        isSparse;              % whether snapshots only contain existing synapses (version >= 0.4)
+        sparseIdx;             % index of every stored synapse in the weight vector
+
+        isDelta;               % whether snapshots are delta-encoded (version >= 0.5)
+        keyframeInterval;      % number of snapshots between two keyframes
+        wtResolution;          % resolution of weight changes
+        frameOffsets;          % byte offset of the payload of every snapshot
+        frameSizes;            % byte size of the payload of every snapshot
+        frameTypes;            % type of every snapshot (0=keyframe, 1=delta)
+        frameTimes;            % time stamp of every snapshot
+        cachedFrame;           % last decoded snapshot
+        cachedWts;             % weights of the last decoded snapshot
         
         errorFlag;           % error flag (true if error occured)
         errorMsg;            % error message
@@ -171,6 +184,11 @@ classdef ConnectionReader < handle
             %               For example, the get first and third frame,
             %               use snapShots=[0, 2]. Set snapShots to -1
             %               in order to get all available frames.
+            %
+            % Non-existent synapses are NaN (file version >= 0.4). In
+            % delta-encoded files (version 0.5), weights are accurate to
+            % half the weight resolution, and reading snapshots in
+            % ascending order is fastest.
             if nargin<2 || isempty(snapShots) || snapShots==-1
                 snapShots = 1:obj.nSnapshots;
             end
@@ -186,6 +204,20 @@ classdef ConnectionReader < handle
             for i=1:numel(snapShots)
                 frame = snapShots(i);
 
+                if obj.isDelta
+                    % decode from the last keyframe (or cached snapshot)
+                    if frame>obj.nSnapshots
+                        obj.throwError(['Snapshot ' num2str(frame) ...
+                            ' does not exist.'])
+                        return
+                    end
+                    wt = nan(1, obj.nNeurPre*obj.nNeurPost);
+                    wt(obj.sparseIdx) = obj.readDeltaFrame(frame);
+                    obj.timeStamps = [obj.timeStamps obj.frameTimes(frame)];
+                    obj.weights(end+1,:) = wt;
+                    continue
+                end
+
                 % rewind file pointer, skip header
                 fseek(obj.fileId, obj.fileSizeByteHeader, 'bof');
                 
@@ -201,7 +233,14 @@ classdef ConnectionReader < handle
                 
                 % read data and append  to member
                 obj.timeStamps = [obj.timeStamps fread(obj.fileId, 1, 'int64')];
-                obj.weights(end+1,:) = fread(obj.fileId, obj.nNeurPre*obj.nNeurPost, 'float32');
+                if obj.isSparse
+                    % non-existent synapses are NaN
+                    wt = nan(1, obj.nNeurPre*obj.nNeurPost);
+                    wt(obj.sparseIdx) = fread(obj.fileId, obj.nSynapses, 'float32');
+                    obj.weights(end+1,:) = wt;
+                else
+                    obj.weights(end+1,:) = fread(obj.fileId, obj.nNeurPre*obj.nNeurPost, 'float32');
+                end
             end
             timeStamps = obj.timeStamps;
             weights = obj.weights;
@@ -233,6 +272,17 @@ classdef ConnectionReader < handle
             obj.nNeurPost = -1;
             obj.nSynapses = -1;
             obj.isPlastic = false;
+            obj.isSparse = false;
+            obj.sparseIdx = [];
+            obj.isDelta = false;
+            obj.keyframeInterval = -1;
+            obj.wtResolution = -1;
+            obj.frameOffsets = [];
+            obj.frameSizes = [];
+            obj.frameTypes = [];
+            obj.frameTimes = [];
+            obj.cachedFrame = -1;
+            obj.cachedWts = [];
             obj.nSnapshots = -1;
             
             obj.supportedErrorModes = {'standard', 'warning', 'silent'};
@@ -346,13 +396,56 @@ classdef ConnectionReader < handle
                         num2str(obj.maxWt) ')'])
             end
             
+            % version 0.4 and up: synapses in CSR layout, ordered by
+            % post-neurons (nNeurPost+1 row pointers, followed by the
+            % pre-neuron ID of every synapse)
+            obj.isSparse = floor((version-obj.fileVersionMajor)*10.01)>=4;
+            if obj.isSparse
+                synPtr = fread(obj.fileId, obj.nNeurPost+1, 'int32');
+                preIds = fread(obj.fileId, obj.nSynapses, 'int32');
+                if feof(obj.fileId) || synPtr(end)~=obj.nSynapses
+                    obj.throwError('Could not read synapses in CSR layout.')
+                    return
+                end
+                postIds = zeros(obj.nSynapses,1);
+                for j=1:obj.nNeurPost
+                    postIds(synPtr(j)+1:synPtr(j+1)) = j-1;
+                end
+                
+                % position in the weight vector, ordered by pre-neurons
+                % then post-neurons
+                obj.sparseIdx = preIds*obj.nNeurPost + postIds + 1;
+            end
+            
+            % version 0.5 and up: delta-encoded snapshots
+            obj.isDelta = floor((version-obj.fileVersionMajor)*10.01)>=5;
+            if obj.isDelta
+                obj.keyframeInterval = fread(obj.fileId, 1, 'int32');
+                obj.wtResolution = fread(obj.fileId, 1, 'float32=>single');
+                if feof(obj.fileId) || obj.wtResolution<=0
+                    obj.throwError(['Could not find valid weight ' ...
+                        'resolution (' num2str(obj.wtResolution) ')'])
+                    return
+                end
+            end
+            
             % store the size of the header section, so that we can skip it
             % when re-reading spikes
             obj.fileSizeByteHeader = ftell(obj.fileId);
             
+            if obj.isDelta
+                % snapshots have different sizes: find them all
+                obj.indexFrames();
+                return
+            end
+            
             % find size of each snapshot: #weights * sizeof(float32) +
             % sizeof(long int)
-            obj.fileSizeByteSnapshot = obj.nNeurPre*obj.nNeurPost*4+8;
+            if obj.isSparse
+                obj.fileSizeByteSnapshot = obj.nSynapses*4+8;
+            else
+                obj.fileSizeByteSnapshot = obj.nNeurPre*obj.nNeurPost*4+8;
+            end
 
             % compute number of snapshots present in the file
             % find byte size from here on until end of file, divide it by
@@ -363,6 +456,87 @@ classdef ConnectionReader < handle
                 / obj.fileSizeByteSnapshot );
         end
         
+        function indexFrames(obj)
+            % CR.indexFrames() finds the position, size, type, and time
+            % stamp of every snapshot in a delta-encoded file. Every
+            % snapshot starts with time stamp (int64), type (uint8), and
+            % byte size of the payload (int32).
+            fseek(obj.fileId, 0, 'eof');
+            szByteTot = ftell(obj.fileId);
+            fseek(obj.fileId, obj.fileSizeByteHeader, 'bof');
+            
+            obj.frameOffsets = [];
+            obj.frameSizes = [];
+            obj.frameTypes = [];
+            obj.frameTimes = [];
+            while true
+                timeStamp = fread(obj.fileId, 1, 'int64');
+                frameType = fread(obj.fileId, 1, 'uint8');
+                frameSize = fread(obj.fileId, 1, 'int32');
+                if isempty(frameSize) || ftell(obj.fileId)+frameSize>szByteTot
+                    % end of file (or incomplete snapshot)
+                    break
+                end
+                obj.frameOffsets(end+1) = ftell(obj.fileId);
+                obj.frameSizes(end+1) = frameSize;
+                obj.frameTypes(end+1) = frameType;
+                obj.frameTimes(end+1) = timeStamp;
+                fseek(obj.fileId, frameSize, 'cof');
+            end
+            obj.nSnapshots = numel(obj.frameTimes);
+        end
+        
+        function wts = readDeltaFrame(obj, frame)
+            % wts = CR.readDeltaFrame(frame) returns the weights of all
+            % synapses (in file order) of a snapshot in a delta-encoded
+            % file, starting at the last keyframe before the snapshot.
+            first = find(obj.frameTypes(1:frame)==0, 1, 'last');
+            if isempty(first)
+                obj.throwError(['Could not find keyframe for snapshot ' ...
+                    num2str(frame)])
+                return
+            end
+            if obj.cachedFrame>=first && obj.cachedFrame<=frame
+                % continue from the last decoded snapshot
+                wts = obj.cachedWts;
+                first = obj.cachedFrame+1;
+            end
+            
+            for f=first:frame
+                fseek(obj.fileId, obj.frameOffsets(f), 'bof');
+                if obj.frameTypes(f)==0
+                    wts = fread(obj.fileId, obj.nSynapses, 'float32=>single');
+                else
+                    % pairs of varints: index gap (starting at -1), and
+                    % zig-zag encoded weight change
+                    vals = obj.decodeVarints(fread(obj.fileId, ...
+                        obj.frameSizes(f), 'uint8=>double'));
+                    idx = cumsum(vals(1:2:end));
+                    z = vals(2:2:end);
+                    q = (mod(z,2)==0).*z/2 - (mod(z,2)==1).*(z+1)/2;
+                    wts(idx) = wts(idx) + single(q)*obj.wtResolution;
+                end
+            end
+            obj.cachedFrame = frame;
+            obj.cachedWts = wts;
+        end
+        
+        function vals = decodeVarints(~, bytes)
+            % vals = CR.decodeVarints(bytes) decodes a vector of unsigned
+            % varints (7 bits per byte, high bit set on all but the last
+            % byte of every number)
+            vals = zeros(0,1);
+            if isempty(bytes)
+                return
+            end
+            bytes = bytes(:);
+            isLast = bytes<128;
+            numId = cumsum([1; isLast(1:end-1)]);
+            firstByte = [1; find(isLast(1:end-1))+1];
+            bytePos = (1:numel(bytes))' - firstByte(numId);
+            vals = accumarray(numId, mod(bytes,128).*128.^bytePos);
+        end
+        
         function throwError(obj, errorMsg, errorMode)
             % SR.throwError(errorMsg, errorMode) throws an error with a
             % specific severity (errorMode). In all cases, obj.errorFlag is
@@ -31,6 +31,7 @@ classdef SpikeReader < handle
         fileSignature;       % int signature of all spike files
         fileVersionMajor;    % required major version number
         fileVersionMinor;    % required minimum minor version number
+        fileVersion;         % version number of the spike file
         fileSizeByteHeader;  % byte size of header section
         
         grid3D;              % 3D grid dimensions of group
@@ -142,8 +143,28 @@ classdef SpikeReader < handle
             %
             % The total simulation duration is usually stored in a
             % "sim_{simName}.dat" file and can be retrieved by using a
-            fseek(obj.fileId, -8, 'eof'); % jump to penultimate int
-            simDurMs = fread(obj.fileId, 1, 'int32');
+            if obj.isCompactFormat()
+                % skip to the last block and decode its last spike time
+                fseek(obj.fileId, obj.fileSizeByteHeader, 'bof');
+                simDurMs = 0;
+                lastBlockPos = -1;
+                while true
+                    blockPos = ftell(obj.fileId);
+                    hdr = fread(obj.fileId, 2, 'int32');
+                    if numel(hdr)<2 || fseek(obj.fileId, hdr(2), 'cof')
+                        break
+                    end
+                    lastBlockPos = blockPos;
+                end
+                if lastBlockPos>=0
+                    fseek(obj.fileId, lastBlockPos, 'bof');
+                    d = obj.readCompactBlock();
+                    simDurMs = d(1,end);
+                end
+            else
+                fseek(obj.fileId, -8, 'eof'); % jump to penultimate int
+                simDurMs = fread(obj.fileId, 1, 'int32');
+            end
         end
         
         function spk = readSpikes(obj, binWindowMs)
@@ -179,11 +200,19 @@ classdef SpikeReader < handle
             d=zeros(0,nrRead);
             spk=[];
             
-            while size(d,2)==nrRead
+            done = false;
+            while ~done
                 % D is a 2xNRREAD matrix.  Row 1 contains the times that
                 % the neuron spiked. Row 2 contains the neuron id that
                 % spiked at this corresponding time.
-                d = fread(obj.fileId, [2 nrRead], 'int32');
+                if obj.isCompactFormat()
+                    % compact files are read one block at a time
+                    d = obj.readCompactBlock();
+                    done = isempty(d);
+                else
+                    d = fread(obj.fileId, [2 nrRead], 'int32');
+                    done = size(d,2)<nrRead;
+                end
 
                 if ~isempty(d)
                     if obj.binWindow<0
@@ -237,6 +266,43 @@ classdef SpikeReader < handle
     
     %% PRIVATE METHODS
     methods (Hidden, Access = private)
+        function isCompact = isCompactFormat(obj)
+            % spike files of version 0.3 and up are written in the compact
+            % format (see SpikeMonitor::setFileFormat)
+            isCompact = obj.fileVersion > 0.25;
+        end
+        
+        function d = readCompactBlock(obj)
+            % d = SR.readCompactBlock() reads the next block of a compact
+            % spike file and returns its spikes in AER format [times;nIDs].
+            % A block consists of two int32 (number of spikes, number of
+            % bytes), followed by zig-zag encoded time differences and
+            % neuron IDs, stored as variable-length integers (7 bits per
+            % byte, least significant group first).
+            d = zeros(2,0);
+            hdr = fread(obj.fileId, 2, 'int32');
+            if numel(hdr)<2 || hdr(1)==0
+                return
+            end
+            bytes = fread(obj.fileId, [1 hdr(2)], 'uint8=>double');
+            
+            % every varint ends with a byte < 128
+            isLast = bytes<128;
+            varId = cumsum([1 isLast(1:end-1)]);
+            varStart = [1 find(isLast(1:end-1))+1];
+            shift = 7*((1:numel(bytes)) - varStart(varId));
+            vals = accumarray(varId', (mod(bytes,128).*2.^shift)')';
+            vals = reshape(vals, 2, hdr(1));
+            
+            % undo zig-zag encoding, time differences are relative to the
+            % previous spike in the block (the first one relative to 0)
+            zig = vals(1,:);
+            isNeg = mod(zig,2)==1;
+            delta = zig/2;
+            delta(isNeg) = -(zig(isNeg)+1)/2;
+            d = [cumsum(delta); vals(2,:)];
+        end
+        
         function isSupported = isErrorModeSupported(obj, errMode)
             % determines whether an error mode is currently supported
             isSupported = sum(ismember(obj.supportedErrorModes,errMode))>0;
@@ -249,6 +315,7 @@ classdef SpikeReader < handle
             obj.fileVersionMajor = 0;
             obj.fileVersionMinor = 2;
             obj.fileSizeByteHeader = -1; % to be set in openFile
+            obj.fileVersion = -1; % to be set in openFile
             
             obj.grid3D = -1; % to be set in openFile
             
@@ -313,6 +380,8 @@ classdef SpikeReader < handle
                 return
             end
             
+            obj.fileVersion = version;
+            
             % read Grid3D
             obj.grid3D = fread(obj.fileId, [1 3], 'int32');
             if feof(obj.fileId) || prod(obj.grid3D)<=0
@@ -4,6 +4,7 @@
 //#include <user_errors.h>		// fancy user error messages
 
 #include <stdio.h>				// fopen, fread, fclose
+#include <stdint.h>				// uint32_t
 #include <string.h>				// std::string
 #include <assert.h>				// assert
 
@@ -15,6 +16,7 @@ SpikeGeneratorFromFile::SpikeGeneratorFromFile(std::string fileName, int offsetT
 
 	nNeur_ = -1;
 	szByteHeader_ = -1;
+	fileVersion_ = -1.0f;
 	offsetTimeMs_ = offsetTimeMs;
 
 	// move unsafe operations out of constructor
@@ -64,13 +66,17 @@ void SpikeGeneratorFromFile::openFile() {
 	// needs to be updated every time header changes
 	FILE* fp = fpBegin_;
 	szByteHeader_ = 4*sizeof(int)+1*sizeof(float);
-	fseek(fp, sizeof(int)+sizeof(float), SEEK_SET); // skipping signature+version
+	fseek(fp, sizeof(int), SEEK_SET); // skipping signature
+
+	// version 0.3 and up use the compact format
+	size_t result = fread(&fileVersion_, sizeof(float), 1, fp);
+	UserErrors::assertTrue(result==1, UserErrors::FILE_CANNOT_OPEN, funcName, fileName_, " (missing header)");
 
 	// get number of neurons from header
 	nNeur_ = 1;
 	int grid;
 	for (int i=1; i<=3; i++) {
-		size_t result = fread(&grid, sizeof(int), 1, fp);
+		result = fread(&grid, sizeof(int), 1, fp);
 		nNeur_ *= grid;
 	}
 
@@ -93,14 +99,14 @@ void SpikeGeneratorFromFile::init() {
 	FILE* fp = fpBegin_;
 	fseek(fp, szByteHeader_, SEEK_SET); // skip header section
 
-	int tmpTime = -1;
-	int tmpNeurId = -1;
-	size_t result;
-
-	while (!feof(fp)) {
-		result = fread(&tmpTime, sizeof(int), 1, fp); // i-th time
-		result = fread(&tmpNeurId, sizeof(int), 1, fp); // i-th nid
-		spikes_[tmpNeurId].push_back(tmpTime); // add spike time to 2D vector
+	if (fileVersion_ >= 0.25f) {
+		readCompactSpikes();
+	} else {
+		int tmpAER[2];
+		while (fread(tmpAER, sizeof(int), 2, fp) == 2) { // i-th time and nid
+			assert(tmpAER[1]>=0 && tmpAER[1]<nNeur_);
+			spikes_[tmpAER[1]].push_back(tmpAER[0]); // add spike time to 2D vector
+		}
 	}
 
 #ifdef VERBOSE
@@ -117,6 +123,45 @@ void SpikeGeneratorFromFile::init() {
 	rewind(offsetTimeMs_);
 }
 
+// reads the body of a compact spike file: a sequence of blocks [numSpikes, numBytes, payload], where the payload holds
+// zig-zag encoded time differences and neuron IDs as variable-length integers (see SpikeMonitor::setFileFormat)
+void SpikeGeneratorFromFile::readCompactSpikes() {
+	FILE* fp = fpBegin_;
+	std::vector<unsigned char> payload;
+
+	int blockHeader[2];
+	while (fread(blockHeader, sizeof(int), 2, fp) == 2) {
+		int numSpikes = blockHeader[0];
+		int numBytes = blockHeader[1];
+		assert(numSpikes>=0 && numBytes>=0);
+
+		payload.resize(numBytes+1);
+		size_t result = fread(&payload[0], 1, numBytes, fp);
+		assert(result==(size_t)numBytes);
+
+		int pos = 0;
+		int time = 0;
+		for (int i=0; i<numSpikes; i++) {
+			uint32_t val[2] = {0, 0};
+			for (int j=0; j<2; j++) {
+				int shift = 0;
+				unsigned char byte;
+				do {
+					assert(pos<numBytes);
+					byte = payload[pos++];
+					val[j] |= (uint32_t)(byte & 0x7f) << shift;
+					shift += 7;
+				} while (byte & 0x80);
+			}
+
+			time += (int)(val[0] >> 1) ^ -(int)(val[0] & 1); // undo zig-zag
+			int neurId = (int)val[1];
+			assert(neurId>=0 && neurId<nNeur_);
+			spikes_[neurId].push_back(time);
+		}
+	}
+}
+
 unsigned int SpikeGeneratorFromFile::nextSpikeTime(CARLsim* sim, int grpId, int nid, unsigned int currentTime, 
 	unsigned int lastScheduledSpikeTime, unsigned int endOfTimeSlice) {
 	assert(nNeur_>0);
@@ -72,6 +72,8 @@ class CARLsim;
  * It is also possible to repeatedly parse the spike file, adding different offsetTimeMs offsets per loop.
  * This can be achieved by passing an optional argument to SpikeGeneratorFromFile::rewind.
  *
+ * Spike files in both the AER format and the compact format (see SpikeMonitor::setFileFormat) are supported.
+ *
  * Upon initialization, the class parses and buffers all spikes from the spike file in a format that allows for
  * more efficient scheduling. Note that this might take up a lot of memory if you have a large and highly active
  * neuron group.
@@ -184,10 +186,12 @@ public:
 private:
 	void openFile();
 	void init();
+	void readCompactSpikes();
 
 	std::string fileName_;		//!< file name
 	FILE* fpBegin_;				//!< pointer to beginning of file
 	int szByteHeader_;          //!< number of bytes in header section
+	float fileVersion_;         //!< version number of the spike file (0.3 and up: compact format)
                                 //!< \FIXME: there should be a standardized SpikeReader++ utility
 
 	//! A 2D vector of spike times, first dim=neuron ID, second dim=spike times.
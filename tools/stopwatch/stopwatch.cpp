@@ -23,6 +23,7 @@ public:
 	// +++++ PUBLIC METHODS +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ //
 
 	Impl(bool startTimer) {
+		_isTimerOn = false; // reset() refuses to reset a running timer
 		reset();
 		if (startTimer) {
 			start("start");